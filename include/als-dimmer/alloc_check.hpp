@@ -0,0 +1,34 @@
+#ifndef ALS_DIMMER_ALLOC_CHECK_HPP
+#define ALS_DIMMER_ALLOC_CHECK_HPP
+
+#include <cstdint>
+
+namespace als_dimmer {
+
+/**
+ * Heap allocation counting for the ALS_DIMMER_ALLOC_CHECK test build
+ *
+ * With -DALS_DIMMER_ALLOC_CHECK=ON, src/alloc_check.cpp replaces the global
+ * operator new/delete with versions that count allocations per thread, and
+ * the control loop aborts if a quiet iteration (no commands, no log line,
+ * CSV row, notifier script or state save) allocated anything. In normal
+ * builds ENABLED is false and threadAllocations() is a constant 0, so the
+ * checks compile away.
+ */
+namespace alloc_check {
+
+#ifdef ALS_DIMMER_ALLOC_CHECK
+constexpr bool ENABLED = true;
+
+// operator new calls made by the calling thread since it started
+uint64_t threadAllocations();
+#else
+constexpr bool ENABLED = false;
+
+inline uint64_t threadAllocations() { return 0; }
+#endif
+
+} // namespace alloc_check
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_ALLOC_CHECK_HPP
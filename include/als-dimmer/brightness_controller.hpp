@@ -24,7 +24,7 @@ public:
     struct TransitionInfo {
         int error;                  // target - current
         int step_size;              // step value used
-        std::string step_category;  // "large_up", "medium_down", "small_up", etc.
+        const char* step_category;  // "large_up", "medium_down", "small_up", etc. (static string)
         int step_threshold_large;   // large error threshold
         int step_threshold_small;   // small error threshold
         int next_brightness;        // calculated next value
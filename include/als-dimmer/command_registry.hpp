@@ -0,0 +1,277 @@
+#ifndef ALS_DIMMER_COMMAND_REGISTRY_HPP
+#define ALS_DIMMER_COMMAND_REGISTRY_HPP
+
+#include "json_protocol.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace als_dimmer {
+namespace protocol {
+
+/**
+ * Command registry - everything the daemon knows about a command, in one row
+ *
+ * COMMANDS below is the single place a command is declared: its wire name,
+ * CommandType, where it runs, whether queued copies coalesce, whether it
+ * may appear in a batch, the main loop's handler for it, and the schema of
+ * its parameters. parseCommand() looks names up through a perfect hash
+ * built from this table at compile time and checks params against the
+ * schema in the same pass, so handlers can read their parameters without
+ * checking them again.
+ *
+ * Adding a command is one row here plus its handler: a member of
+ * CommandHandlers for MAIN_LOOP and QUERY commands (implemented in
+ * main.cpp), the socket thread for CONNECTION ones. The compile-time checks
+ * at the bottom reject a table whose names no longer hash apart or whose
+ * handler column does not match the routes.
+ */
+
+enum class ParamType : uint8_t {
+    INTEGER,  // Give it a range within int
+    NUMBER,
+    STRING,
+    BOOLEAN,
+    ARRAY,
+    OBJECT
+};
+
+struct ParamSpec {
+    const char* name;  // nullptr ends the list
+    ParamType type;
+    bool required;
+    double min;  // INTEGER and NUMBER only
+    double max;
+};
+
+// Where a command runs
+enum class Route : uint8_t {
+    MAIN_LOOP,   // Queued for the control loop
+    QUERY,       // Read-only; the socket thread answers from the status snapshot
+    CONNECTION   // Per-connection state, handled by the socket thread
+};
+
+// What happens to a queued command when a newer one of the same type arrives
+enum class Coalesce : uint8_t {
+    NONE,         // Both run
+    LATEST_WINS,  // The older one is answered {"coalesced": true} and skipped
+    SUM_DELTA     // Same, with the older one's "delta" added to the newer one
+};
+
+/**
+ * What the main loop does with each command it dequeues
+ *
+ * The handler column of COMMANDS points at these, and the main loop calls
+ * (handlers.*spec->handler)(cmd, response). QUERY commands have one too:
+ * a query queued behind a write from the same client is answered there.
+ * The members are pure virtual so the table does not tie anything that
+ * links the registry to the daemon's state.
+ */
+class CommandHandlers {
+public:
+    virtual ~CommandHandlers() = default;
+
+    virtual void query(const ParsedCommand& cmd, Response& response) = 0;
+    virtual void setMode(const ParsedCommand& cmd, Response& response) = 0;
+    virtual void setBrightness(const ParsedCommand& cmd, Response& response) = 0;
+    virtual void adjustBrightness(const ParsedCommand& cmd, Response& response) = 0;
+    virtual void setAbsoluteBrightness(const ParsedCommand& cmd, Response& response) = 0;
+    virtual void getLoopStats(const ParsedCommand& cmd, Response& response) = 0;
+    virtual void getMetrics(const ParsedCommand& cmd, Response& response) = 0;
+    virtual void batch(const ParsedCommand& cmd, Response& response) = 0;
+};
+
+using Handler = void (CommandHandlers::*)(const ParsedCommand&, Response&);
+
+constexpr size_t MAX_PARAMS = 3;
+
+struct CommandSpec {
+    const char* name;
+    CommandType type;
+    Route route;
+    Coalesce coalesce;
+    bool batchable;
+    Handler handler;  // nullptr for CONNECTION commands
+    ParamSpec params[MAX_PARAMS];
+};
+
+// Thrown by validateParams(): the request is well-formed but its parameters
+// are not (answered with INVALID_PARAMS)
+class ParamError : public std::invalid_argument {
+public:
+    explicit ParamError(const std::string& what) : std::invalid_argument(what) {}
+};
+
+namespace registry_detail {
+constexpr double NO_MAX = std::numeric_limits<double>::infinity();
+} // namespace registry_detail
+
+constexpr CommandSpec COMMANDS[] = {
+    // name                       type                                  route               coalesce               batchable  handler
+    {"get_status",               CommandType::GET_STATUS,              Route::QUERY,      Coalesce::NONE,        true,  &CommandHandlers::query, {}},
+    {"get_config",               CommandType::GET_CONFIG,              Route::QUERY,      Coalesce::NONE,        true,  &CommandHandlers::query, {}},
+    {"get_absolute_brightness",  CommandType::GET_ABSOLUTE_BRIGHTNESS, Route::QUERY,      Coalesce::NONE,        true,  &CommandHandlers::query, {}},
+    {"get_calibration_info",     CommandType::GET_CALIBRATION_INFO,    Route::QUERY,      Coalesce::NONE,        true,  &CommandHandlers::query, {}},
+    {"set_mode",                 CommandType::SET_MODE,                Route::MAIN_LOOP,  Coalesce::LATEST_WINS, true,  &CommandHandlers::setMode,
+        {{"mode", ParamType::STRING, true, 0, 0}}},
+    {"set_brightness",           CommandType::SET_BRIGHTNESS,          Route::MAIN_LOOP,  Coalesce::LATEST_WINS, true,  &CommandHandlers::setBrightness,
+        {{"brightness", ParamType::INTEGER, true, 0, 100}}},
+    {"adjust_brightness",        CommandType::ADJUST_BRIGHTNESS,       Route::MAIN_LOOP,  Coalesce::SUM_DELTA,   true,  &CommandHandlers::adjustBrightness,
+        {{"delta", ParamType::INTEGER, true, -100, 100}}},
+    {"set_absolute_brightness",  CommandType::SET_ABSOLUTE_BRIGHTNESS, Route::MAIN_LOOP,  Coalesce::LATEST_WINS, true,  &CommandHandlers::setAbsoluteBrightness,
+        {{"nits", ParamType::NUMBER, true, 0, registry_detail::NO_MAX}}},
+    {"get_loop_stats",           CommandType::GET_LOOP_STATS,          Route::MAIN_LOOP,  Coalesce::NONE,        true,  &CommandHandlers::getLoopStats,
+        {{"reset", ParamType::BOOLEAN, false, 0, 0}}},
+    {"get_metrics",              CommandType::GET_METRICS,             Route::MAIN_LOOP,  Coalesce::NONE,        true,  &CommandHandlers::getMetrics,
+        {{"reset", ParamType::BOOLEAN, false, 0, 0}}},
+    {"batch",                    CommandType::BATCH,                   Route::MAIN_LOOP,  Coalesce::NONE,        false, &CommandHandlers::batch,
+        {{"commands", ParamType::ARRAY, true, 0, 0}}},
+    {"subscribe",                CommandType::SUBSCRIBE,               Route::CONNECTION, Coalesce::NONE,        false, nullptr,
+        {{"topics", ParamType::ARRAY, false, 0, 0},
+         {"min_interval_ms", ParamType::INTEGER, false, 0, 60000},
+         {"thresholds", ParamType::OBJECT, false, 0, 0}}},
+    {"unsubscribe",              CommandType::UNSUBSCRIBE,             Route::CONNECTION, Coalesce::NONE,        false, nullptr, {}},
+    {"hello",                    CommandType::HELLO,                   Route::CONNECTION, Coalesce::NONE,        false, nullptr,
+        {{"encoding", ParamType::STRING, false, 0, 0}}},
+};
+
+constexpr size_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+
+// Name lookup: a table of 2^HASH_BITS slots with no collisions, the seed
+// found by the compiler
+namespace registry_detail {
+
+constexpr unsigned HASH_BITS = 5;
+constexpr size_t HASH_SLOTS = size_t(1) << HASH_BITS;
+
+constexpr size_t length(const char* s) {
+    size_t n = 0;
+    while (s[n] != '\0') {
+        ++n;
+    }
+    return n;
+}
+
+// FNV-1a, with the seed folded into the offset basis
+constexpr uint32_t hash(const char* s, size_t len, uint32_t seed) {
+    uint32_t h = 2166136261u ^ seed;
+    for (size_t i = 0; i < len; ++i) {
+        h = (h ^ static_cast<uint8_t>(s[i])) * 16777619u;
+    }
+    return h;
+}
+
+// Top bits: FNV's low bits only depend on the low bits of the input
+constexpr size_t slotOf(const char* s, size_t len, uint32_t seed) {
+    return hash(s, len, seed) >> (32 - HASH_BITS);
+}
+
+constexpr bool isPerfect(uint32_t seed) {
+    bool used[HASH_SLOTS] = {};
+    for (size_t i = 0; i < COMMAND_COUNT; ++i) {
+        size_t slot = slotOf(COMMANDS[i].name, length(COMMANDS[i].name), seed);
+        if (used[slot]) {
+            return false;
+        }
+        used[slot] = true;
+    }
+    return true;
+}
+
+constexpr uint32_t findSeed() {
+    uint32_t seed = 0;
+    while (seed < 10000 && !isPerfect(seed)) {
+        ++seed;
+    }
+    return seed;
+}
+
+constexpr uint32_t HASH_SEED = findSeed();
+
+struct SlotTable {
+    int8_t index[HASH_SLOTS];  // Row in COMMANDS, -1 if empty
+};
+
+constexpr SlotTable buildSlots() {
+    SlotTable table = {};
+    for (size_t i = 0; i < HASH_SLOTS; ++i) {
+        table.index[i] = -1;
+    }
+    for (size_t i = 0; i < COMMAND_COUNT; ++i) {
+        table.index[slotOf(COMMANDS[i].name, length(COMMANDS[i].name), HASH_SEED)] =
+            static_cast<int8_t>(i);
+    }
+    return table;
+}
+
+constexpr SlotTable SLOTS = buildSlots();
+
+// Coalescing commands get consecutive slot numbers in table order
+constexpr int coalesceSlot(size_t row) {
+    int slot = 0;
+    for (size_t i = 0; i < row; ++i) {
+        if (COMMANDS[i].coalesce != Coalesce::NONE) {
+            ++slot;
+        }
+    }
+    return COMMANDS[row].coalesce != Coalesce::NONE ? slot : -1;
+}
+
+constexpr size_t countCoalescing() {
+    size_t n = 0;
+    for (size_t i = 0; i < COMMAND_COUNT; ++i) {
+        n += COMMANDS[i].coalesce != Coalesce::NONE ? 1 : 0;
+    }
+    return n;
+}
+
+constexpr bool typesUnique() {
+    for (size_t i = 0; i < COMMAND_COUNT; ++i) {
+        for (size_t j = i + 1; j < COMMAND_COUNT; ++j) {
+            if (COMMANDS[i].type == COMMANDS[j].type) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// The main loop handles everything but CONNECTION commands
+constexpr bool handlersMatchRoutes() {
+    for (size_t i = 0; i < COMMAND_COUNT; ++i) {
+        if ((COMMANDS[i].handler == nullptr) != (COMMANDS[i].route == Route::CONNECTION)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(COMMAND_COUNT * 2 <= HASH_SLOTS, "command table outgrew HASH_SLOTS; double it");
+static_assert(isPerfect(HASH_SEED), "no collision-free hash seed for the command names");
+static_assert(typesUnique(), "two commands share a CommandType");
+static_assert(handlersMatchRoutes(), "a command's handler does not match its route");
+
+} // namespace registry_detail
+
+// Number of distinct coalescing slots (one per coalescing command)
+constexpr size_t COALESCE_SLOT_COUNT = registry_detail::countCoalescing();
+
+// Row for a wire name, or nullptr if there is no such command
+const CommandSpec* findCommand(const char* name, size_t len);
+
+// Row for a type; nullptr for SHUTDOWN and UNKNOWN, which are not JSON commands
+const CommandSpec* commandSpec(CommandType type);
+
+// This command's coalescing slot, 0 .. COALESCE_SLOT_COUNT-1, or -1
+int coalesceSlot(const CommandSpec& spec);
+
+// Check `params` (the request's "params", an object) against the schema.
+// Throws ParamError naming the first offending parameter.
+void validateParams(const CommandSpec& spec, const json& params);
+
+} // namespace protocol
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_COMMAND_REGISTRY_HPP
@@ -101,6 +101,48 @@ struct UnixSocketConfig {
     std::string group = "root";
 };
 
+// Adaptive control tick. When enabled the main loop runs between
+// min_interval_ms (lux moving sharply, e.g. tunnel entry) and
+// max_interval_ms (lux and brightness error settled), with
+// update_interval_ms as the normal rate in between. Lux rates are the
+// low-pass filtered relative change of the reading, in percent per second.
+struct AdaptiveTickConfig {
+    bool enabled = false;
+    int min_interval_ms = 50;
+    int max_interval_ms = 2000;
+    float fast_lux_rate_percent = 50.0f;    // At/above this -> min_interval_ms
+    float steady_lux_rate_percent = 2.0f;   // At/below this counts as steady
+    int steady_error = 1;                   // |target - current| brightness counted as settled
+    int steady_time_sec = 10;               // Settled this long -> max_interval_ms
+};
+
+// Output ramp engine. When enabled, brightness changes are animated on a
+// dedicated thread at rate_hz, writing the output at its native resolution,
+// and converge in fade_up_ms / fade_down_ms whatever update_interval_ms is.
+// AUTO hands the zone target straight to the engine instead of stepping it
+// once per tick. Disabled = synchronous per-tick writes as before.
+struct RampConfig {
+    bool enabled = false;
+    int rate_hz = 100;
+    int fade_up_ms = 1000;
+    int fade_down_ms = 2000;   // Slower dimming, as with the step sizes
+    int manual_fade_ms = 250;  // set_brightness / adjust_brightness in MANUAL modes
+};
+
+// Real-time profile for the control loop and ramp threads: a SCHED_FIFO /
+// SCHED_RR priority, an optional CPU set, mlockall() and a prefaulted
+// stack. Socket, sensor and notifier work stays at normal priority. Each
+// setting needs privileges (CAP_SYS_NICE / RLIMIT_RTPRIO, CAP_IPC_LOCK /
+// RLIMIT_MEMLOCK); whatever can't be applied is logged and skipped.
+struct RealtimeConfig {
+    bool enabled = false;
+    std::string policy = "fifo";   // fifo | rr
+    int priority = 50;             // 1-99
+    std::vector<int> cpus;         // CPU numbers; empty = no pinning
+    bool lock_memory = true;       // mlockall(MCL_CURRENT | MCL_FUTURE)
+    int prefault_stack_kb = 256;   // Stack touched up front per thread (0 = skip)
+};
+
 struct ControlConfig {
     // Socket configuration
     TcpSocketConfig tcp_socket;
@@ -120,6 +162,14 @@ struct ControlConfig {
     int auto_resume_timeout_sec = 60;
     std::string log_level = "info";  // trace | debug | info | warn | error
     bool minimal_i2c = false;  // Skip sensor reads in MANUAL modes to reduce I2C traffic
+    int output_verify_interval_sec = 60;  // Read output brightness back from hardware (0 = on demand only)
+    int command_queue_depth = 64;  // Socket commands awaiting the control loop; more get QUEUE_FULL
+    std::string command_coalescing = "global";  // global | per_client | off
+    int max_line_bytes = 16384;  // Longest accepted protocol line; longer ones get LINE_TOO_LONG
+    std::string status_page;  // Shared-memory status file for local readers ("" = off)
+    AdaptiveTickConfig adaptive_tick;
+    RampConfig ramp;
+    RealtimeConfig realtime;
 };
 
 struct NotificationConfig {
@@ -3,7 +3,13 @@
 
 #include "state_manager.hpp"
 #include "config.hpp"
+#include "event_loop.hpp"
+#include "mpsc_ring.hpp"
+#include "json_protocol.hpp"
+#include "seqlock.hpp"
 #include <string>
+#include <chrono>
+#include <cstdint>
 #include <vector>
 #include <thread>
 #include <mutex>
@@ -11,15 +17,27 @@
 
 namespace als_dimmer {
 
+class BrightnessToNitsLut;
+class ThermalCompensation;
+
+// Control loop state published once per iteration (updateStatus()) so the
+// read-only queries can be answered without a trip through the main loop.
+// Plain data only: it is copied in and out of a SeqLock.
 struct SystemStatus {
-    OperatingMode mode;
-    float lux;
-    int target_brightness;
-    int current_brightness;
-    std::string zone;
-    bool sensor_healthy;
-    int manual_resume_in_sec;  // Time until auto-resume (for MANUAL_TEMPORARY)
-    int uptime_sec;
+    OperatingMode mode = OperatingMode::AUTO;
+    float lux = 0.0f;
+    int current_brightness = 0;
+    int manual_brightness = 0;
+    int last_auto_brightness = 0;
+    char zone[64] = {};
+    bool sensor_available = false;
+    double nits = 0.0;  // Thermal-corrected; meaningful only with a LUT loaded
+    bool thermal_has_reading = false;
+    double backlight_temp_c = 0.0;
+    double thermal_factor = 1.0;
+    int64_t output_cache_age_ms = -1;     // As of published_at (-1 = unknown)
+    int64_t output_verified_age_ms = -1;  // As of published_at (-1 = never)
+    std::chrono::steady_clock::time_point published_at;
 };
 
 enum class SocketType {
@@ -27,11 +45,18 @@ enum class SocketType {
     UNIX
 };
 
-// Returned by getNextCommand() so the caller can reply to the correct client
+// Opaque connection handle: connection-table slot in the low 32 bits, slot
+// generation in the high 32 bits, so a response for a client that has since
+// disconnected can never reach whoever reuses the slot. 0 is never valid.
+using ClientId = uint64_t;
+
+// Returned by nextCommand() so the caller can reply to the correct client.
+// The line was parsed once on the connection side; lines that failed to
+// parse were answered there and never reach the queue.
 struct QueuedCommand {
-    std::string command;
-    int client_fd = -1;
-    bool close_after_response = false;  // Caller should close FD after sending response
+    protocol::ParsedCommand command;
+    ClientId client_id = 0;
+    std::chrono::steady_clock::time_point enqueued_at;  // For command-latency reporting
 };
 
 class ControlInterface {
@@ -45,59 +70,219 @@ public:
     // Stop listening and close all connections
     void stop();
 
-    // Check if a command is available
-    bool hasCommand();
+    // Check if a command is available (main loop thread only; lock-free)
+    bool hasCommand() const { return !command_queue_.empty(); }
+
+    // Take the next command and its originating client; false when the
+    // queue is empty. The main loop calls this until it fails to drain
+    // everything queued since its last wakeup. Reusing the same `out`
+    // keeps its string buffer, so steady-state draining does not allocate.
+    bool nextCommand(QueuedCommand& out);
 
-    // Get next command with originating client FD
-    QueuedCommand getNextCommand();
+    // Readable (eventfd) whenever a command has been queued; register it with
+    // the main EventLoop and call consumeCommandEvent() when it fires.
+    int commandEventFd() const { return command_event_.fd(); }
+    void consumeCommandEvent() { command_event_.consume(); }
 
-    // Send response to a specific client
-    void sendResponseTo(int client_fd, const std::string& response);
+    // Send the response to a queued command back to its client, echoing the
+    // command's id. The text is written straight into the connection's
+    // reusable output buffer. Never blocks: whatever the socket does not
+    // take right away is buffered and flushed by the reactor thread.
+    void sendResponseTo(const QueuedCommand& request, const protocol::Response& response);
 
     // Broadcast message to all connected clients
     void broadcast(const std::string& message);
 
-    // Update system status (for GET_STATUS command)
+    // Calibration and output details the read-only queries report. Both
+    // objects must outlive the interface and not be reloaded; set before
+    // start().
+    void setCalibration(const BrightnessToNitsLut* lut, const ThermalCompensation* thermal,
+                        const std::string& output_type);
+
+    // Publish the control loop state (main loop thread only). Once a status
+    // has been published, get_status, get_config, get_absolute_brightness
+    // and get_calibration_info are answered by the reactor from it.
     void updateStatus(const SystemStatus& status);
 
+    // Is this a read-only query answerQuery() can handle?
+    static bool isQuery(protocol::CommandType type);
+
+    // Build the response to a read-only query from `status`
+    json answerQuery(protocol::CommandType type, const SystemStatus& status) const;
+
+    // Event topics a connection can subscribe to
+    enum Topic : uint32_t {
+        TOPIC_BRIGHTNESS,
+        TOPIC_MODE,
+        TOPIC_ZONE,
+        TOPIC_LUX,
+        TOPIC_THERMAL,
+        TOPIC_SENSOR,
+        TOPIC_COUNT
+    };
+
+    // The event pushed to subscribers for `topic`: as a message for the
+    // binary encodings, and as JSON text appended to `out` (the same bytes
+    // as makeEvent(...).dump(), without building it)
+    static json makeEvent(uint32_t topic, const SystemStatus& status, bool calibrated);
+    static void writeEvent(std::string& out, uint32_t topic, const SystemStatus& status,
+                           bool calibrated);
+
 private:
-    void acceptTcpClients();
-    void acceptUnixClients();
-    void handleClient(int client_fd, SocketType socket_type);
-    std::string processJsonCommand(const std::string& json_command);
+    // Upper bound on simultaneously connected clients; further connections
+    // are accepted and closed immediately.
+    static constexpr uint32_t MAX_CLIENTS = 32;
+    // A client that stops reading its responses is dropped once this much
+    // output is waiting for it.
+    static constexpr size_t MAX_PENDING_OUTPUT = 64 * 1024;
+
+    // A connection's `subscribe` state. Nothing is queued per event: the
+    // reactor compares the latest published status with what it last sent,
+    // so a subscriber that falls behind simply gets the current values once
+    // its socket drains.
+    struct Subscription {
+        uint32_t topics = 0;  // Bit per Topic; 0 = not subscribed
+        int min_interval_ms = 0;
+        float lux_threshold_percent = 10.0f;
+        int brightness_threshold = 1;
+        double thermal_threshold_c = 0.5;
+        bool primed = false;  // Initial values sent
+        SystemStatus sent;    // Values as last pushed
+        std::chrono::steady_clock::time_point sent_at[TOPIC_COUNT];
+    };
+
+    // One slot of the connection table. Slots (and their buffers' capacity)
+    // are reused, so memory stays flat however many clients come and go.
+    struct Connection {
+        int fd = -1;
+        SocketType socket_type = SocketType::TCP;
+        uint32_t generation = 0;
+        int pending = 0;           // Queued commands still owed a response
+        bool peer_closed = false;  // Peer shut down its write side
+        std::vector<char> rx;      // Receive buffer, max_line_bytes long
+        size_t rx_len = 0;         // Bytes of an incomplete line at rx[0]
+        bool rx_discarding = false;  // Skipping the rest of an over-long line
+        std::string tx;            // Bytes the socket has not accepted yet
+        std::string out;           // Scratch for building one message; keeps its capacity
+        protocol::Encoding encoding = protocol::Encoding::JSON;  // Set by `hello`
+        Subscription sub;
+    };
+
+    void reactorLoop();
+    void acceptClients(int server_fd, SocketType socket_type);
+    void readClient(Connection& conn);
+    void frameInput(Connection& conn, bool eof);
+    void frameLines(Connection& conn, bool eof);
+    void frameBinary(Connection& conn);
+    void flushClient(Connection& conn);
+    void queueOutput(Connection& conn, const char* data, size_t len);
+    void updateInterest(Connection& conn);
+    void closeClient(Connection& conn);
+    void finishIfDone(Connection& conn);
+    Connection* findClient(ClientId client_id);
+    ClientId clientIdOf(const Connection& conn) const;
+    void enqueueRequest(Connection& conn, const char* data, size_t len);
+    void answerSuperseded(ClientId client_id, const std::string& request_id,
+                          protocol::CommandType type);
+    void reply(Connection& conn, const std::string& msg, const std::string& request_id);
+    void sendMessage(Connection& conn, json& message, const std::string& request_id);
+    void sendStatus(Connection& conn, const SystemStatus& status, const std::string& request_id);
+    void sendEvent(Connection& conn, uint32_t topic, const SystemStatus& status, bool calibrated);
+    void hello(Connection& conn, const protocol::ParsedCommand& cmd);
+    void subscribe(Connection& conn, const protocol::ParsedCommand& cmd);
+    void unsubscribe(Connection& conn, const protocol::ParsedCommand& cmd);
+    void pushEvents();
+    void pushEvents(Connection& conn, const SystemStatus& status,
+                    std::chrono::steady_clock::time_point now);
+    void scheduleEvents(std::chrono::steady_clock::time_point deadline);
     bool createUnixSocket();
     bool setUnixSocketPermissions();
     void removeStaleUnixSocket();
 
     ControlConfig config_;
 
-    // TCP socket
     int tcp_server_fd_;
-    std::thread tcp_accept_thread_;
-
-    // Unix socket
     int unix_server_fd_;
-    std::thread unix_accept_thread_;
 
     std::atomic<bool> running_;
 
-    std::vector<std::thread> client_threads_;
-    std::vector<int> client_fds_;
+    // Reactor: one thread multiplexes both listeners and every client
+    EventLoop reactor_;
+    EventFd reactor_wake_;  // Signalled by stop()
+    EventFd status_event_;  // Signalled by updateStatus() while anyone is subscribed
+    TimerFd event_timer_;   // Fires when a min_interval_ms hold-off ends
+    std::chrono::steady_clock::time_point event_deadline_;  // Armed time, max() = none
+    std::atomic<int> subscribers_;
+    std::thread reactor_thread_;
+
+    std::vector<Connection> clients_;  // MAX_CLIENTS slots
     std::mutex clients_mutex_;
 
-    // Command queue
+    // Latest-value-wins bookkeeping for one coalescible command type.
+    // `latest` holds the sequence number of the newest queued entry of that
+    // type (always even); the main loop sets its low bit when it takes that
+    // entry. An entry whose sequence number is no longer `latest` was
+    // superseded and is skipped when dequeued. Whichever side wins the CAS
+    // on `latest` owns the entry.
+    //
+    // When that entry is the last one queued, a newer command replaces it
+    // in place instead (replaceNewest()): it is parked in `replacement`
+    // and the main loop runs it when it takes the entry, so a slider burst
+    // needs no cell per event and nothing queued after it is overtaken.
+    // Only this handoff takes a lock.
+    struct CoalesceSlot {
+        static constexpr uint64_t CONSUMED = 1;
+        std::atomic<uint64_t> latest{0};
+        ClientId latest_client = 0;  // Reactor thread only
+        std::string latest_id;       // Reactor thread only: request id of that entry
+        int pending_delta = 0;       // Reactor thread only (adjust_brightness)
+
+        // Held for a swap only: by the reactor to replace, by the main
+        // loop to claim the entry and pick up its replacement
+        std::mutex replace_mutex;
+        uint64_t replaced_seq = 0;  // Entry `replacement` stands in for
+        protocol::ParsedCommand replacement;
+        ClientId replacement_client = 0;
+        std::chrono::steady_clock::time_point replacement_at;
+    };
+
+    // Command queue: the reactor produces, the main loop consumes.
+    // Bounded by control.command_queue_depth live (not superseded) entries;
+    // a command that does not fit is answered with QUEUE_FULL instead of
+    // being queued.
     struct CommandEntry {
-        std::string command;
-        int client_fd;
-        SocketType socket_type;
-        bool close_after_response;  // FD should be closed after response is sent
+        protocol::ParsedCommand command;
+        ClientId client_id = 0;
+        CoalesceSlot* slot = nullptr;  // Set for coalescible commands
+        uint64_t coalesce_seq = 0;
+        std::chrono::steady_clock::time_point enqueued_at;
     };
-    std::vector<CommandEntry> command_queue_;
-    std::mutex queue_mutex_;
+    MpscRing<CommandEntry> command_queue_;
+    // Superseded entries still in command_queue_. Signed: the main loop
+    // may skip one before the reactor has counted it.
+    std::atomic<int64_t> superseded_queued_{0};
+    CommandEntry staging_;  // Reactor side: recycles buffers handed back by push()
+    // QUEUE_FULL warnings: at most one per QUEUE_FULL_LOG_INTERVAL, with
+    // the number rejected since the last one (reactor thread only)
+    std::chrono::steady_clock::time_point queue_full_logged_at_;
+    uint64_t queue_full_rejected_ = 0;
+    CommandEntry drained_;  // Main loop side: same for pop()
+
+    // Coalescing slots (control.command_coalescing), one per coalescible
+    // command type, either shared by all clients or one set per connection.
+    CoalesceSlot* coalesceSlotFor(const Connection& conn, const protocol::CommandSpec* spec);
+    bool replaceNewest(Connection& conn, bool accumulate);
+    std::vector<CoalesceSlot> coalesce_slots_;
+    uint64_t coalesce_seq_ = 0;  // Reactor thread only
+    uint64_t newest_seq_ = 0;    // Reactor thread only: coalesce_seq of the last push, 0 if none
+    std::string superseded_id_;  // Reactor thread only: scratch for replaceNewest()
+    EventFd command_event_;  // Wakes the main loop when command_queue_ grows
 
-    // System status
-    SystemStatus status_;
-    std::mutex status_mutex_;
+    // Published status and what the queries report alongside it
+    SeqLock<SystemStatus> status_;
+    const BrightnessToNitsLut* lut_ = nullptr;
+    const ThermalCompensation* thermal_ = nullptr;
+    std::string output_type_;
 };
 
 } // namespace als_dimmer
@@ -26,9 +26,9 @@ public:
         bool sensor_healthy;       // Sensor health status
 
         // Zone
-        std::string zone_name;     // Active zone (e.g., "indoor")
+        const char* zone_name;     // Active zone (e.g., "indoor")
         bool zone_changed;         // Flag: zone transition occurred
-        std::string curve;         // "linear" or "logarithmic"
+        const char* curve;         // "linear" or "logarithmic"
 
         // Brightness
         int target_brightness;     // Target from curve mapping
@@ -38,18 +38,18 @@ public:
 
         // Control
         int error;                 // target - current
-        std::string step_category; // "large_up", "medium_down", etc.
+        const char* step_category; // "large_up", "medium_down", etc.
         int step_size;             // Actual step value used
         int step_threshold_large;  // Zone's large threshold
         int step_threshold_small;  // Zone's small threshold
 
         // Mode
-        std::string mode;          // "AUTO", "MANUAL", etc.
+        const char* mode;          // "AUTO", "MANUAL", etc.
 
         // Manual override tracking (for ML analysis)
         bool manual_override_event;     // True if user manually adjusted brightness this iteration
         int auto_target_brightness;     // What AUTO mode would calculate (even in MANUAL mode)
-        std::string override_type;      // "set_brightness", "adjust_brightness", or empty
+        const char* override_type;      // "set_brightness", "adjust_brightness", or empty
         int hour_of_day;               // 0-23 for time-of-day patterns
         int day_of_week;               // 0-6 (0=Sunday) for weekly patterns
     };
@@ -0,0 +1,115 @@
+#ifndef ALS_DIMMER_EVENT_LOOP_HPP
+#define ALS_DIMMER_EVENT_LOOP_HPP
+
+#include <cstdint>
+
+namespace als_dimmer {
+
+/**
+ * EventLoop - thin wrapper around a Linux epoll set
+ *
+ * Each registered fd carries a caller-chosen 64-bit token which is handed
+ * back in wait(), so the caller can dispatch without a fd->handler map.
+ * Level-triggered; the caller is responsible for draining whatever made
+ * the fd ready (TimerFd::consume(), EventFd::consume(), a recv loop, ...).
+ */
+class EventLoop {
+public:
+    struct Event {
+        uint64_t token;
+        uint32_t events;  // EPOLLIN / EPOLLPRI / EPOLLERR / EPOLLHUP ...
+    };
+
+    EventLoop();
+    ~EventLoop();
+
+    // Owns an fd - not safe to copy.
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    /**
+     * Create the epoll instance
+     * @return true on success
+     */
+    bool init();
+
+    bool add(int fd, uint32_t events, uint64_t token);
+    bool modify(int fd, uint32_t events, uint64_t token);
+    void remove(int fd);
+
+    /**
+     * Block until at least one fd is ready or timeout_ms elapses
+     * (-1 = wait forever).
+     * @return number of events written to out, 0 on timeout, -1 on error.
+     *         EINTR (signal delivery) is reported as 0 so callers simply
+     *         re-check their exit flags.
+     */
+    int wait(Event* out, int max_events, int timeout_ms);
+
+private:
+    int epoll_fd_;
+};
+
+/**
+ * TimerFd - CLOCK_MONOTONIC timerfd
+ *
+ * A periodic timerfd keeps its own absolute schedule in the kernel, so the
+ * period does not stretch by however long the caller spent handling the
+ * previous expiration.
+ */
+class TimerFd {
+public:
+    TimerFd();
+    ~TimerFd();
+
+    TimerFd(const TimerFd&) = delete;
+    TimerFd& operator=(const TimerFd&) = delete;
+
+    bool init();
+    int fd() const { return fd_; }
+
+    // First expiration after interval_ms, then every interval_ms.
+    bool armPeriodic(int interval_ms);
+
+    // Single expiration after delay_ms (0 disarms, as with timerfd_settime).
+    bool armOneShot(int delay_ms);
+
+    bool disarm();
+
+    /**
+     * Read the expiration counter
+     * @return number of expirations since the last consume(), 0 if none
+     */
+    uint64_t consume();
+
+private:
+    int fd_;
+};
+
+/**
+ * EventFd - cross-thread wakeup counter
+ *
+ * signal() may be called from any thread; the owning loop registers fd()
+ * with its EventLoop and calls consume() when it becomes readable.
+ */
+class EventFd {
+public:
+    EventFd();
+    ~EventFd();
+
+    EventFd(const EventFd&) = delete;
+    EventFd& operator=(const EventFd&) = delete;
+
+    bool init();
+    int fd() const { return fd_; }
+
+    void signal();
+    uint64_t consume();
+
+private:
+    int fd_;
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_EVENT_LOOP_HPP
@@ -1,6 +1,8 @@
 #ifndef ALS_DIMMER_INTERFACES_HPP
 #define ALS_DIMMER_INTERFACES_HPP
 
+#include <sys/epoll.h>
+#include <cstdint>
 #include <string>
 
 namespace als_dimmer {
@@ -35,6 +37,23 @@ public:
      * @return sensor type string
      */
     virtual std::string getType() const = 0;
+
+    /**
+     * File descriptor that signals getPollEvents() when a new sample is
+     * available. Lets the sensor sampler thread pick up pushed samples as
+     * they arrive instead of waiting for its next timed read. readLux()
+     * must clear the readiness condition. May change after a failed read
+     * (the sensor reopened its device); the sampler re-registers it.
+     * @return fd, or -1 if the sensor can only be polled
+     */
+    virtual int getPollFd() const { return -1; }
+
+    /**
+     * epoll events on getPollFd() that mean "new sample". EPOLLIN for
+     * sockets; sysfs attributes are always readable, so sysfs_notify-capable
+     * ones use EPOLLPRI | EPOLLERR instead.
+     */
+    virtual uint32_t getPollEvents() const { return EPOLLIN; }
 };
 
 /**
@@ -69,6 +88,24 @@ public:
      */
     virtual std::string getType() const = 0;
 
+    /**
+     * Native resolution of the device: setNativeBrightness() accepts
+     * 0..getNativeMax(). Outputs with no scale finer than percent keep the
+     * default of 100, where native and percent are the same thing.
+     */
+    virtual int getNativeMax() const { return 100; }
+
+    /**
+     * Set brightness in native units (0..getNativeMax()), for callers that
+     * interpolate finer than 1% (the ramp engine). Implementations skip the
+     * write when the native value is unchanged; getCurrentBrightness()
+     * reports the nearest percent afterwards.
+     * @return true on success, false on failure
+     */
+    virtual bool setNativeBrightness(int native_value) {
+        return setBrightness(native_value);
+    }
+
     /**
      * Restore FPGA white-point registers when the output supports them.
      *
@@ -3,6 +3,8 @@
 
 #include <string>
 #include <memory>
+#include <vector>
+#include <cstdint>
 #include "json.hpp"
 
 namespace als_dimmer {
@@ -25,9 +27,26 @@ enum class CommandType {
     GET_ABSOLUTE_BRIGHTNESS,
     SET_ABSOLUTE_BRIGHTNESS,
     GET_CALIBRATION_INFO,
+    GET_LOOP_STATS,
+    GET_METRICS,
+    SUBSCRIBE,
+    UNSUBSCRIBE,
+    BATCH,
+    HELLO,
+    SHUTDOWN,  // Legacy plain-text "SHUTDOWN" line, not a JSON command
     UNKNOWN
 };
 
+// Wire encoding of a connection, chosen with the `hello` command. JSON is
+// newline-delimited text and the default. CBOR and MSGPACK carry the same
+// messages in binary, each in a frame with a 4-byte big-endian length
+// prefix.
+enum class Encoding {
+    JSON,
+    CBOR,
+    MSGPACK
+};
+
 // Response status
 enum class ResponseStatus {
     SUCCESS,
@@ -38,21 +57,58 @@ enum class ResponseStatus {
 
 // Parse incoming JSON command
 // Returns: CommandType and parsed parameters as JSON object
-// Throws: json::parse_error if invalid JSON
+// Throws: json::parse_error if invalid JSON,
+//         ParamError (command_registry.hpp) if params do not match the
+//         command's schema,
+//         std::invalid_argument if "id" is not a string or number, or a
+//         batch is malformed (not a list of known, batchable commands)
+struct CommandSpec;
+
 struct ParsedCommand {
-    CommandType type;
+    CommandType type = CommandType::UNKNOWN;
+    const CommandSpec* spec = nullptr;  // Registry row; nullptr for UNKNOWN and SHUTDOWN
     json params;
     std::string version;
+    std::string id;  // Client's "id", already serialized as JSON; empty if none
+    std::vector<ParsedCommand> batch;  // BATCH: the commands to run, in order
+    bool bare_batch = false;           // BATCH sent as a plain JSON array
 };
 
 ParsedCommand parseCommand(const std::string& json_str);
 
+// Same, parsing `len` bytes in place (e.g. a line inside a receive buffer)
+ParsedCommand parseCommand(const char* data, size_t len);
+
+// Same, decoding one frame payload of a binary-encoded connection
+ParsedCommand parseCommand(const char* data, size_t len, Encoding encoding);
+
+// Same, from an already decoded message
+ParsedCommand parseCommand(const json& message);
+
+// Same, filling `out` (whose buffers are reused). The request id is taken
+// before anything else is checked, so when this throws for bad params or
+// a malformed batch, out.id still holds it for the error response.
+void parseCommand(const char* data, size_t len, Encoding encoding, ParsedCommand& out);
+void parseCommand(const json& message, ParsedCommand& out);
+
+// Append `message` to `out` the way it goes on the wire: JSON text and a
+// newline, or a length-prefixed CBOR/MessagePack frame
+void encodeMessage(const json& message, Encoding encoding, std::string& out);
+
+// Length of a binary frame's length prefix
+constexpr size_t FRAME_HEADER_BYTES = 4;
+
 // Generate JSON response
 // Returns: JSON string ready to send to client
 std::string generateResponse(ResponseStatus status,
                             const std::string& message,
                             const json& data = json::object());
 
+// The same responses as unserialized messages, for encodeMessage()
+json makeResponse(ResponseStatus status, const std::string& message,
+                  const json& data = json::object());
+json makeErrorResponse(const std::string& error_message, const std::string& error_code = "");
+
 // Generate status response (for GET_STATUS command)
 // sensor_status:    "available" or "unavailable" - lets clients grey out the AUTO toggle.
 // calibrated:       true if a brightness->nits LUT is loaded; when false, `nits`
@@ -67,6 +123,9 @@ std::string generateResponse(ResponseStatus status,
 //                      clients can distinguish "no live data" from "data shows 1.0".
 // backlight_temp_c:    most recent successful temperature reading (degC).
 // thermal_factor:      the correction currently being applied to LUT-predicted nits.
+// output_cache_age_ms:    ms since `brightness` was last written to or read back from
+//                         the output (-1 = unknown, emitted as null).
+// output_verified_age_ms: ms since the last hardware readback (-1 = never, null).
 std::string generateStatusResponse(const std::string& mode,
                                    int current_brightness,
                                    float current_lux,
@@ -77,7 +136,23 @@ std::string generateStatusResponse(const std::string& mode,
                                    bool thermal_enabled = false,
                                    bool thermal_has_reading = false,
                                    double backlight_temp_c = 0.0,
-                                   double thermal_factor = 1.0);
+                                   double thermal_factor = 1.0,
+                                   int64_t output_cache_age_ms = -1,
+                                   int64_t output_verified_age_ms = -1);
+
+json makeStatusResponse(const std::string& mode,
+                        int current_brightness,
+                        float current_lux,
+                        const std::string& current_zone,
+                        const std::string& sensor_status = "available",
+                        bool calibrated = false,
+                        double nits = 0.0,
+                        bool thermal_enabled = false,
+                        bool thermal_has_reading = false,
+                        double backlight_temp_c = 0.0,
+                        double thermal_factor = 1.0,
+                        int64_t output_cache_age_ms = -1,
+                        int64_t output_verified_age_ms = -1);
 
 // Generate config response (for GET_CONFIG command)
 std::string generateConfigResponse(const json& config_data);
@@ -86,8 +161,110 @@ std::string generateConfigResponse(const json& config_data);
 std::string generateErrorResponse(const std::string& error_message,
                                  const std::string& error_code = "");
 
+// Echo a request id (ParsedCommand::id) as the first member of `response`,
+// a serialized JSON object. No-op when `id` is empty, so clients that send
+// no id get exactly the responses they always did.
+void addRequestId(std::string& response, const std::string& id);
+
+// Same result appended to `out`, leaving `response` alone
+void appendWithRequestId(std::string& out, const std::string& response, const std::string& id);
+
+/**
+ * JsonWriter - append JSON text to a caller-owned buffer, without a DOM
+ *
+ * For the messages sent often enough that building a json object for each
+ * one shows up (status responses, brightness acknowledgements, events).
+ * Output is byte-for-byte what json::dump() gives for the same object, as
+ * long as the caller adds members in sorted key order, which is the order
+ * nlohmann keeps them in. Numbers are formatted the way dump() formats
+ * them: integers exactly, doubles with the shortest text that round-trips
+ * ("3000.0", "0.10000000149011612"), non-finite doubles as null. Strings
+ * must be valid UTF-8. Once `out` has grown to the message size, writing
+ * into it again after clear() never allocates.
+ */
+class JsonWriter {
+public:
+    explicit JsonWriter(std::string& out) : out_(out), need_comma_(false) {}
+
+    JsonWriter& beginObject();
+    JsonWriter& endObject();
+    JsonWriter& key(const char* name);
+
+    JsonWriter& value(const char* s);
+    JsonWriter& value(const std::string& s) { return value(s.c_str()); }
+    JsonWriter& value(bool b);
+    JsonWriter& value(int n) { return value(static_cast<int64_t>(n)); }
+    JsonWriter& value(int64_t n);
+    JsonWriter& value(double d);
+    JsonWriter& null();
+    JsonWriter& raw(const std::string& json_text);  // An already serialized value
+
+private:
+    std::string& out_;
+    bool need_comma_;
+};
+
+// JsonWriter versions of the hot responses. Each appends exactly what the
+// DOM path (makeXxx(...).dump(), then addRequestId(id)) produces, without
+// the trailing newline.
+
+// Same fields as makeStatusResponse()
+void writeStatusResponse(std::string& out, const std::string& id,
+                         const char* mode,
+                         int current_brightness,
+                         float current_lux,
+                         const char* current_zone,
+                         const char* sensor_status,
+                         bool calibrated,
+                         double nits,
+                         bool thermal_enabled,
+                         bool thermal_has_reading,
+                         double backlight_temp_c,
+                         double thermal_factor,
+                         int64_t output_cache_age_ms,
+                         int64_t output_verified_age_ms);
+
+// set_brightness acknowledgement
+void writeBrightnessResponse(std::string& out, const std::string& id, int brightness);
+
+// adjust_brightness acknowledgement
+void writeAdjustResponse(std::string& out, const std::string& id, int brightness, int delta);
+
+// Answer to a command that a newer one of the same type replaced in the queue
+void writeCoalescedResponse(std::string& out, const std::string& id, CommandType type);
+
+// batch command response; `results` is the already serialized JSON array
+// of the entries' responses, `errors` how many of them failed
+void writeBatchResponse(std::string& out, const std::string& id, const std::string& results,
+                        int errors);
+
+// A command's response as the main loop hands it to the control
+// interface. The frequent acknowledgements travel as values and are written
+// (with the request's id) straight into the connection's output buffer;
+// anything else is complete JSON text.
+struct Response {
+    enum class Kind : uint8_t {
+        TEXT,                // `text`
+        BRIGHTNESS_SET,      // set_brightness ack: `brightness`
+        BRIGHTNESS_ADJUSTED  // adjust_brightness ack: `brightness`, `delta`
+    };
+    Kind kind = Kind::TEXT;
+    int brightness = 0;
+    int delta = 0;
+    std::string text;  // Reused from command to command, so it keeps its capacity
+};
+
+// Append `response` as JSON text with `id` as its first member, the same
+// bytes as the DOM path
+void writeResponse(std::string& out, const std::string& id, const Response& response);
+
 // Helper to convert CommandType to string
 std::string commandTypeToString(CommandType type);
+const char* commandTypeName(CommandType type);  // Same, without a string copy
+
+// Encoding names as used by `hello` ("json", "cbor", "msgpack")
+bool stringToEncoding(const std::string& name, Encoding& out);
+std::string encodingToString(Encoding encoding);
 
 // Helper to convert ResponseStatus to string
 std::string responseStatusToString(ResponseStatus status);
@@ -7,6 +7,8 @@
 #include <ctime>
 #include <iomanip>
 #include <mutex>
+#include <atomic>
+#include <cstdint>
 
 namespace als_dimmer {
 
@@ -43,12 +45,18 @@ public:
         return level >= current_level_;
     }
 
+    // Number of lines written so far (all threads)
+    uint64_t linesLogged() const {
+        return lines_logged_.load(std::memory_order_relaxed);
+    }
+
     void log(LogLevel level, const std::string& component, const std::string& message) {
         if (!shouldLog(level)) {
             return;
         }
 
         std::lock_guard<std::mutex> lock(mutex_);
+        lines_logged_.fetch_add(1, std::memory_order_relaxed);
 
         // Get timestamp
         auto now = std::time(nullptr);
@@ -99,6 +107,7 @@ private:
 
     LogLevel current_level_;
     std::mutex mutex_;
+    std::atomic<uint64_t> lines_logged_{0};
 };
 
 } // namespace als_dimmer
@@ -0,0 +1,95 @@
+#ifndef ALS_DIMMER_LOOP_STATS_HPP
+#define ALS_DIMMER_LOOP_STATS_HPP
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace als_dimmer {
+
+/**
+ * LoopStats - control loop timing: period jitter and overrun accounting
+ *
+ * The tick timerfd keeps an absolute schedule in the kernel, so the period
+ * doesn't drift with the work done per iteration; this records how well
+ * that schedule is actually met:
+ * - period: time between consecutive tick wakeups, and jitter as the
+ *   deviation from the nominal interval, over the last WINDOW ticks
+ *   (min/avg/max/p99)
+ * - missed ticks: timer expirations that coalesced because the loop was
+ *   still busy when the next deadline passed
+ * - overruns: control steps whose work exceeded the tick interval
+ *
+ * Fixed-size, no allocation; owned and used by the main loop thread only.
+ */
+class LoopStats {
+public:
+    static constexpr size_t WINDOW = 1024;
+
+    struct Summary {
+        int interval_ms;          // nominal interval at the last tick
+        size_t samples;           // periods in the window
+        int64_t period_min_us;
+        int64_t period_avg_us;
+        int64_t period_max_us;
+        int64_t period_p99_us;
+        int64_t jitter_avg_us;    // |period - nominal|
+        int64_t jitter_max_us;
+        int64_t jitter_p99_us;
+        uint64_t ticks;           // since reset
+        uint64_t missed_ticks;
+        uint64_t steps;           // control steps (ticks + command/sensor-triggered)
+        uint64_t overruns;
+        int64_t work_avg_us;
+        int64_t work_max_us;
+        int64_t since_reset_ms;
+    };
+
+    LoopStats();
+
+    /**
+     * Record a tick wakeup
+     * @param now Wakeup time
+     * @param interval_ms Nominal tick interval in effect
+     * @param expirations Timer expirations read (>1 = ticks were missed)
+     */
+    void onTick(std::chrono::steady_clock::time_point now, int interval_ms, uint64_t expirations);
+
+    // The timer was re-armed: the next wakeup doesn't close a full period
+    void onScheduleChange();
+
+    /**
+     * Record one control step
+     * @param started When the step began
+     * @param finished When it completed
+     * @param budget_ms Tick interval the step has to fit in
+     */
+    void onStep(std::chrono::steady_clock::time_point started,
+                std::chrono::steady_clock::time_point finished,
+                int budget_ms);
+
+    Summary summarize() const;
+    void reset();
+
+private:
+    int32_t periods_us_[WINDOW];
+    int32_t jitter_us_[WINDOW];
+    size_t next_;
+    size_t count_;
+
+    int interval_ms_;
+    bool have_last_tick_;
+    std::chrono::steady_clock::time_point last_tick_;
+    std::chrono::steady_clock::time_point reset_time_;
+
+    uint64_t ticks_;
+    uint64_t missed_ticks_;
+    uint64_t steps_;
+    uint64_t overruns_;
+    int64_t work_sum_us_;
+    int64_t work_max_us_;
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_LOOP_STATS_HPP
@@ -0,0 +1,146 @@
+#ifndef ALS_DIMMER_METRICS_HPP
+#define ALS_DIMMER_METRICS_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace als_dimmer {
+
+/**
+ * LatencyHistogram - fixed-bucket log-scale latency histogram (microseconds)
+ *
+ * 4 linear sub-buckets per power of two, so any percentile read back is
+ * within 25% of the true value; 0-3 us are exact. Buckets are relaxed
+ * atomics: record() is lock-free, allocation-free and safe from any thread
+ * (the sensor sampler and ramp engine record from their own threads).
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t BUCKETS = 128;
+
+    LatencyHistogram();
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void record(uint64_t us);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t maxUs() const { return max_us_.load(std::memory_order_relaxed); }
+    uint64_t sumUs() const { return sum_us_.load(std::memory_order_relaxed); }
+
+    /**
+     * Latency at or below which `percent` of the samples fall, reported as
+     * the upper edge of the bucket that holds it (capped at maxUs()).
+     * @return 0 when there are no samples
+     */
+    uint64_t percentileUs(double percent) const;
+
+    void reset();
+
+private:
+    static size_t bucketFor(uint64_t us);
+    static uint64_t bucketUpperUs(size_t index);
+
+    std::atomic<uint64_t> buckets_[BUCKETS];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sum_us_;
+    std::atomic<uint64_t> max_us_;
+};
+
+/**
+ * Control-loop stages timed into Metrics
+ */
+enum class Stage {
+    COMMAND_DRAIN,   // handling all queued commands in one wakeup
+    SENSOR_READ,     // SensorInterface::readLux (sampler thread)
+    ZONE_MAP,        // ZoneMapper lux -> target
+    CONTROLLER,      // BrightnessController step calculation
+    OUTPUT_WRITE,    // OutputInterface::setBrightness / setNativeBrightness
+    CSV_LOG,         // CSVLogger::logIteration
+    NOTIFIER,        // Notifier emits (fork/exec when they fire)
+    STATE_SAVE,      // StateManager::save
+    COUNT
+};
+
+/**
+ * Which device a bus transaction belongs to
+ */
+enum class BusDevice {
+    SENSOR,
+    OUTPUT,
+    COUNT
+};
+
+/**
+ * Metrics - process-wide stage histograms and bus transaction counters,
+ * reported by the get_metrics command
+ *
+ * A "transaction" is one logical device access the daemon issues: an I2C
+ * register write or write+read pair, a sysfs attribute read/write, a DDC/CI
+ * VCP get/set. Counters are relaxed atomics and safe from any thread.
+ */
+class Metrics {
+public:
+    static Metrics& getInstance() {
+        static Metrics instance;
+        return instance;
+    }
+
+    LatencyHistogram& stage(Stage s) { return stages_[static_cast<size_t>(s)]; }
+
+    void countTransaction(BusDevice device, bool ok) {
+        size_t i = static_cast<size_t>(device);
+        transactions_[i].fetch_add(1, std::memory_order_relaxed);
+        if (!ok) {
+            errors_[i].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t transactions(BusDevice device) const {
+        return transactions_[static_cast<size_t>(device)].load(std::memory_order_relaxed);
+    }
+    uint64_t errors(BusDevice device) const {
+        return errors_[static_cast<size_t>(device)].load(std::memory_order_relaxed);
+    }
+
+    // Clear histograms and counters (get_metrics {"reset": true})
+    void reset();
+
+    static const char* stageName(Stage s);
+
+private:
+    Metrics();
+
+    LatencyHistogram stages_[static_cast<size_t>(Stage::COUNT)];
+    std::atomic<uint64_t> transactions_[static_cast<size_t>(BusDevice::COUNT)];
+    std::atomic<uint64_t> errors_[static_cast<size_t>(BusDevice::COUNT)];
+};
+
+/**
+ * Times its own scope into a Metrics stage histogram
+ */
+class ScopedStageTimer {
+public:
+    explicit ScopedStageTimer(Stage stage)
+        : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedStageTimer() {
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_).count();
+        Metrics::getInstance().stage(stage_).record(static_cast<uint64_t>(us < 0 ? 0 : us));
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    Stage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_METRICS_HPP
@@ -0,0 +1,117 @@
+#ifndef ALS_DIMMER_MPSC_RING_HPP
+#define ALS_DIMMER_MPSC_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace als_dimmer {
+
+/**
+ * MpscRing - bounded multi-producer/single-consumer ring buffer
+ *
+ * Lock-free: every cell carries a sequence number that tells producers
+ * whether it is free for position pos (seq == pos) and the consumer
+ * whether it has been filled (seq == pos + 1), so producers only contend
+ * on one CAS of the enqueue counter and the consumer never touches it.
+ * Capacity is fixed at construction (rounded up to a power of two) and
+ * the cells are allocated once; push() fails when the ring is full.
+ *
+ * Elements are exchanged with swap() rather than copied: the caller gets
+ * the cell's previous contents back, so types like std::string keep
+ * circulating their buffers instead of allocating per element.
+ */
+template <typename T>
+class MpscRing {
+public:
+    explicit MpscRing(size_t min_capacity)
+        : cells_(roundUp(min_capacity)), mask_(cells_.size() - 1),
+          enqueue_pos_(0), dequeue_pos_(0) {
+        for (size_t i = 0; i < cells_.size(); ++i) {
+            cells_[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(const MpscRing&) = delete;
+    MpscRing& operator=(const MpscRing&) = delete;
+
+    // Producer side, any thread. value is swapped with the cell's old contents.
+    bool push(T& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & mask_];
+            size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;  // Consumer has not freed this cell yet: full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        using std::swap;
+        swap(cell->value, value);
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, one thread only. out is swapped with the cell's contents.
+    bool pop(T& out) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell& cell = cells_[pos & mask_];
+        if (cell.seq.load(std::memory_order_acquire) != pos + 1) {
+            return false;
+        }
+        using std::swap;
+        swap(cell.value, out);
+        cell.seq.store(pos + mask_ + 1, std::memory_order_release);
+        dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Consumer side: true when pop() would fail right now
+    bool empty() const {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        return cells_[pos & mask_].seq.load(std::memory_order_acquire) != pos + 1;
+    }
+
+    // Approximate when called concurrently with push/pop. With a single
+    // producer thread, size() < capacity() guarantees that thread's next
+    // push() succeeds (the consumer only ever frees cells).
+    size_t size() const {
+        return enqueue_pos_.load(std::memory_order_acquire) -
+               dequeue_pos_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return cells_.size(); }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    static size_t roundUp(size_t n) {
+        size_t cap = 2;
+        while (cap < n) {
+            cap <<= 1;
+        }
+        return cap;
+    }
+
+    std::vector<Cell> cells_;
+    const size_t mask_;
+    // Separate cache lines so producers and the consumer don't false-share
+    alignas(64) std::atomic<size_t> enqueue_pos_;
+    alignas(64) std::atomic<size_t> dequeue_pos_;
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_MPSC_RING_HPP
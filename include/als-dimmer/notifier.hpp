@@ -4,6 +4,7 @@
 #include "config.hpp"
 #include <string>
 #include <chrono>
+#include <cstdint>
 
 namespace als_dimmer {
 
@@ -15,7 +16,10 @@ public:
     // brightness_changed is additionally rate-limited to ~1/second.
     void emitModeChanged(const std::string& mode);
     void emitBrightnessChanged(int brightness);
-    void emitZoneChanged(const std::string& zone);
+    void emitZoneChanged(const char* zone);
+
+    // Number of times the on-change script has been launched
+    uint64_t invocations() const { return invocations_; }
 
 private:
     void invokeScript(const std::string& event_type, const std::string& value);
@@ -27,6 +31,7 @@ private:
     std::string last_mode_;
     int last_brightness_ = -1;
     std::string last_zone_;
+    uint64_t invocations_ = 0;
 
     // Rate limiting for brightness_changed
     std::chrono::steady_clock::time_point last_brightness_emit_time_;
@@ -0,0 +1,87 @@
+#ifndef ALS_DIMMER_OUTPUT_CACHE_HPP
+#define ALS_DIMMER_OUTPUT_CACHE_HPP
+
+#include "interfaces.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+namespace als_dimmer {
+
+/**
+ * CachedOutput - output-state cache wrapped around every OutputInterface
+ *
+ * getCurrentBrightness() answers from the last written value instead of
+ * asking the device, which for DDC/CI is a VCP 0x10 read costing tens of
+ * milliseconds on the bus. The hardware is read back only:
+ * - once at init(), to seed the cache
+ * - every verify_interval_sec (0 = never on a schedule), to pick up changes
+ *   made behind the daemon's back (monitor OSD buttons)
+ * - on demand: after a failed write, or when requestVerify() was called
+ *
+ * setBrightness() with the percentage the cache already holds (from a
+ * setBrightness() or a readback, not a rounded native frame) is a no-op (no
+ * bus traffic, and no allocation for outputs that open a file per write).
+ * A verify that finds the device changed updates the cache, so the next
+ * setBrightness() re-asserts the wanted value.
+ *
+ * Reads and writes must come from one thread at a time (whoever owns the
+ * output - the control loop or the ramp engine); the age accessors are
+ * safe from any thread.
+ */
+class CachedOutput : public OutputInterface {
+public:
+    CachedOutput(std::unique_ptr<OutputInterface> inner, int verify_interval_sec);
+
+    bool init() override;
+    bool setBrightness(int brightness) override;
+    int getCurrentBrightness() override;
+    std::string getType() const override { return inner_->getType(); }
+    int getNativeMax() const override { return inner_->getNativeMax(); }
+    bool setNativeBrightness(int native_value) override;
+    bool setWhitePoint(int wpx, int wpy, int wpz) override {
+        return inner_->setWhitePoint(wpx, wpy, wpz);
+    }
+
+    /**
+     * Read the brightness back from hardware now and refresh the cache
+     * @return brightness, or the cached value if the readback failed
+     */
+    int verify();
+
+    // Make the next getCurrentBrightness() read back from hardware.
+    // Thread-safe.
+    void requestVerify() { verify_requested_.store(true); }
+
+    // Milliseconds until the next readback is due: 0 if it is due now,
+    // -1 if none is scheduled. Thread-safe.
+    int64_t msUntilVerify() const;
+    bool verifyDue() const { return msUntilVerify() == 0; }
+
+    // Milliseconds since the cached value was last written or read back
+    int64_t cacheAgeMs() const;
+
+    // Milliseconds since the last hardware readback, -1 if none succeeded
+    int64_t verifiedAgeMs() const;
+
+    int verifyIntervalSec() const { return verify_interval_sec_; }
+
+private:
+    static int64_t nowNs();
+    void markFresh(int64_t now_ns) { last_update_ns_.store(now_ns); }
+
+    std::unique_ptr<OutputInterface> inner_;
+    int verify_interval_sec_;
+
+    std::atomic<int> cached_{0};
+    std::atomic<int64_t> last_update_ns_{0};   // write or readback
+    std::atomic<int64_t> last_verify_ns_{-1};  // successful readback, -1 = never
+    std::atomic<int64_t> last_attempt_ns_{-1}; // readback attempt (drives the schedule)
+    std::atomic<bool> verify_requested_{false};
+    std::atomic<bool> cache_exact_{false};     // cached_ is what setBrightness(cached_) would write
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_OUTPUT_CACHE_HPP
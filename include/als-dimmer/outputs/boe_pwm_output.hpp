@@ -57,6 +57,7 @@ private:
     bool setupPwm();
     bool loadResponseCurve();
     bool writeSysfs(const std::string& path, const std::string& value);
+    bool writeDutyCycle(int duty_ns);
 
     int dutyPctToNs(double duty_pct) const;
     double brightnessToDutyPct(int brightness) const;
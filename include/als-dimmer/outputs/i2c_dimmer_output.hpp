@@ -42,6 +42,8 @@ public:
     bool setBrightness(int brightness) override;
     int getCurrentBrightness() override;
     std::string getType() const override;
+    int getNativeMax() const override { return max_native_brightness_; }
+    bool setNativeBrightness(int native_value) override;
     bool setWhitePoint(int wpx, int wpy, int wpz) override;
 
 private:
@@ -54,6 +56,7 @@ private:
     DimmerType type_;
     int fd_;
     int current_brightness_;  // Cached brightness (0-100)
+    int current_native_;      // Cached native value last written
     int max_native_brightness_;  // 200, 800, or 2048
     uint8_t command_byte_;  // 0x28 or 0x35
 
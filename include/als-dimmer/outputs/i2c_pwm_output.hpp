@@ -54,6 +54,8 @@ public:
     bool init() override;
     bool setBrightness(int brightness) override;
     int getCurrentBrightness() override;
+    int getNativeMax() const override { return max_value_; }
+    bool setNativeBrightness(int native_value) override;
     std::string getType() const override;
 
 private:
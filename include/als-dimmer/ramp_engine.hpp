@@ -0,0 +1,127 @@
+#ifndef ALS_DIMMER_RAMP_ENGINE_HPP
+#define ALS_DIMMER_RAMP_ENGINE_HPP
+
+#include "config.hpp"
+#include "event_loop.hpp"
+#include "interfaces.hpp"
+#include "realtime.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+namespace als_dimmer {
+
+/**
+ * RampEngine - output animation decoupled from the control tick
+ *
+ * The control loop sets a target; the engine interpolates linearly from the
+ * current position to it over the fade time, on its own thread and timerfd
+ * at rate_hz, and writes the output at native resolution (a 0-2048 dimmer
+ * gets ~20 distinct levels per percent). Frames whose native value didn't
+ * change are not written, and the timer is disarmed when idle, so a
+ * settled display costs no wakeups.
+ *
+ * Re-targeting mid-fade continues from the current position; setting the
+ * same target again doesn't restart the fade.
+ *
+ * When ramp.enabled is false the engine is a pass-through: setTarget()
+ * writes immediately on the caller's thread, exactly like calling
+ * OutputInterface::setBrightness(). While started, the output is used
+ * exclusively by the engine thread.
+ */
+class RampEngine {
+public:
+    RampEngine(OutputInterface& output, const RampConfig& config);
+    ~RampEngine();
+
+    // Manages a thread - not safe to copy/move.
+    RampEngine(const RampEngine&) = delete;
+    RampEngine& operator=(const RampEngine&) = delete;
+
+    /**
+     * Spawn the animation thread (no-op when disabled)
+     * @param realtime Applied by the thread to itself before the first
+     *                 frame (nullptr = default scheduling). Must outlive stop().
+     * @return true on success
+     */
+    bool start(const RealtimeProfile* realtime = nullptr);
+
+    /**
+     * Signal the animation thread to exit and join it. The output is left
+     * wherever the current fade got to. Idempotent.
+     */
+    void stop();
+
+    bool enabled() const { return config_.enabled; }
+
+    /**
+     * Move the output to brightness (0-100) using fade_up_ms or
+     * fade_down_ms depending on direction
+     * @return false only when a pass-through write failed
+     */
+    bool setTarget(int brightness);
+
+    // Same, with an explicit fade time (0 = jump)
+    bool setTarget(int brightness, int fade_ms);
+
+    /**
+     * Read the output back (an OutputInterface::getCurrentBrightness(),
+     * which CachedOutput turns into a hardware readback when one is due)
+     * and write the target again if the device no longer shows it, e.g.
+     * after a change from the monitor's own buttons. Skipped mid-fade.
+     * Ramp mode: done on the engine thread; pass-through: right here.
+     */
+    void resync();
+
+    /**
+     * Brightness currently on the output (nearest percent). Safe to call
+     * from any thread; pass-through mode asks the output directly.
+     */
+    int currentBrightness() const;
+
+    // Frames written vs. skipped because the native value was unchanged
+    uint64_t framesWritten() const { return frames_written_.load(std::memory_order_relaxed); }
+    uint64_t framesSkipped() const { return frames_skipped_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void resyncOutput();
+
+    // Advance the fade to `now` and write if needed.
+    // @return true while the fade is still in progress
+    bool frame(std::chrono::steady_clock::time_point now);
+
+    OutputInterface& output_;
+    RampConfig config_;
+    int native_max_;
+
+    EventLoop loop_;
+    TimerFd frame_timer_;
+    EventFd wake_;
+
+    std::thread thread_;
+    const RealtimeProfile* realtime_ = nullptr;
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<bool> resync_requested_{false};
+    bool started_ = false;
+
+    // Fade state - protected by mu_
+    std::mutex mu_;
+    float start_pos_;     // percent, at fade_start_
+    float position_;      // percent, as of the last frame
+    int target_;          // also kept in pass-through mode, for resync()
+    int fade_ms_;
+    std::chrono::steady_clock::time_point fade_start_;
+    bool fading_;
+
+    int last_native_;     // engine thread only
+    std::atomic<int> current_brightness_;
+    std::atomic<uint64_t> frames_written_{0};
+    std::atomic<uint64_t> frames_skipped_{0};
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_RAMP_ENGINE_HPP
@@ -0,0 +1,58 @@
+#ifndef ALS_DIMMER_REALTIME_HPP
+#define ALS_DIMMER_REALTIME_HPP
+
+#include "config.hpp"
+#include <atomic>
+#include <string>
+
+namespace als_dimmer {
+
+/**
+ * RealtimeProfile - applies control.realtime to the threads that run the
+ * brightness path (the control loop and the ramp engine)
+ *
+ * Everything is best effort: each setting is tried on its own, its outcome
+ * logged, and a missing capability only costs that setting. The scheduling
+ * class is set with SCHED_RESET_ON_FORK, so anything these threads fork or
+ * spawn (notifier scripts) starts back at normal priority. Threads created
+ * before the profile is applied (socket, sensor sampler, thermal) keep the
+ * default scheduler.
+ */
+class RealtimeProfile {
+public:
+    explicit RealtimeProfile(const RealtimeConfig& config);
+
+    bool enabled() const { return config_.enabled; }
+
+    /**
+     * mlockall() the whole process (process-wide, call once)
+     * @return true if memory is locked (or locking is not requested)
+     */
+    bool lockMemory();
+
+    /**
+     * Apply the scheduling policy, CPU set and stack prefault to the
+     * calling thread
+     * @param thread_name Name used in the log lines
+     * @return true if every requested setting took effect
+     */
+    bool applyToCurrentThread(const char* thread_name) const;
+
+    // Live scheduling state of the calling thread, for get_loop_stats
+    struct ThreadState {
+        std::string policy;  // "other", "fifo", "rr", "batch", "idle"
+        int priority;
+        std::string cpus;    // e.g. "0-3" or "2,3"; empty if unknown
+    };
+    static ThreadState currentThreadState();
+
+    static bool memoryLocked() { return memory_locked_.load(); }
+
+private:
+    RealtimeConfig config_;
+    static std::atomic<bool> memory_locked_;
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_REALTIME_HPP
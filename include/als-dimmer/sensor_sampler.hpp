@@ -0,0 +1,110 @@
+#ifndef ALS_DIMMER_SENSOR_SAMPLER_HPP
+#define ALS_DIMMER_SENSOR_SAMPLER_HPP
+
+#include "interfaces.hpp"
+#include "event_loop.hpp"
+#include "spsc_ring.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace als_dimmer {
+
+/**
+ * One sensor reading as taken by the sampler thread
+ */
+struct SensorSample {
+    std::chrono::steady_clock::time_point taken_at;
+    float lux;       // readLux() result (negative on read error)
+    bool healthy;    // isHealthy() right after the read
+};
+
+/**
+ * SensorSampler - sensor acquisition on its own thread
+ *
+ * Reads the sensor every interval_ms (and whenever its poll fd signals a
+ * pushed sample) and queues timestamped samples in a SPSC ring. The control
+ * loop registers eventFd() with its EventLoop and drains the ring, so a
+ * slow or stuck I2C transaction only means "no new sample" there instead of
+ * stalling command handling and output writes.
+ *
+ * While started, the sensor is used exclusively by the sampler thread.
+ */
+class SensorSampler {
+public:
+    static constexpr size_t RING_CAPACITY = 64;
+
+    explicit SensorSampler(SensorInterface& sensor);
+    ~SensorSampler();
+
+    // Manages a thread - not safe to copy/move.
+    SensorSampler(const SensorSampler&) = delete;
+    SensorSampler& operator=(const SensorSampler&) = delete;
+
+    /**
+     * Spawn the acquisition thread. The first read happens immediately.
+     * @param interval_ms Timed read interval
+     * @return true on success
+     */
+    bool start(int interval_ms);
+
+    /**
+     * Signal the thread to exit and join it. Idempotent.
+     */
+    void stop();
+
+    /**
+     * Signal the thread to exit without joining - for giving up on a sensor
+     * whose read may be stuck. The sensor must stay alive until stop() (or
+     * the destructor) has joined.
+     */
+    void requestStop();
+
+    // Change the timed read interval; takes effect after the next read.
+    void setInterval(int interval_ms);
+
+    /**
+     * Suspend all reads (minimal_i2c in MANUAL modes, tickless idle),
+     * including samples pushed through the sensor's poll fd, which stops
+     * being watched. Unpausing reads immediately.
+     */
+    void setPaused(bool paused);
+
+    // Readable while samples are queued; consumeEvent() clears it.
+    int eventFd() const { return sample_event_.fd(); }
+    void consumeEvent() { sample_event_.consume(); }
+
+    /**
+     * Pop the oldest queued sample (consumer side - one thread only)
+     * @return false when the ring is empty
+     */
+    bool pop(SensorSample& out) { return ring_.pop(out); }
+
+    // Samples discarded because the consumer fell RING_CAPACITY behind
+    uint64_t droppedSamples() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+    void takeSample();
+    void syncPollFd(bool paused);
+
+    SensorInterface& sensor_;
+    SpscRing<SensorSample, RING_CAPACITY> ring_;
+
+    EventLoop loop_;
+    EventFd wake_;           // stop/setInterval/setPaused -> thread
+    EventFd sample_event_;   // thread -> consumer
+
+    std::thread thread_;
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<bool> paused_{false};
+    std::atomic<int> interval_ms_{500};
+    std::atomic<uint64_t> dropped_{0};
+    bool started_ = false;
+    int poll_fd_ = -1;  // Sensor fd registered with loop_ (sampler thread only)
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_SENSOR_SAMPLER_HPP
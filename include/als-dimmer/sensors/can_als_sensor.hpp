@@ -28,6 +28,7 @@ public:
     float readLux() override;
     bool isHealthy() const override;
     std::string getType() const override { return "can_als"; }
+    int getPollFd() const override { return socket_fd_; }
 
 private:
     // Configuration
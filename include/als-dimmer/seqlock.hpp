@@ -0,0 +1,79 @@
+#ifndef ALS_DIMMER_SEQLOCK_HPP
+#define ALS_DIMMER_SEQLOCK_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace als_dimmer {
+
+/**
+ * SeqLock - single-writer published value, lock-free for readers
+ *
+ * The writer bumps the sequence to odd, copies the value in and bumps it
+ * back to even; a reader copies the value out and retries if the sequence
+ * was odd or changed meanwhile. Neither side ever blocks the other or
+ * allocates, so the control loop can publish every iteration while any
+ * number of readers take consistent snapshots. T must be trivially
+ * copyable (no std::string - use fixed char arrays).
+ */
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock value must be trivially copyable");
+
+public:
+    SeqLock() : seq_(0), value_() {}
+
+    SeqLock(const SeqLock&) = delete;
+    SeqLock& operator=(const SeqLock&) = delete;
+
+    // Writer side, one thread only
+    void store(const T& value) {
+        uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(static_cast<void*>(&value_), &value, sizeof(T));
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    // Reader side, any thread
+    T load() const {
+        T out;
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            std::memcpy(static_cast<void*>(&out), &value_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq_.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        return out;
+    }
+
+    // Reader side: like load(), but gives up after `attempts` tries, for
+    // a writer in another process that may have died halfway through
+    bool tryLoad(T& out, unsigned attempts) const {
+        for (unsigned i = 0; i < attempts; ++i) {
+            uint32_t before = seq_.load(std::memory_order_acquire);
+            std::memcpy(static_cast<void*>(&out), &value_, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t after = seq_.load(std::memory_order_relaxed);
+            if ((before & 1) == 0 && before == after) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // 0 until the first store()
+    uint32_t version() const { return seq_.load(std::memory_order_acquire); }
+
+private:
+    std::atomic<uint32_t> seq_;
+    T value_;
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_SEQLOCK_HPP
@@ -0,0 +1,66 @@
+#ifndef ALS_DIMMER_SPSC_RING_HPP
+#define ALS_DIMMER_SPSC_RING_HPP
+
+#include <atomic>
+#include <cstddef>
+
+namespace als_dimmer {
+
+/**
+ * SpscRing - fixed-size single-producer/single-consumer ring buffer
+ *
+ * Lock-free and allocation-free: push() must only ever be called from one
+ * thread and pop() from one (other) thread. head_ and tail_ are free-running
+ * counters; capacity must be a power of two so the index is a mask.
+ * When full, push() fails and the caller decides what to do with the
+ * element (the sensor sampler counts it as dropped).
+ */
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head_(0), tail_(0) {}
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // Producer side
+    bool push(const T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == N) {
+            return false;
+        }
+        buf_[head & (N - 1)] = value;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    bool pop(T& out) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = buf_[tail & (N - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Approximate when called concurrently with push/pop
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+private:
+    // Separate cache lines so producer and consumer don't false-share
+    alignas(64) std::atomic<size_t> head_;
+    alignas(64) std::atomic<size_t> tail_;
+    T buf_[N];
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_SPSC_RING_HPP
@@ -55,8 +55,10 @@ public:
     // Check if state needs saving
     bool isDirty() const { return dirty_; }
 
-    // Convert mode to string
+    // Convert mode to string (modeName: same text as a static string, for
+    // the control loop which must not allocate)
     static std::string modeToString(OperatingMode mode);
+    static const char* modeName(OperatingMode mode);
     static OperatingMode stringToMode(const std::string& str);
 
 private:
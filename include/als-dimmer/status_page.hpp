@@ -0,0 +1,169 @@
+#ifndef ALS_DIMMER_STATUS_PAGE_HPP
+#define ALS_DIMMER_STATUS_PAGE_HPP
+
+#include "seqlock.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+namespace als_dimmer {
+
+/**
+ * Status page - the daemon's current state in a memory-mapped file
+ *
+ * With control.status_page set, the daemon publishes a StatusPageData into
+ * that file (e.g. /dev/shm/als-dimmer-status) after every control loop
+ * wakeup, the same moments get_status would change. Local readers map the
+ * file read-only and take snapshots through the SeqLock without any
+ * syscall or socket round trip. StatusPageReader below is everything a
+ * reader needs; it only depends on this header and seqlock.hpp.
+ *
+ * The layout is fixed-width and versioned: a reader checks `magic` and
+ * `layout_version` before trusting anything else. Fields are only ever
+ * appended, with layout_version bumped, so `size` tells an old reader the
+ * page is bigger than it knows about. On a clean exit the daemon clears
+ * `magic` and removes the file; a reader that still has it mapped sees
+ * valid() go false, and otherwise notices a stuck `updated_ns`.
+ */
+
+constexpr uint32_t STATUS_PAGE_MAGIC = 0x44534c41;  // "ALSD"
+constexpr uint32_t STATUS_PAGE_LAYOUT_VERSION = 1;
+
+enum StatusPageMode : uint8_t {
+    STATUS_PAGE_MODE_AUTO = 0,
+    STATUS_PAGE_MODE_MANUAL = 1,
+    STATUS_PAGE_MODE_MANUAL_TEMPORARY = 2
+};
+
+// One snapshot. Plain fixed-width fields only (it is memcpy'd by SeqLock).
+struct StatusPageData {
+    uint64_t updated_ns;         // CLOCK_MONOTONIC time of this publish
+    uint64_t publish_count;      // Publishes since the daemon started
+    double nits;                 // Thermal-corrected; valid when calibrated
+    double backlight_temp_c;     // Valid when thermal_has_reading
+    double thermal_factor;       // 1.0 without a reading
+    float lux;
+    int32_t brightness;          // On the output now, 0-100
+    int32_t manual_brightness;
+    int32_t last_auto_brightness;
+    uint8_t mode;                // StatusPageMode
+    uint8_t sensor_available;
+    uint8_t calibrated;
+    uint8_t thermal_has_reading;
+    char zone[64];               // NUL-terminated
+    uint8_t reserved[4];         // Explicit padding, always 0
+};
+
+static_assert(sizeof(StatusPageData) == 128, "StatusPageData layout changed: bump the layout version");
+
+struct StatusPage {
+    std::atomic<uint32_t> magic;  // STATUS_PAGE_MAGIC while the daemon runs
+    uint32_t layout_version;
+    uint32_t size;                // sizeof(StatusPage) of the writer
+    int32_t daemon_pid;
+    SeqLock<StatusPageData> data;
+};
+
+// Shared between processes, so the atomics must not need a lock
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "status page needs lock-free 32-bit atomics");
+
+/**
+ * StatusPageReader - map a status page read-only and take snapshots
+ */
+class StatusPageReader {
+public:
+    StatusPageReader() : page_(nullptr), size_(0) {}
+    ~StatusPageReader() { close(); }
+
+    StatusPageReader(const StatusPageReader&) = delete;
+    StatusPageReader& operator=(const StatusPageReader&) = delete;
+
+    // False if the file is missing, too small, or not a page this reader
+    // understands
+    bool open(const std::string& path) {
+        close();
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) < 0 || st.st_size < static_cast<off_t>(sizeof(StatusPage))) {
+            ::close(fd);
+            return false;
+        }
+        void* addr = mmap(nullptr, sizeof(StatusPage), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // The mapping stays valid
+        if (addr == MAP_FAILED) {
+            return false;
+        }
+        page_ = static_cast<const StatusPage*>(addr);
+        size_ = sizeof(StatusPage);
+        if (!valid() || page_->layout_version != STATUS_PAGE_LAYOUT_VERSION ||
+            page_->size < sizeof(StatusPage)) {
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (page_ != nullptr) {
+            munmap(const_cast<StatusPage*>(page_), size_);
+            page_ = nullptr;
+        }
+    }
+
+    // False once the daemon has shut down (reopen to pick up a new one)
+    bool valid() const {
+        return page_ != nullptr && page_->magic.load(std::memory_order_acquire) == STATUS_PAGE_MAGIC;
+    }
+
+    // Consistent snapshot; false if the page is gone or the writer never
+    // finished an update (it died mid-write)
+    bool read(StatusPageData& out) const {
+        return valid() && page_->data.tryLoad(out, 1000);
+    }
+
+    int daemonPid() const { return page_ != nullptr ? page_->daemon_pid : 0; }
+
+private:
+    const StatusPage* page_;
+    size_t size_;
+};
+
+/**
+ * StatusPageWriter - the daemon side (control loop thread only)
+ */
+class StatusPageWriter {
+public:
+    StatusPageWriter();
+    ~StatusPageWriter();
+
+    StatusPageWriter(const StatusPageWriter&) = delete;
+    StatusPageWriter& operator=(const StatusPageWriter&) = delete;
+
+    // Create (or take over) the file at `path`, readable by everyone
+    bool open(const std::string& path);
+
+    // Mark the page stale and remove the file
+    void close();
+
+    bool isOpen() const { return page_ != nullptr; }
+
+    // Publish one snapshot. Never blocks or allocates; the writer fills in
+    // updated_ns and publish_count.
+    void publish(StatusPageData& data);
+
+private:
+    StatusPage* page_;
+    std::string path_;
+    uint64_t publish_count_;
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_STATUS_PAGE_HPP
@@ -0,0 +1,86 @@
+#ifndef ALS_DIMMER_TICK_SCHEDULER_HPP
+#define ALS_DIMMER_TICK_SCHEDULER_HPP
+
+#include "config.hpp"
+#include <chrono>
+
+namespace als_dimmer {
+
+/**
+ * TickScheduler picks the control-loop tick interval from lux dynamics
+ *
+ * Lux is tracked as a low-pass filtered rate of change of log(lux), i.e.
+ * relative change in percent per second, so "sharp" means the same thing
+ * in a dark cabin and in direct sunlight.
+ *
+ * - FAST   (min_interval_ms): lux rate at/above fast_lux_rate_percent
+ * - SLOW   (max_interval_ms): lux rate at/below steady_lux_rate_percent and
+ *                             brightness error within steady_error for
+ *                             steady_time_sec
+ * - NORMAL (update_interval_ms): everything in between
+ *
+ * When adaptive_tick is disabled the interval is always update_interval_ms.
+ */
+class TickScheduler {
+public:
+    enum class Rate { FAST, NORMAL, SLOW };
+
+    explicit TickScheduler(const ControlConfig& control);
+
+    /**
+     * Feed a sensor reading into the lux rate filter
+     *
+     * @param lux Reading in lux (negative = no reading, ignored)
+     * @param now Time the reading was taken
+     */
+    void addSample(float lux, std::chrono::steady_clock::time_point now);
+
+    /**
+     * Re-evaluate the tick rate after a control step
+     *
+     * @param brightness_error Controller error (target - current), 0 when
+     *                         there is nothing to converge (MANUAL modes)
+     * @param now Current time
+     * @return Tick interval to use from now on (ms)
+     */
+    int update(int brightness_error, std::chrono::steady_clock::time_point now);
+
+    /**
+     * True when the last sample pushed the filtered lux rate into the FAST
+     * band but the scheduler hasn't switched there yet - lets the caller run
+     * a control step right away instead of waiting out a slow tick.
+     */
+    bool wantsFastTick() const;
+
+    int intervalMs() const { return interval_ms_; }
+    Rate rate() const { return rate_; }
+    float luxRatePercent() const { return lux_rate_percent_; }
+
+    static const char* rateToString(Rate rate);
+
+private:
+    int intervalFor(Rate rate) const;
+
+    AdaptiveTickConfig cfg_;
+    int normal_interval_ms_;
+
+    Rate rate_;
+    int interval_ms_;
+
+    // Lux rate filter state
+    bool have_sample_;
+    float last_log_lux_;
+    std::chrono::steady_clock::time_point last_sample_time_;
+    float lux_rate_percent_;
+
+    // Start of the current settled period (valid when settled_)
+    bool settled_;
+    std::chrono::steady_clock::time_point settled_since_;
+
+    // Filter time constant for the lux rate (seconds)
+    static constexpr float LUX_RATE_TAU_SEC = 0.5f;
+};
+
+} // namespace als_dimmer
+
+#endif // ALS_DIMMER_TICK_SCHEDULER_HPP
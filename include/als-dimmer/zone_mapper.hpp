@@ -28,7 +28,7 @@ public:
     const Zone* selectZone(float lux) const;
 
     // Get zone name for logging/debugging
-    std::string getCurrentZoneName(float lux) const;
+    const std::string& getCurrentZoneName(float lux) const;
 
 private:
     // Curve calculation functions
@@ -0,0 +1,45 @@
+#include "als-dimmer/alloc_check.hpp"
+#include <cstdlib>
+#include <new>
+
+// Only compiled into ALS_DIMMER_ALLOC_CHECK builds (see CMakeLists.txt).
+
+namespace {
+thread_local uint64_t g_thread_allocations = 0;
+
+void* countedAlloc(std::size_t size) {
+    ++g_thread_allocations;
+    void* p = std::malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* countedAllocNoThrow(std::size_t size) noexcept {
+    ++g_thread_allocations;
+    return std::malloc(size ? size : 1);
+}
+} // namespace
+
+namespace als_dimmer {
+namespace alloc_check {
+
+uint64_t threadAllocations() {
+    return g_thread_allocations;
+}
+
+} // namespace alloc_check
+} // namespace als_dimmer
+
+void* operator new(std::size_t size) { return countedAlloc(size); }
+void* operator new[](std::size_t size) { return countedAlloc(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocNoThrow(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocNoThrow(size); }
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,119 @@
+#include "als-dimmer/command_registry.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace als_dimmer {
+namespace protocol {
+
+const CommandSpec* findCommand(const char* name, size_t len) {
+    using namespace registry_detail;
+    int row = SLOTS.index[slotOf(name, len, HASH_SEED)];
+    if (row < 0) {
+        return nullptr;
+    }
+    // One comparison: the slot can only hold this name or another command
+    const CommandSpec& spec = COMMANDS[row];
+    if (std::strncmp(spec.name, name, len) != 0 || spec.name[len] != '\0') {
+        return nullptr;
+    }
+    return &spec;
+}
+
+const CommandSpec* commandSpec(CommandType type) {
+    for (const CommandSpec& spec : COMMANDS) {
+        if (spec.type == type) {
+            return &spec;
+        }
+    }
+    return nullptr;
+}
+
+int coalesceSlot(const CommandSpec& spec) {
+    return registry_detail::coalesceSlot(static_cast<size_t>(&spec - COMMANDS));
+}
+
+namespace {
+
+const char* typeDescription(ParamType type) {
+    switch (type) {
+        case ParamType::INTEGER:
+            return "an integer";
+        case ParamType::NUMBER:
+            return "a number";
+        case ParamType::STRING:
+            return "a string";
+        case ParamType::BOOLEAN:
+            return "true or false";
+        case ParamType::ARRAY:
+            return "an array";
+        case ParamType::OBJECT:
+        default:
+            return "an object";
+    }
+}
+
+bool hasType(const json& value, ParamType type) {
+    switch (type) {
+        case ParamType::INTEGER:
+            return value.is_number_integer();
+        case ParamType::NUMBER:
+            return value.is_number();
+        case ParamType::STRING:
+            return value.is_string();
+        case ParamType::BOOLEAN:
+            return value.is_boolean();
+        case ParamType::ARRAY:
+            return value.is_array();
+        case ParamType::OBJECT:
+        default:
+            return value.is_object();
+    }
+}
+
+std::string rangeError(const ParamSpec& param) {
+    char text[128];
+    if (std::isinf(param.max)) {
+        std::snprintf(text, sizeof(text), "'%s' must be >= %.15g", param.name, param.min);
+    } else if (std::isinf(param.min)) {
+        std::snprintf(text, sizeof(text), "'%s' must be <= %.15g", param.name, param.max);
+    } else {
+        std::snprintf(text, sizeof(text), "'%s' must be between %.15g and %.15g", param.name, param.min,
+                      param.max);
+    }
+    return text;
+}
+
+} // namespace
+
+void validateParams(const CommandSpec& spec, const json& params) {
+    if (!params.is_object()) {
+        throw ParamError("'params' must be an object");
+    }
+
+    for (const ParamSpec& param : spec.params) {
+        if (param.name == nullptr) {
+            break;
+        }
+        auto it = params.find(param.name);
+        if (it == params.end()) {
+            if (param.required) {
+                throw ParamError(std::string("Missing '") + param.name + "' parameter");
+            }
+            continue;
+        }
+        if (!hasType(*it, param.type)) {
+            throw ParamError(std::string("'") + param.name + "' must be " + typeDescription(param.type));
+        }
+        if (param.type == ParamType::INTEGER || param.type == ParamType::NUMBER) {
+            // Unsigned values beyond int64 range still compare correctly as doubles
+            double value = it->get<double>();
+            if (value < param.min || value > param.max) {
+                throw ParamError(rangeError(param));
+            }
+        }
+    }
+}
+
+} // namespace protocol
+} // namespace als_dimmer
@@ -208,6 +208,93 @@ Config Config::loadFromFile(const std::string& filename) {
         if (control_json.contains("minimal_i2c")) {
             config.control.minimal_i2c = control_json["minimal_i2c"].get<bool>();
         }
+        if (control_json.contains("output_verify_interval_sec")) {
+            config.control.output_verify_interval_sec = control_json["output_verify_interval_sec"].get<int>();
+        }
+        if (control_json.contains("command_queue_depth")) {
+            config.control.command_queue_depth = control_json["command_queue_depth"].get<int>();
+        }
+        if (control_json.contains("command_coalescing")) {
+            config.control.command_coalescing = control_json["command_coalescing"].get<std::string>();
+        }
+        if (control_json.contains("max_line_bytes")) {
+            config.control.max_line_bytes = control_json["max_line_bytes"].get<int>();
+        }
+        if (control_json.contains("status_page")) {
+            config.control.status_page = control_json["status_page"].get<std::string>();
+        }
+
+        // Parse adaptive tick (optional)
+        if (control_json.contains("adaptive_tick")) {
+            auto& at_json = control_json["adaptive_tick"];
+            auto& at = config.control.adaptive_tick;
+            if (at_json.contains("enabled")) {
+                at.enabled = at_json["enabled"].get<bool>();
+            }
+            if (at_json.contains("min_interval_ms")) {
+                at.min_interval_ms = at_json["min_interval_ms"].get<int>();
+            }
+            if (at_json.contains("max_interval_ms")) {
+                at.max_interval_ms = at_json["max_interval_ms"].get<int>();
+            }
+            if (at_json.contains("fast_lux_rate_percent")) {
+                at.fast_lux_rate_percent = at_json["fast_lux_rate_percent"].get<float>();
+            }
+            if (at_json.contains("steady_lux_rate_percent")) {
+                at.steady_lux_rate_percent = at_json["steady_lux_rate_percent"].get<float>();
+            }
+            if (at_json.contains("steady_error")) {
+                at.steady_error = at_json["steady_error"].get<int>();
+            }
+            if (at_json.contains("steady_time_sec")) {
+                at.steady_time_sec = at_json["steady_time_sec"].get<int>();
+            }
+        }
+
+        // Parse output ramp engine (optional)
+        if (control_json.contains("ramp")) {
+            auto& ramp_json = control_json["ramp"];
+            auto& ramp = config.control.ramp;
+            if (ramp_json.contains("enabled")) {
+                ramp.enabled = ramp_json["enabled"].get<bool>();
+            }
+            if (ramp_json.contains("rate_hz")) {
+                ramp.rate_hz = ramp_json["rate_hz"].get<int>();
+            }
+            if (ramp_json.contains("fade_up_ms")) {
+                ramp.fade_up_ms = ramp_json["fade_up_ms"].get<int>();
+            }
+            if (ramp_json.contains("fade_down_ms")) {
+                ramp.fade_down_ms = ramp_json["fade_down_ms"].get<int>();
+            }
+            if (ramp_json.contains("manual_fade_ms")) {
+                ramp.manual_fade_ms = ramp_json["manual_fade_ms"].get<int>();
+            }
+        }
+
+        // Parse real-time profile (optional)
+        if (control_json.contains("realtime")) {
+            auto& rt_json = control_json["realtime"];
+            auto& rt = config.control.realtime;
+            if (rt_json.contains("enabled")) {
+                rt.enabled = rt_json["enabled"].get<bool>();
+            }
+            if (rt_json.contains("policy")) {
+                rt.policy = rt_json["policy"].get<std::string>();
+            }
+            if (rt_json.contains("priority")) {
+                rt.priority = rt_json["priority"].get<int>();
+            }
+            if (rt_json.contains("cpus")) {
+                rt.cpus = rt_json["cpus"].get<std::vector<int>>();
+            }
+            if (rt_json.contains("lock_memory")) {
+                rt.lock_memory = rt_json["lock_memory"].get<bool>();
+            }
+            if (rt_json.contains("prefault_stack_kb")) {
+                rt.prefault_stack_kb = rt_json["prefault_stack_kb"].get<int>();
+            }
+        }
     }
 
     // Parse zones
@@ -589,6 +676,72 @@ void Config::validate() const {
     if (control.hysteresis_percent < 0.0f || control.hysteresis_percent > 50.0f) {
         throw ConfigError("control.hysteresis_percent must be between 0 and 50");
     }
+    if (control.output_verify_interval_sec < 0 || control.output_verify_interval_sec > 86400) {
+        throw ConfigError("control.output_verify_interval_sec must be between 0 and 86400");
+    }
+    if (control.command_queue_depth < 1 || control.command_queue_depth > 4096) {
+        throw ConfigError("control.command_queue_depth must be between 1 and 4096");
+    }
+    if (control.command_coalescing != "global" && control.command_coalescing != "per_client" &&
+        control.command_coalescing != "off") {
+        throw ConfigError("control.command_coalescing must be 'global', 'per_client' or 'off'");
+    }
+    if (control.max_line_bytes < 256 || control.max_line_bytes > 1048576) {
+        throw ConfigError("control.max_line_bytes must be between 256 and 1048576");
+    }
+    if (!control.status_page.empty() && control.status_page[0] != '/') {
+        throw ConfigError("control.status_page must be an absolute path (e.g. /dev/shm/als-dimmer-status)");
+    }
+    if (control.adaptive_tick.enabled) {
+        const auto& at = control.adaptive_tick;
+        if (at.min_interval_ms < 10 || at.min_interval_ms > control.update_interval_ms) {
+            throw ConfigError("control.adaptive_tick.min_interval_ms must be between 10 "
+                              "and control.update_interval_ms");
+        }
+        if (at.max_interval_ms < control.update_interval_ms || at.max_interval_ms > 60000) {
+            throw ConfigError("control.adaptive_tick.max_interval_ms must be between "
+                              "control.update_interval_ms and 60000");
+        }
+        if (at.steady_lux_rate_percent < 0.0f ||
+            at.fast_lux_rate_percent <= at.steady_lux_rate_percent) {
+            throw ConfigError("control.adaptive_tick requires 0 <= steady_lux_rate_percent "
+                              "< fast_lux_rate_percent");
+        }
+        if (at.steady_error < 0 || at.steady_error > 100) {
+            throw ConfigError("control.adaptive_tick.steady_error must be between 0 and 100");
+        }
+        if (at.steady_time_sec < 0) {
+            throw ConfigError("control.adaptive_tick.steady_time_sec must be >= 0");
+        }
+    }
+    if (control.ramp.enabled) {
+        const auto& ramp = control.ramp;
+        if (ramp.rate_hz < 10 || ramp.rate_hz > 250) {
+            throw ConfigError("control.ramp.rate_hz must be between 10 and 250");
+        }
+        if (ramp.fade_up_ms < 0 || ramp.fade_up_ms > 60000 ||
+            ramp.fade_down_ms < 0 || ramp.fade_down_ms > 60000 ||
+            ramp.manual_fade_ms < 0 || ramp.manual_fade_ms > 60000) {
+            throw ConfigError("control.ramp fade times must be between 0 and 60000 ms");
+        }
+    }
+    if (control.realtime.enabled) {
+        const auto& rt = control.realtime;
+        if (rt.policy != "fifo" && rt.policy != "rr") {
+            throw ConfigError("control.realtime.policy must be \"fifo\" or \"rr\"");
+        }
+        if (rt.priority < 1 || rt.priority > 99) {
+            throw ConfigError("control.realtime.priority must be between 1 and 99");
+        }
+        for (int cpu : rt.cpus) {
+            if (cpu < 0 || cpu >= 1024) {
+                throw ConfigError("control.realtime.cpus entries must be between 0 and 1023");
+            }
+        }
+        if (rt.prefault_stack_kb < 0 || rt.prefault_stack_kb > 4096) {
+            throw ConfigError("control.realtime.prefault_stack_kb must be between 0 and 4096");
+        }
+    }
     if (white_point_calibration.enabled &&
         white_point_calibration.file_path.empty()) {
         throw ConfigError("white_point_calibration.file_path cannot be empty when enabled");
@@ -1,6 +1,10 @@
 #include "als-dimmer/control_interface.hpp"
 #include "als-dimmer/json_protocol.hpp"
+#include "als-dimmer/command_registry.hpp"
 #include "als-dimmer/logger.hpp"
+#include "als-dimmer/brightness_to_nits_lut.hpp"
+#include "als-dimmer/thermal_compensation.hpp"
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <sys/stat.h>
@@ -10,19 +14,145 @@
 #include <fcntl.h>
 #include <pwd.h>
 #include <grp.h>
-#include <poll.h>
+#include <cctype>
+#include <cerrno>
 #include <cstring>
 #include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
 #include <iostream>
-#include <sstream>
 
 namespace als_dimmer {
 
+namespace {
+
+// Reactor tokens for the non-client fds. Client tokens are their ClientId,
+// whose generation (high 32 bits) is never 0, so the two cannot collide.
+constexpr uint64_t TOKEN_WAKE = 0;
+constexpr uint64_t TOKEN_TCP_LISTEN = 1;
+constexpr uint64_t TOKEN_UNIX_LISTEN = 2;
+constexpr uint64_t TOKEN_STATUS = 3;
+constexpr uint64_t TOKEN_EVENT_TIMER = 4;
+
+constexpr std::chrono::seconds QUEUE_FULL_LOG_INTERVAL(5);
+
+const char* const TOPIC_NAMES[] = {"brightness", "mode", "zone", "lux", "thermal", "sensor"};
+
+// Parse one request (a text line or a binary frame payload) into `out`.
+// Returns an empty string on success, otherwise the error response to send.
+std::string parseRequest(const char* data, size_t len, protocol::Encoding encoding,
+                         protocol::ParsedCommand& out) {
+    out.id.clear();  // Unless parseCommand() gets as far as reading it
+
+    if (encoding == protocol::Encoding::JSON) {
+        // Legacy plain-text shutdown request from the original line protocol
+        if (len == 8 && std::memcmp(data, "SHUTDOWN", 8) == 0) {
+            out.type = protocol::CommandType::SHUTDOWN;
+            out.spec = nullptr;
+            out.params = json::object();
+            out.version.clear();
+            return std::string();
+        }
+
+        if (data[0] != '{' && data[0] != '[') {
+            return protocol::generateErrorResponse(
+                "Invalid command format. Only JSON protocol is supported. "
+                "Please send commands in JSON format starting with '{' (or '[' for a batch)",
+                "INVALID_FORMAT");
+        }
+    }
+
+    try {
+        protocol::parseCommand(data, len, encoding, out);
+    } catch (const json::parse_error& e) {
+        return protocol::generateErrorResponse(
+            std::string(encoding == protocol::Encoding::JSON ? "JSON parse error: " : "Parse error: ") +
+            e.what(), "PARSE_ERROR");
+    } catch (const protocol::ParamError& e) {
+        return protocol::generateErrorResponse(e.what(), "INVALID_PARAMS");
+    } catch (const std::invalid_argument& e) {
+        return protocol::generateErrorResponse(e.what(), "INVALID_FORMAT");
+    } catch (const std::exception& e) {
+        return protocol::generateErrorResponse(
+            std::string("Internal error: ") + e.what(), "INTERNAL_ERROR");
+    }
+
+    if (out.type == protocol::CommandType::UNKNOWN) {
+        return protocol::generateErrorResponse("Unknown command type", "UNKNOWN_COMMAND");
+    }
+    return std::string();
+}
+
+// True if [data, data + len) is exactly one complete JSON object (brace
+// depth returns to zero on the last non-blank byte, ignoring braces
+// inside strings). Lets a client that writes one object per send without
+// a newline keep working.
+bool isCompleteObject(const char* data, size_t len) {
+    while (len > 0 && std::isspace(static_cast<unsigned char>(data[len - 1]))) {
+        --len;
+    }
+    size_t i = 0;
+    while (i < len && std::isspace(static_cast<unsigned char>(data[i]))) {
+        ++i;
+    }
+    if (i == len || data[i] != '{' || data[len - 1] != '}') {
+        return false;
+    }
+
+    int depth = 0;
+    bool in_string = false;
+    bool escaped = false;
+    for (; i < len; ++i) {
+        char c = data[i];
+        if (in_string) {
+            if (escaped) {
+                escaped = false;
+            } else if (c == '\\') {
+                escaped = true;
+            } else if (c == '"') {
+                in_string = false;
+            }
+        } else if (c == '"') {
+            in_string = true;
+        } else if (c == '{') {
+            ++depth;
+        } else if (c == '}' && --depth == 0) {
+            return i == len - 1;
+        }
+    }
+    return false;
+}
+
+// Output ages were taken at publish time; bring them up to now
+void outputAgesNow(const SystemStatus& status, int64_t& cache_age, int64_t& verified_age) {
+    int64_t since_publish = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - status.published_at).count();
+    cache_age = status.output_cache_age_ms;
+    verified_age = status.output_verified_age_ms;
+    if (cache_age >= 0) {
+        cache_age += since_publish;
+    }
+    if (verified_age >= 0) {
+        verified_age += since_publish;
+    }
+}
+
+} // namespace
+
 ControlInterface::ControlInterface(const ControlConfig& config)
     : config_(config)
     , tcp_server_fd_(-1)
     , unix_server_fd_(-1)
-    , running_(false) {
+    , running_(false)
+    , event_deadline_(std::chrono::steady_clock::time_point::max())
+    , subscribers_(0)
+    , clients_(MAX_CLIENTS)
+    // Twice the depth: superseded entries keep their cells until dequeued
+    , command_queue_(2 * static_cast<size_t>(config.command_queue_depth))
+    , coalesce_slots_(config.command_coalescing == "off" ? 0 :
+                      protocol::COALESCE_SLOT_COUNT *
+                          (config.command_coalescing == "per_client" ? MAX_CLIENTS : 1)) {
 }
 
 ControlInterface::~ControlInterface() {
@@ -30,12 +160,20 @@ ControlInterface::~ControlInterface() {
 }
 
 bool ControlInterface::start() {
+    if (!command_event_.init() || !reactor_.init() || !reactor_wake_.init() ||
+        !status_event_.init() || !event_timer_.init() ||
+        !reactor_.add(reactor_wake_.fd(), EPOLLIN, TOKEN_WAKE) ||
+        !reactor_.add(status_event_.fd(), EPOLLIN, TOKEN_STATUS) ||
+        !reactor_.add(event_timer_.fd(), EPOLLIN, TOKEN_EVENT_TIMER)) {
+        return false;
+    }
+
     running_ = true;
 
     // Start TCP socket listener if enabled
     if (config_.tcp_socket.enabled) {
-        // Create TCP socket
-        tcp_server_fd_ = socket(AF_INET, SOCK_STREAM, 0);
+        // Create TCP socket (non-blocking: the reactor accepts until EAGAIN)
+        tcp_server_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
         if (tcp_server_fd_ < 0) {
             LOG_ERROR("ControlInterface", "Failed to create TCP socket: " << strerror(errno));
             return false;
@@ -75,7 +213,10 @@ bool ControlInterface::start() {
             return false;
         }
 
-        tcp_accept_thread_ = std::thread(&ControlInterface::acceptTcpClients, this);
+        if (!reactor_.add(tcp_server_fd_, EPOLLIN, TOKEN_TCP_LISTEN)) {
+            close(tcp_server_fd_);
+            return false;
+        }
         LOG_INFO("ControlInterface", "TCP socket listening on "
                  << config_.tcp_socket.listen_address << ":"
                  << config_.tcp_socket.listen_port);
@@ -83,17 +224,17 @@ bool ControlInterface::start() {
 
     // Start Unix socket listener if enabled
     if (config_.unix_socket.enabled) {
-        if (!createUnixSocket()) {
+        if (!createUnixSocket() || !reactor_.add(unix_server_fd_, EPOLLIN, TOKEN_UNIX_LISTEN)) {
             if (config_.tcp_socket.enabled && tcp_server_fd_ >= 0) {
                 close(tcp_server_fd_);
             }
             return false;
         }
 
-        unix_accept_thread_ = std::thread(&ControlInterface::acceptUnixClients, this);
         LOG_INFO("ControlInterface", "Unix socket listening on " << config_.unix_socket.path);
     }
 
+    reactor_thread_ = std::thread(&ControlInterface::reactorLoop, this);
     return true;
 }
 
@@ -104,15 +245,18 @@ void ControlInterface::stop() {
 
     running_ = false;
 
-    // Shutdown server sockets to unblock accept() threads, then close
+    // Wake the reactor out of epoll_wait and wait for it to exit
+    reactor_wake_.signal();
+    if (reactor_thread_.joinable()) {
+        reactor_thread_.join();
+    }
+
     if (tcp_server_fd_ >= 0) {
-        shutdown(tcp_server_fd_, SHUT_RDWR);
         close(tcp_server_fd_);
         tcp_server_fd_ = -1;
     }
 
     if (unix_server_fd_ >= 0) {
-        shutdown(unix_server_fd_, SHUT_RDWR);
         close(unix_server_fd_);
         unix_server_fd_ = -1;
     }
@@ -122,33 +266,16 @@ void ControlInterface::stop() {
         unlink(config_.unix_socket.path.c_str());
     }
 
-    // Wait for accept threads
-    if (tcp_accept_thread_.joinable()) {
-        tcp_accept_thread_.join();
-    }
-    if (unix_accept_thread_.joinable()) {
-        unix_accept_thread_.join();
-    }
-
     // Close all client connections
     {
         std::lock_guard<std::mutex> lock(clients_mutex_);
-        for (int fd : client_fds_) {
-            if (fd >= 0) {
-                close(fd);
+        for (auto& conn : clients_) {
+            if (conn.fd >= 0) {
+                closeClient(conn);
             }
         }
-        client_fds_.clear();
     }
 
-    // Wait for client threads
-    for (auto& thread : client_threads_) {
-        if (thread.joinable()) {
-            thread.join();
-        }
-    }
-    client_threads_.clear();
-
     LOG_DEBUG("ControlInterface", "Stopped");
 }
 
@@ -157,7 +284,7 @@ bool ControlInterface::createUnixSocket() {
     removeStaleUnixSocket();
 
     // Create Unix socket
-    unix_server_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    unix_server_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (unix_server_fd_ < 0) {
         LOG_ERROR("ControlInterface", "Failed to create Unix socket: " << strerror(errno));
         return false;
@@ -282,299 +409,1161 @@ void ControlInterface::removeStaleUnixSocket() {
     }
 }
 
-void ControlInterface::acceptTcpClients() {
+void ControlInterface::reactorLoop() {
+    EventLoop::Event events[16];
+
     while (running_) {
-        // Use poll() to wait for incoming connections with a timeout
-        // so we can check running_ periodically and not block shutdown
-        struct pollfd pfd = {tcp_server_fd_, POLLIN, 0};
-        int poll_ret = poll(&pfd, 1, 500); // 500ms timeout
-        if (poll_ret <= 0 || !running_) {
-            continue;
+        int n = reactor_.wait(events, 16, -1);
+        if (n < 0) {
+            break;
         }
 
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
+        for (int i = 0; i < n && running_; ++i) {
+            const uint64_t token = events[i].token;
+            const uint32_t ev = events[i].events;
+
+            if (token == TOKEN_WAKE) {
+                reactor_wake_.consume();
+                continue;
+            }
+            if (token == TOKEN_STATUS) {
+                status_event_.consume();
+                pushEvents();
+                continue;
+            }
+            if (token == TOKEN_EVENT_TIMER) {
+                event_timer_.consume();
+                event_deadline_ = std::chrono::steady_clock::time_point::max();
+                pushEvents();
+                continue;
+            }
+            if (token == TOKEN_TCP_LISTEN) {
+                acceptClients(tcp_server_fd_, SocketType::TCP);
+                continue;
+            }
+            if (token == TOKEN_UNIX_LISTEN) {
+                acceptClients(unix_server_fd_, SocketType::UNIX);
+                continue;
+            }
+
+            std::lock_guard<std::mutex> lock(clients_mutex_);
+            Connection* conn = findClient(token);
+            if (conn == nullptr) {
+                continue;  // Closed earlier in this batch
+            }
+
+            // Full hangup while waiting on responses for a half-closed
+            // client: nobody is left to read them
+            if ((ev & EPOLLERR) || ((ev & EPOLLHUP) && conn->peer_closed)) {
+                closeClient(*conn);
+                continue;
+            }
+            if (ev & EPOLLOUT) {
+                flushClient(*conn);
+            }
+            if (conn->fd >= 0 && !conn->peer_closed && (ev & (EPOLLIN | EPOLLHUP))) {
+                readClient(*conn);
+            }
+        }
+    }
+}
 
-        int client_fd = accept(tcp_server_fd_, (struct sockaddr*)&client_addr, &client_len);
+void ControlInterface::acceptClients(int server_fd, SocketType socket_type) {
+    const char* socket_type_str = (socket_type == SocketType::TCP) ? "TCP" : "Unix";
+
+    while (running_) {
+        struct sockaddr_storage client_addr;
+        socklen_t client_len = sizeof(client_addr);
 
+        int client_fd = accept4(server_fd, (struct sockaddr*)&client_addr, &client_len,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
         if (client_fd < 0) {
-            if (running_) {
-                LOG_ERROR("ControlInterface", "TCP accept failed: " << strerror(errno));
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERROR("ControlInterface", socket_type_str << " accept failed: " << strerror(errno));
             }
+            return;
+        }
+
+        if (socket_type == SocketType::TCP) {
+            char client_ip[INET_ADDRSTRLEN];
+            const struct sockaddr_in* in = (const struct sockaddr_in*)&client_addr;
+            inet_ntop(AF_INET, &in->sin_addr, client_ip, INET_ADDRSTRLEN);
+            LOG_DEBUG("ControlInterface", "TCP client connected from " << client_ip);
+        } else {
+            LOG_DEBUG("ControlInterface", "Unix socket client connected");
+        }
+
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        auto slot = std::find_if(clients_.begin(), clients_.end(),
+                                 [](const Connection& c) { return c.fd < 0; });
+        if (slot == clients_.end()) {
+            LOG_WARN("ControlInterface", "Connection table full (" << MAX_CLIENTS
+                     << " clients), rejecting " << socket_type_str << " client");
+            close(client_fd);
             continue;
         }
 
-        // Get client IP
-        char client_ip[INET_ADDRSTRLEN];
-        inet_ntop(AF_INET, &client_addr.sin_addr, client_ip, INET_ADDRSTRLEN);
-        LOG_DEBUG("ControlInterface", "TCP client connected from " << client_ip);
+        Connection& conn = *slot;
+        conn.fd = client_fd;
+        conn.socket_type = socket_type;
+        conn.pending = 0;
+        conn.peer_closed = false;
+        conn.rx.resize(static_cast<size_t>(config_.max_line_bytes));
+        conn.rx_len = 0;
+        conn.rx_discarding = false;
+        conn.tx.clear();
+        conn.encoding = protocol::Encoding::JSON;
+        conn.sub = Subscription();
+        if (++conn.generation == 0) {
+            conn.generation = 1;  // 0 would make the id collide with TOKEN_*
+        }
 
-        // Store client FD
-        {
-            std::lock_guard<std::mutex> lock(clients_mutex_);
-            client_fds_.push_back(client_fd);
+        if (!reactor_.add(client_fd, EPOLLIN, clientIdOf(conn))) {
+            close(client_fd);
+            conn.fd = -1;
         }
+    }
+}
+
+void ControlInterface::readClient(Connection& conn) {
+    const char* socket_type_str = (conn.socket_type == SocketType::TCP) ? "TCP" : "Unix";
 
-        // Create thread to handle client
-        client_threads_.push_back(std::thread(&ControlInterface::handleClient, this, client_fd, SocketType::TCP));
+    // Receive straight into the connection buffer, after any partial line
+    ssize_t n = recv(conn.fd, conn.rx.data() + conn.rx_len, conn.rx.size() - conn.rx_len, 0);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return;
+        }
+        LOG_DEBUG("ControlInterface", socket_type_str << " client read failed: " << strerror(errno));
+        closeClient(conn);
+        return;
     }
+
+    if (n == 0) {
+        LOG_DEBUG("ControlInterface", socket_type_str << " client disconnected");
+        // A last command without a trailing newline is still a command
+        frameInput(conn, true);
+        if (conn.fd < 0) {
+            return;
+        }
+        // The peer may only have shut down its write side and still be
+        // waiting for answers to what it sent: keep the connection until
+        // those responses are out, otherwise close now.
+        if (conn.pending > 0 || !conn.tx.empty()) {
+            conn.peer_closed = true;
+            updateInterest(conn);
+        } else {
+            closeClient(conn);
+        }
+        return;
+    }
+
+    conn.rx_len += static_cast<size_t>(n);
+    frameInput(conn, false);
 }
 
-void ControlInterface::acceptUnixClients() {
-    while (running_) {
-        // Use poll() to wait for incoming connections with a timeout
-        // so we can check running_ periodically and not block shutdown
-        struct pollfd pfd = {unix_server_fd_, POLLIN, 0};
-        int poll_ret = poll(&pfd, 1, 500); // 500ms timeout
-        if (poll_ret <= 0 || !running_) {
-            continue;
+void ControlInterface::frameInput(Connection& conn, bool eof) {
+    // A `hello` switches the encoding mid-buffer: whatever follows it is
+    // framed the new way
+    protocol::Encoding before;
+    do {
+        before = conn.encoding;
+        if (before == protocol::Encoding::JSON) {
+            frameLines(conn, eof);
+        } else {
+            frameBinary(conn);
         }
+    } while (conn.fd >= 0 && conn.encoding != before && conn.rx_len > 0);
+}
 
-        struct sockaddr_un client_addr;
-        socklen_t client_len = sizeof(client_addr);
+void ControlInterface::frameLines(Connection& conn, bool eof) {
+    const char* socket_type_str = (conn.socket_type == SocketType::TCP) ? "TCP" : "Unix";
+    char* buf = conn.rx.data();
+    size_t start = 0;
 
-        int client_fd = accept(unix_server_fd_, (struct sockaddr*)&client_addr, &client_len);
+    // Each complete line is handed on in place, no copy
+    while (conn.fd >= 0 && start < conn.rx_len) {
+        char* nl = static_cast<char*>(std::memchr(buf + start, '\n', conn.rx_len - start));
+        if (nl == nullptr) {
+            break;
+        }
+        size_t end = static_cast<size_t>(nl - buf);
+        size_t line_start = start;
+        start = end + 1;
 
-        if (client_fd < 0) {
-            if (running_) {
-                LOG_ERROR("ControlInterface", "Unix accept failed: " << strerror(errno));
-            }
+        if (conn.rx_discarding) {
+            conn.rx_discarding = false;  // Tail of an over-long line
+            continue;
+        }
+        while (end > line_start && buf[end - 1] == '\r') {
+            --end;
+        }
+        if (end == line_start) {
             continue;
         }
 
-        LOG_DEBUG("ControlInterface", "Unix socket client connected");
+        LOG_DEBUG("ControlInterface", socket_type_str << " command: "
+                  << std::string(buf + line_start, end - line_start));
+        enqueueRequest(conn, buf + line_start, end - line_start);
+        if (conn.encoding != protocol::Encoding::JSON) {
+            break;  // Switched by hello; frameInput() takes the rest
+        }
+    }
+    if (conn.fd < 0) {
+        return;  // Dropped while answering (send failure)
+    }
 
-        // Store client FD
-        {
-            std::lock_guard<std::mutex> lock(clients_mutex_);
-            client_fds_.push_back(client_fd);
+    // Only the partial line (usually nothing) moves to the front
+    size_t rest = conn.rx_len - start;
+    if (rest > 0 && start > 0) {
+        std::memmove(buf, buf + start, rest);
+    }
+    conn.rx_len = rest;
+    if (conn.encoding != protocol::Encoding::JSON) {
+        return;
+    }
+
+    if (conn.rx_discarding) {
+        conn.rx_len = 0;
+        return;
+    }
+
+    if (rest > 0 && (eof || isCompleteObject(buf, rest))) {
+        LOG_DEBUG("ControlInterface", socket_type_str << " command: " << std::string(buf, rest));
+        conn.rx_len = 0;
+        enqueueRequest(conn, buf, rest);
+        return;
+    }
+
+    if (conn.rx_len == conn.rx.size()) {
+        LOG_WARN("ControlInterface", socket_type_str << " client sent a line longer than "
+                 << conn.rx.size() << " bytes, discarding it");
+        conn.rx_len = 0;
+        conn.rx_discarding = true;
+        std::string msg = protocol::generateErrorResponse(
+            "Line exceeds " + std::to_string(conn.rx.size()) + " bytes", "LINE_TOO_LONG") + "\n";
+        queueOutput(conn, msg.c_str(), msg.length());
+    }
+}
+
+void ControlInterface::frameBinary(Connection& conn) {
+    const char* socket_type_str = (conn.socket_type == SocketType::TCP) ? "TCP" : "Unix";
+    char* buf = conn.rx.data();
+    size_t start = 0;
+
+    while (conn.fd >= 0 && conn.encoding != protocol::Encoding::JSON &&
+           conn.rx_len - start >= protocol::FRAME_HEADER_BYTES) {
+        const unsigned char* header = reinterpret_cast<const unsigned char*>(buf + start);
+        size_t len = (static_cast<size_t>(header[0]) << 24) | (static_cast<size_t>(header[1]) << 16) |
+                     (static_cast<size_t>(header[2]) << 8) | static_cast<size_t>(header[3]);
+
+        if (len > conn.rx.size() - protocol::FRAME_HEADER_BYTES) {
+            // Unlike a text line, there is no way to find where the next
+            // frame starts: answer, stop reading and close once answered
+            LOG_WARN("ControlInterface", socket_type_str << " client sent a "
+                     << len << " byte frame, closing the connection");
+            reply(conn, protocol::generateErrorResponse(
+                      "Frame exceeds " + std::to_string(conn.rx.size() - protocol::FRAME_HEADER_BYTES) +
+                      " bytes", "FRAME_TOO_LONG"), std::string());
+            conn.rx_len = 0;
+            if (conn.fd >= 0) {
+                conn.peer_closed = true;
+                updateInterest(conn);
+                finishIfDone(conn);
+            }
+            return;
         }
+        if (conn.rx_len - start - protocol::FRAME_HEADER_BYTES < len) {
+            break;  // Rest of the frame not here yet
+        }
+
+        start += protocol::FRAME_HEADER_BYTES;
+        enqueueRequest(conn, buf + start, len);
+        start += len;
+    }
+    if (conn.fd < 0) {
+        return;
+    }
 
-        // Create thread to handle client
-        client_threads_.push_back(std::thread(&ControlInterface::handleClient, this, client_fd, SocketType::UNIX));
+    size_t rest = conn.rx_len - start;
+    if (rest > 0 && start > 0) {
+        std::memmove(buf, buf + start, rest);
     }
+    conn.rx_len = rest;
 }
 
-void ControlInterface::handleClient(int client_fd, SocketType socket_type) {
-    const char* socket_type_str = (socket_type == SocketType::TCP) ? "TCP" : "Unix";
-    char buffer[4096];
+void ControlInterface::enqueueRequest(Connection& conn, const char* data, size_t len) {
+    // Parse once here; the queue and the main loop only ever see the typed
+    // command. Malformed requests are answered straight from the reactor.
+    std::string error = parseRequest(data, len, conn.encoding, staging_.command);
+    if (!error.empty()) {
+        reply(conn, std::move(error), staging_.command.id);
+        return;
+    }
 
-    while (running_) {
-        // Read data
-        ssize_t n = recv(client_fd, buffer, sizeof(buffer) - 1, 0);
+    // Subscriptions are per-connection state, handled entirely here
+    if (staging_.command.type == protocol::CommandType::SUBSCRIBE) {
+        subscribe(conn, staging_.command);
+        return;
+    }
+    if (staging_.command.type == protocol::CommandType::UNSUBSCRIBE) {
+        unsubscribe(conn, staging_.command);
+        return;
+    }
+    if (staging_.command.type == protocol::CommandType::HELLO) {
+        hello(conn, staging_.command);
+        return;
+    }
 
-        if (n <= 0) {
-            break;  // Connection closed or error
+    // Read-only queries are answered here from the status the main loop
+    // last published, in microseconds instead of up to a tick later. Not
+    // while this client still has commands queued, though: those might
+    // change what the query reports, and the client must see its own
+    // writes in order.
+    if (isQuery(staging_.command.type) && conn.pending == 0 && status_.version() != 0) {
+        if (staging_.command.type == protocol::CommandType::GET_STATUS) {
+            sendStatus(conn, status_.load(), staging_.command.id);
+            return;
         }
+        json response = answerQuery(staging_.command.type, status_.load());
+        sendMessage(conn, response, staging_.command.id);
+        return;
+    }
 
-        buffer[n] = '\0';
+    staging_.client_id = clientIdOf(conn);
+    staging_.enqueued_at = std::chrono::steady_clock::now();
+    staging_.coalesce_seq = 0;
+
+    // Each command's registry row says what coalescing does to it.
+    // LATEST_WINS (set_brightness, set_absolute_brightness, set_mode): a
+    // newer command supersedes one of the same type still in the queue in
+    // O(1). SUM_DELTA (adjust_brightness): deltas are summed into the
+    // newest entry instead, so no increment is lost. "delta" is already
+    // known to be an int. SHUTDOWN has no row and never coalesces.
+    protocol::ParsedCommand& cmd = staging_.command;
+    staging_.slot = coalesceSlotFor(conn, cmd.spec);
+    bool accumulate = cmd.spec != nullptr && cmd.spec->coalesce == protocol::Coalesce::SUM_DELTA;
+
+    // A burst from one slider supersedes the entry it queued just before:
+    // the command takes that entry's place instead of a new cell
+    if (staging_.slot != nullptr && replaceNewest(conn, accumulate)) {
+        return;
+    }
+
+    // Other superseded entries sit in their cells until the main loop
+    // skips them but don't count against the depth; the ring has room for
+    // as many of them again. With a single producer (this thread) a free
+    // cell now means the push below cannot fail, so coalescing never
+    // supersedes an entry and then loses the new one.
+    size_t queued = command_queue_.size();
+    int64_t superseded = std::max<int64_t>(0, superseded_queued_.load(std::memory_order_relaxed));
+    size_t live = queued - std::min(queued, static_cast<size_t>(superseded));
+    if (live >= command_queue_.capacity() / 2 || queued >= command_queue_.capacity()) {
+        // Every rejection is answered; the log only gets a periodic count
+        queue_full_rejected_++;
+        auto now = std::chrono::steady_clock::now();
+        if (now - queue_full_logged_at_ >= QUEUE_FULL_LOG_INTERVAL) {
+            LOG_WARN("ControlInterface", "Command queue full (" << command_queue_.capacity() / 2
+                     << " entries), rejected " << queue_full_rejected_
+                     << " command(s) since the last warning");
+            queue_full_logged_at_ = now;
+            queue_full_rejected_ = 0;
+        }
+        reply(conn, protocol::generateErrorResponse("Command queue full", "QUEUE_FULL"),
+              staging_.command.id);
+        return;
+    }
 
-        // Process JSON commands line by line (each line should be a complete JSON object)
-        std::string data(buffer);
-        std::istringstream iss(data);
-        std::string line;
+    if (staging_.slot != nullptr) {
+        CoalesceSlot& slot = *staging_.slot;
+        uint64_t seq = (++coalesce_seq_) << 1;
+        uint64_t prev = slot.latest.load(std::memory_order_acquire);
+        bool superseded = prev != 0 && (prev & CoalesceSlot::CONSUMED) == 0 &&
+                          slot.latest.compare_exchange_strong(prev, seq, std::memory_order_acq_rel);
+        if (!superseded) {
+            slot.latest.store(seq, std::memory_order_release);
+        }
 
-        while (std::getline(iss, line)) {
-            // Remove trailing newline/carriage return
-            while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
-                line.pop_back();
+        if (accumulate) {
+            int delta = cmd.params["delta"].get<int>();
+            if (superseded) {
+                // Both are within +-100, and a sum beyond that moves
+                // brightness (0-100) no further, so saturate there
+                delta = std::max(-100, std::min(100, delta + slot.pending_delta));
+                cmd.params["delta"] = delta;
             }
+            slot.pending_delta = delta;
+        }
+        if (superseded) {
+            superseded_queued_.fetch_add(1, std::memory_order_relaxed);
+            answerSuperseded(slot.latest_client, slot.latest_id, cmd.type);
+        }
+        slot.latest_client = staging_.client_id;
+        slot.latest_id = cmd.id;
+        staging_.coalesce_seq = seq;
+    }
 
-            if (line.empty()) {
-                continue;
+    newest_seq_ = staging_.coalesce_seq;
+    command_queue_.push(staging_);
+    conn.pending++;
+    command_event_.signal();
+}
+
+bool ControlInterface::replaceNewest(Connection& conn, bool accumulate) {
+    CoalesceSlot& slot = *staging_.slot;
+    uint64_t seq = slot.latest.load(std::memory_order_acquire);
+    if (seq == 0 || seq != newest_seq_) {
+        return false;  // Taken by the main loop, or not the last entry queued
+    }
+
+    protocol::ParsedCommand& cmd = staging_.command;
+    protocol::CommandType type = cmd.type;
+    ClientId superseded_client = slot.latest_client;
+    {
+        std::lock_guard<std::mutex> lock(slot.replace_mutex);
+        if (slot.latest.load(std::memory_order_acquire) != seq) {
+            return false;  // The main loop took it meanwhile
+        }
+        if (accumulate) {
+            // Saturated at +-100 as when superseding
+            int delta = std::max(-100, std::min(100, cmd.params["delta"].get<int>() +
+                                                         slot.pending_delta));
+            cmd.params["delta"] = delta;
+            slot.pending_delta = delta;
+        }
+        // The superseded request's id comes back in superseded_id_
+        superseded_id_.swap(slot.latest_id);
+        slot.latest_id = cmd.id;
+        slot.latest_client = staging_.client_id;
+
+        std::swap(slot.replacement, cmd);
+        slot.replacement_client = staging_.client_id;
+        slot.replacement_at = staging_.enqueued_at;
+        slot.replaced_seq = seq;
+    }
+
+    answerSuperseded(superseded_client, superseded_id_, type);
+    conn.pending++;
+    return true;
+}
+
+ControlInterface::CoalesceSlot* ControlInterface::coalesceSlotFor(const Connection& conn,
+                                                                  const protocol::CommandSpec* spec) {
+    int kind = spec != nullptr ? protocol::coalesceSlot(*spec) : -1;
+    if (kind < 0 || coalesce_slots_.empty()) {
+        return nullptr;
+    }
+    size_t group = 0;
+    if (config_.command_coalescing == "per_client") {
+        group = static_cast<size_t>(&conn - clients_.data());
+    }
+    return &coalesce_slots_[group * protocol::COALESCE_SLOT_COUNT + static_cast<size_t>(kind)];
+}
+
+void ControlInterface::answerSuperseded(ClientId client_id, const std::string& request_id,
+                                        protocol::CommandType type) {
+    // The superseded entry stays in the queue and is skipped when dequeued;
+    // its client gets its answer now rather than never.
+    Connection* conn = findClient(client_id);
+    if (conn == nullptr) {
+        return;
+    }
+    if (conn->pending > 0) {
+        conn->pending--;
+    }
+
+    if (conn->encoding == protocol::Encoding::JSON) {
+        conn->out.clear();
+        protocol::writeCoalescedResponse(conn->out, request_id, type);
+        conn->out += '\n';
+        queueOutput(*conn, conn->out.data(), conn->out.size());
+    } else {
+        json data;
+        data["coalesced"] = true;
+        json message = protocol::makeResponse(
+            protocol::ResponseStatus::SUCCESS,
+            "Superseded by a newer " + protocol::commandTypeToString(type) + " command", data);
+        sendMessage(*conn, message, request_id);
+    }
+    if (conn->fd >= 0) {
+        finishIfDone(*conn);
+    }
+}
+
+ControlInterface::Connection* ControlInterface::findClient(ClientId client_id) {
+    uint32_t slot = static_cast<uint32_t>(client_id & 0xffffffffu);
+    uint32_t generation = static_cast<uint32_t>(client_id >> 32);
+    if (slot >= clients_.size()) {
+        return nullptr;
+    }
+    Connection& conn = clients_[slot];
+    if (conn.fd < 0 || conn.generation != generation) {
+        return nullptr;
+    }
+    return &conn;
+}
+
+ClientId ControlInterface::clientIdOf(const Connection& conn) const {
+    uint64_t slot = static_cast<uint64_t>(&conn - clients_.data());
+    return (static_cast<uint64_t>(conn.generation) << 32) | slot;
+}
+
+void ControlInterface::updateInterest(Connection& conn) {
+    uint32_t events = 0;
+    if (!conn.peer_closed) {
+        events |= EPOLLIN;
+    }
+    if (!conn.tx.empty()) {
+        events |= EPOLLOUT;
+    }
+    reactor_.modify(conn.fd, events, clientIdOf(conn));
+}
+
+void ControlInterface::queueOutput(Connection& conn, const char* data, size_t len) {
+    bool was_idle = conn.tx.empty();
+
+    if (was_idle) {
+        // Fast path: nothing queued ahead of us, try the socket directly
+        ssize_t sent = send(conn.fd, data, len, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG_DEBUG("ControlInterface", "Failed to send to client: " << strerror(errno));
+                closeClient(conn);
+                return;
             }
+            sent = 0;
+        }
+        if (static_cast<size_t>(sent) == len) {
+            return;
+        }
+        data += sent;
+        len -= static_cast<size_t>(sent);
+    }
 
-            LOG_DEBUG("ControlInterface", socket_type_str << " command: " << line);
-
-            // Queue command with client FD
-            {
-                std::lock_guard<std::mutex> lock(queue_mutex_);
-                CommandEntry entry;
-                entry.command = line;
-                entry.client_fd = client_fd;
-                entry.socket_type = socket_type;
-
-                // Coalesce brightness commands: if the new command is a brightness
-                // command, drop any pending brightness commands from the queue so
-                // only the latest one survives (avoids sluggish step-through on
-                // rapid presses).
-                // Coalesce absolute brightness commands: if the new command is
-                // set_brightness, drop any pending set_brightness commands so
-                // only the latest one survives. adjust_brightness (relative
-                // delta) is never coalesced — dropping deltas loses accumulated
-                // increments.
-                bool is_set_brightness = false;
-                try {
-                    auto parsed = protocol::parseCommand(line);
-                    is_set_brightness = (parsed.type == protocol::CommandType::SET_BRIGHTNESS);
-                } catch (...) {
-                    // Parse failed — not a brightness command, push as-is
-                }
+    if (conn.tx.size() + len > MAX_PENDING_OUTPUT) {
+        LOG_WARN("ControlInterface", "Client is not reading its responses ("
+                 << conn.tx.size() + len << " bytes pending), disconnecting");
+        closeClient(conn);
+        return;
+    }
 
-                if (is_set_brightness) {
-                    command_queue_.erase(
-                        std::remove_if(command_queue_.begin(), command_queue_.end(),
-                            [](const CommandEntry& queued) {
-                                try {
-                                    auto cmd = protocol::parseCommand(queued.command);
-                                    return cmd.type == protocol::CommandType::SET_BRIGHTNESS;
-                                } catch (...) {
-                                    return false;
-                                }
-                            }),
-                        command_queue_.end());
-                    LOG_DEBUG("ControlInterface", "Coalesced pending set_brightness commands");
-                }
+    conn.tx.append(data, len);
+    if (was_idle) {
+        updateInterest(conn);
+    }
+}
 
-                command_queue_.push_back(entry);
+void ControlInterface::flushClient(Connection& conn) {
+    while (!conn.tx.empty()) {
+        ssize_t sent = send(conn.fd, conn.tx.data(), conn.tx.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (sent < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                return;  // Still full; EPOLLOUT stays armed
             }
+            LOG_DEBUG("ControlInterface", "Failed to send to client: " << strerror(errno));
+            closeClient(conn);
+            return;
         }
+        conn.tx.erase(0, static_cast<size_t>(sent));
     }
 
-    LOG_DEBUG("ControlInterface", socket_type_str << " client disconnected");
+    updateInterest(conn);
+    finishIfDone(conn);
 
-    // Check if there are still queued commands from this client.
-    // If so, mark them for deferred close — the main loop will close
-    // the FD after sending the response. Otherwise close now.
-    {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        bool has_pending = false;
-        for (auto& entry : command_queue_) {
-            if (entry.client_fd == client_fd) {
-                entry.close_after_response = true;
-                has_pending = true;
+    // Events held back while this subscriber was not reading
+    if (conn.fd >= 0 && conn.sub.topics != 0 && status_.version() != 0) {
+        pushEvents(conn, status_.load(), std::chrono::steady_clock::now());
+    }
+}
+
+void ControlInterface::finishIfDone(Connection& conn) {
+    if (conn.fd >= 0 && conn.peer_closed && conn.pending == 0 && conn.tx.empty()) {
+        closeClient(conn);
+    }
+}
+
+void ControlInterface::closeClient(Connection& conn) {
+    if (conn.sub.topics != 0) {
+        subscribers_--;
+    }
+    reactor_.remove(conn.fd);
+    close(conn.fd);
+    conn.fd = -1;
+    conn.pending = 0;
+    conn.peer_closed = false;
+    conn.tx.clear();  // Keeps its capacity for the slot's next client
+    conn.sub.topics = 0;
+}
+
+void ControlInterface::subscribe(Connection& conn, const protocol::ParsedCommand& cmd) {
+    Subscription sub;
+    const json& params = cmd.params;
+    std::string error;
+
+    if (!params.contains("topics")) {
+        sub.topics = (1u << TOPIC_COUNT) - 1;  // Everything
+    } else if (params["topics"].empty()) {
+        error = "'topics' must be a non-empty array";
+    } else {
+        for (const auto& topic : params["topics"]) {
+            uint32_t t = 0;
+            while (t < TOPIC_COUNT && !(topic.is_string() && topic.get<std::string>() == TOPIC_NAMES[t])) {
+                ++t;
+            }
+            if (t == TOPIC_COUNT) {
+                error = "Unknown topic '" + (topic.is_string() ? topic.get<std::string>() : topic.dump()) +
+                        "' (brightness, mode, zone, lux, thermal, sensor)";
+                break;
             }
+            sub.topics |= 1u << t;
         }
-        if (!has_pending) {
-            close(client_fd);
+    }
+
+    // Types and the min_interval_ms range were checked against the schema
+    if (params.contains("min_interval_ms")) {
+        sub.min_interval_ms = params["min_interval_ms"].get<int>();
+    }
+
+    if (error.empty() && params.contains("thresholds")) {
+        const json& th = params["thresholds"];
+        for (auto it = th.begin(); it != th.end() && error.empty(); ++it) {
+            if (!it.value().is_number() || it.value().get<double>() < 0.0) {
+                error = "Threshold '" + it.key() + "' must be a non-negative number";
+            } else if (it.key() == "lux") {
+                sub.lux_threshold_percent = it.value().get<float>();
+            } else if (it.key() == "brightness") {
+                sub.brightness_threshold = std::max(1, static_cast<int>(it.value().get<double>()));
+            } else if (it.key() == "thermal") {
+                sub.thermal_threshold_c = it.value().get<double>();
+            } else {
+                error = "Unknown threshold '" + it.key() + "' (lux, brightness, thermal)";
+            }
         }
     }
 
-    // Remove from client_fds_
-    {
-        std::lock_guard<std::mutex> lock(clients_mutex_);
-        client_fds_.erase(std::remove(client_fds_.begin(), client_fds_.end(), client_fd), client_fds_.end());
+    if (!error.empty()) {
+        reply(conn, protocol::generateErrorResponse(error, "INVALID_PARAMS"), cmd.id);
+        return;
+    }
+
+    if (conn.sub.topics == 0) {
+        subscribers_++;
+    }
+    conn.sub = sub;
+
+    json data;
+    data["topics"] = json::array();
+    for (uint32_t t = 0; t < TOPIC_COUNT; ++t) {
+        if (sub.topics & (1u << t)) {
+            data["topics"].push_back(TOPIC_NAMES[t]);
+        }
+    }
+    data["min_interval_ms"] = sub.min_interval_ms;
+    reply(conn, protocol::generateResponse(protocol::ResponseStatus::SUCCESS, "Subscribed", data),
+          cmd.id);
+
+    // Current values right away, so the client doesn't start blind
+    if (conn.fd >= 0 && status_.version() != 0) {
+        pushEvents(conn, status_.load(), std::chrono::steady_clock::now());
     }
 }
 
-bool ControlInterface::hasCommand() {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    return !command_queue_.empty();
+void ControlInterface::unsubscribe(Connection& conn, const protocol::ParsedCommand& cmd) {
+    if (conn.sub.topics != 0) {
+        subscribers_--;
+    }
+    conn.sub = Subscription();
+    reply(conn, protocol::generateResponse(protocol::ResponseStatus::SUCCESS, "Unsubscribed"),
+          cmd.id);
 }
 
-QueuedCommand ControlInterface::getNextCommand() {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    if (command_queue_.empty()) {
-        return QueuedCommand{"", -1, false};
+void ControlInterface::pushEvents() {
+    if (status_.version() == 0) {
+        return;
     }
+    SystemStatus status = status_.load();
+    auto now = std::chrono::steady_clock::now();
 
-    QueuedCommand result;
-    result.command = command_queue_.front().command;
-    result.client_fd = command_queue_.front().client_fd;
-    result.close_after_response = command_queue_.front().close_after_response;
-    command_queue_.erase(command_queue_.begin());
-    return result;
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (auto& conn : clients_) {
+        if (conn.fd >= 0 && conn.sub.topics != 0) {
+            pushEvents(conn, status, now);
+        }
+    }
 }
 
-void ControlInterface::sendResponseTo(int client_fd, const std::string& response) {
-    std::string msg = response + "\n";
+void ControlInterface::pushEvents(Connection& conn, const SystemStatus& status,
+                                  std::chrono::steady_clock::time_point now) {
+    // Still sending earlier output: hold off, flushClient() comes back here
+    if (!conn.tx.empty()) {
+        return;
+    }
+
+    Subscription& sub = conn.sub;
+    const SystemStatus& sent = sub.sent;
+    const auto hold_off = std::chrono::milliseconds(sub.min_interval_ms);
+    const bool calibrated = lut_ != nullptr && lut_->is_loaded();
 
-    if (client_fd >= 0) {
-        ssize_t sent = send(client_fd, msg.c_str(), msg.length(), MSG_NOSIGNAL);
-        if (sent < 0) {
-            LOG_ERROR("ControlInterface", "Failed to send to client fd " << client_fd << ": " << strerror(errno));
+    for (uint32_t t = 0; t < TOPIC_COUNT && conn.fd >= 0; ++t) {
+        if (!(sub.topics & (1u << t))) {
+            continue;
+        }
+
+        bool changed = !sub.primed;
+        if (!changed) {
+            switch (t) {
+                case TOPIC_BRIGHTNESS:
+                    changed = std::abs(status.current_brightness - sent.current_brightness) >=
+                              sub.brightness_threshold;
+                    break;
+                case TOPIC_MODE:
+                    changed = status.mode != sent.mode;
+                    break;
+                case TOPIC_ZONE:
+                    changed = std::strcmp(status.zone, sent.zone) != 0;
+                    break;
+                case TOPIC_LUX:
+                    // Relative: 10% means the same at 5 lux as at 5000
+                    changed = status.lux != sent.lux &&
+                              std::fabs(status.lux - sent.lux) * 100.0f >=
+                                  sub.lux_threshold_percent * std::max(std::fabs(sent.lux), 1.0f);
+                    break;
+                case TOPIC_THERMAL:
+                    changed = status.thermal_has_reading != sent.thermal_has_reading ||
+                              (status.thermal_has_reading &&
+                               std::fabs(status.backlight_temp_c - sent.backlight_temp_c) >=
+                                   std::max(sub.thermal_threshold_c, 1e-6));
+                    break;
+                case TOPIC_SENSOR:
+                    changed = status.sensor_available != sent.sensor_available;
+                    break;
+                default:
+                    break;
+            }
+        }
+        if (!changed) {
+            continue;
+        }
+
+        if (sub.primed && now < sub.sent_at[t] + hold_off) {
+            scheduleEvents(sub.sent_at[t] + hold_off);
+            continue;
+        }
+
+        sendEvent(conn, t, status, calibrated);
+        sub.sent_at[t] = now;
+        switch (t) {
+            case TOPIC_BRIGHTNESS:
+                sub.sent.current_brightness = status.current_brightness;
+                break;
+            case TOPIC_MODE:
+                sub.sent.mode = status.mode;
+                break;
+            case TOPIC_ZONE:
+                std::memcpy(sub.sent.zone, status.zone, sizeof(status.zone));
+                break;
+            case TOPIC_LUX:
+                sub.sent.lux = status.lux;
+                break;
+            case TOPIC_THERMAL:
+                sub.sent.thermal_has_reading = status.thermal_has_reading;
+                sub.sent.backlight_temp_c = status.backlight_temp_c;
+                break;
+            case TOPIC_SENSOR:
+                sub.sent.sensor_available = status.sensor_available;
+                break;
+            default:
+                break;
         }
     }
+    sub.primed = true;
 }
 
-void ControlInterface::broadcast(const std::string& message) {
-    std::string msg = message + "\n";
+void ControlInterface::scheduleEvents(std::chrono::steady_clock::time_point deadline) {
+    if (deadline >= event_deadline_) {
+        return;  // Already waking up earlier
+    }
+    event_deadline_ = deadline;
+    auto delay_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    // Round up so the hold-off has surely ended; 0 would disarm
+    event_timer_.armOneShot(static_cast<int>(std::max<int64_t>(1, delay_ms + 1)));
+}
 
-    std::lock_guard<std::mutex> lock(clients_mutex_);
-    for (int fd : client_fds_) {
-        if (fd >= 0) {
-            ssize_t sent = send(fd, msg.c_str(), msg.length(), MSG_NOSIGNAL);
-            if (sent < 0) {
-                LOG_ERROR("ControlInterface", "Failed to broadcast to client: " << strerror(errno));
+bool ControlInterface::nextCommand(QueuedCommand& out) {
+    while (command_queue_.pop(drained_)) {
+        if (drained_.slot != nullptr) {
+            // Claim the entry; failing means the reactor superseded it (and
+            // already answered its client)
+            CoalesceSlot& slot = *drained_.slot;
+            uint64_t expected = drained_.coalesce_seq;
+            std::lock_guard<std::mutex> lock(slot.replace_mutex);
+            if (!slot.latest.compare_exchange_strong(
+                    expected, expected | CoalesceSlot::CONSUMED, std::memory_order_acq_rel)) {
+                superseded_queued_.fetch_sub(1, std::memory_order_relaxed);
+                continue;
+            }
+            // Replaced in place since it was queued: run the newest command
+            if (slot.replaced_seq == drained_.coalesce_seq) {
+                std::swap(drained_.command, slot.replacement);
+                drained_.client_id = slot.replacement_client;
+                drained_.enqueued_at = slot.replacement_at;
+            }
+        }
+
+        std::swap(out.command, drained_.command);
+        out.client_id = drained_.client_id;
+        out.enqueued_at = drained_.enqueued_at;
+        return true;
+    }
+    return false;
+}
+
+void ControlInterface::reply(Connection& conn, const std::string& msg, const std::string& request_id) {
+    if (conn.encoding != protocol::Encoding::JSON) {
+        // Responses built as text (mostly from the main loop) are
+        // re-encoded; the frequent ones go through sendMessage() directly
+        json message = json::parse(msg);
+        sendMessage(conn, message, request_id);
+        return;
+    }
+    conn.out.clear();
+    protocol::appendWithRequestId(conn.out, msg, request_id);
+    conn.out += '\n';
+    queueOutput(conn, conn.out.data(), conn.out.size());
+}
+
+void ControlInterface::sendMessage(Connection& conn, json& message, const std::string& request_id) {
+    std::string out;
+    if (conn.encoding == protocol::Encoding::JSON) {
+        // Same bytes as reply(): the id goes first
+        out = message.dump();
+        protocol::addRequestId(out, request_id);
+        out += '\n';
+    } else {
+        if (!request_id.empty()) {
+            message["id"] = json::parse(request_id);
+        }
+        protocol::encodeMessage(message, conn.encoding, out);
+    }
+    queueOutput(conn, out.data(), out.size());
+}
+
+void ControlInterface::sendStatus(Connection& conn, const SystemStatus& status,
+                                  const std::string& request_id) {
+    if (conn.encoding != protocol::Encoding::JSON) {
+        json response = answerQuery(protocol::CommandType::GET_STATUS, status);
+        sendMessage(conn, response, request_id);
+        return;
+    }
+
+    // Same text as answerQuery(GET_STATUS).dump(), without building the DOM
+    const bool calibrated = lut_ != nullptr && lut_->is_loaded();
+    const bool thermal_enabled = thermal_ != nullptr && thermal_->isEnabled();
+    int64_t cache_age;
+    int64_t verified_age;
+    outputAgesNow(status, cache_age, verified_age);
+
+    conn.out.clear();
+    protocol::writeStatusResponse(
+        conn.out, request_id,
+        StateManager::modeName(status.mode),
+        status.current_brightness,
+        status.lux,
+        status.zone,
+        status.sensor_available ? "available" : "unavailable",
+        calibrated,
+        status.nits,
+        thermal_enabled,
+        status.thermal_has_reading,
+        status.thermal_has_reading ? status.backlight_temp_c : 0.0,
+        status.thermal_has_reading ? status.thermal_factor : 1.0,
+        cache_age,
+        verified_age);
+    conn.out += '\n';
+    queueOutput(conn, conn.out.data(), conn.out.size());
+}
+
+json ControlInterface::makeEvent(uint32_t topic, const SystemStatus& status, bool calibrated) {
+    json data;
+    switch (topic) {
+        case TOPIC_BRIGHTNESS:
+            data["brightness"] = status.current_brightness;
+            if (calibrated) {
+                data["nits"] = status.nits;
+            }
+            break;
+        case TOPIC_MODE:
+            data["mode"] = StateManager::modeName(status.mode);
+            break;
+        case TOPIC_ZONE:
+            data["zone"] = status.zone;
+            break;
+        case TOPIC_LUX:
+            data["lux"] = status.lux;
+            break;
+        case TOPIC_THERMAL:
+            if (status.thermal_has_reading) {
+                data["backlight_temp_c"] = status.backlight_temp_c;
+                data["thermal_factor"] = status.thermal_factor;
+            } else {
+                data["backlight_temp_c"] = nullptr;
+                data["thermal_factor"] = nullptr;
             }
+            break;
+        case TOPIC_SENSOR:
+            data["sensor_status"] = status.sensor_available ? "available" : "unavailable";
+            break;
+        default:
+            break;
+    }
+    json event;
+    event["version"] = PROTOCOL_VERSION;
+    event["event"] = TOPIC_NAMES[topic];
+    event["data"] = data;
+    return event;
+}
+
+void ControlInterface::writeEvent(std::string& out, uint32_t topic, const SystemStatus& status,
+                                  bool calibrated) {
+    // Keys in the DOM's sorted order
+    protocol::JsonWriter w(out);
+    w.beginObject().key("data").beginObject();
+    switch (topic) {
+        case TOPIC_BRIGHTNESS:
+            w.key("brightness").value(status.current_brightness);
+            if (calibrated) {
+                w.key("nits").value(status.nits);
+            }
+            break;
+        case TOPIC_MODE:
+            w.key("mode").value(StateManager::modeName(status.mode));
+            break;
+        case TOPIC_ZONE:
+            w.key("zone").value(status.zone);
+            break;
+        case TOPIC_LUX:
+            w.key("lux").value(static_cast<double>(status.lux));
+            break;
+        case TOPIC_THERMAL:
+            w.key("backlight_temp_c");
+            status.thermal_has_reading ? w.value(status.backlight_temp_c) : w.null();
+            w.key("thermal_factor");
+            status.thermal_has_reading ? w.value(status.thermal_factor) : w.null();
+            break;
+        case TOPIC_SENSOR:
+            w.key("sensor_status").value(status.sensor_available ? "available" : "unavailable");
+            break;
+        default:
+            break;
+    }
+    w.endObject()
+     .key("event").value(TOPIC_NAMES[topic])
+     .key("version").value(PROTOCOL_VERSION)
+     .endObject();
+}
+
+void ControlInterface::sendEvent(Connection& conn, uint32_t topic, const SystemStatus& status,
+                                 bool calibrated) {
+    if (conn.encoding != protocol::Encoding::JSON) {
+        json event = makeEvent(topic, status, calibrated);
+        sendMessage(conn, event, std::string());
+        return;
+    }
+
+    conn.out.clear();
+    writeEvent(conn.out, topic, status, calibrated);
+    conn.out += '\n';
+    queueOutput(conn, conn.out.data(), conn.out.size());
+}
+
+void ControlInterface::hello(Connection& conn, const protocol::ParsedCommand& cmd) {
+    protocol::Encoding encoding = conn.encoding;
+    if (cmd.params.contains("encoding")) {
+        const json& name = cmd.params["encoding"];
+        if (!protocol::stringToEncoding(name.get<std::string>(), encoding)) {
+            reply(conn, protocol::generateErrorResponse(
+                      "'encoding' must be \"json\", \"cbor\" or \"msgpack\"", "INVALID_PARAMS"),
+                  cmd.id);
+            return;
+        }
+    }
+
+    // Answered in the old encoding; everything after it uses the new one
+    json data;
+    data["encoding"] = protocol::encodingToString(encoding);
+    data["encodings"] = {"json", "cbor", "msgpack"};
+    data["max_frame_bytes"] = conn.rx.size() - protocol::FRAME_HEADER_BYTES;
+    reply(conn, protocol::generateResponse(protocol::ResponseStatus::SUCCESS, "Hello", data), cmd.id);
+    conn.encoding = encoding;
+}
+
+void ControlInterface::sendResponseTo(const QueuedCommand& request,
+                                      const protocol::Response& response) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    Connection* conn = findClient(request.client_id);
+    if (conn == nullptr) {
+        LOG_DEBUG("ControlInterface", "Dropping response for disconnected client");
+        return;
+    }
+
+    if (conn->pending > 0) {
+        conn->pending--;
+    }
+    conn->out.clear();
+    if (conn->encoding == protocol::Encoding::JSON) {
+        protocol::writeResponse(conn->out, request.command.id, response);
+        conn->out += '\n';
+        queueOutput(*conn, conn->out.data(), conn->out.size());
+    } else {
+        protocol::writeResponse(conn->out, std::string(), response);
+        json message = json::parse(conn->out);
+        sendMessage(*conn, message, request.command.id);
+    }
+    finishIfDone(*conn);
+}
+
+void ControlInterface::broadcast(const std::string& message) {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (auto& conn : clients_) {
+        if (conn.fd >= 0 && !conn.peer_closed) {
+            reply(conn, message, std::string());
         }
     }
 }
 
+void ControlInterface::setCalibration(const BrightnessToNitsLut* lut,
+                                      const ThermalCompensation* thermal,
+                                      const std::string& output_type) {
+    lut_ = lut;
+    thermal_ = thermal;
+    output_type_ = output_type;
+}
+
 void ControlInterface::updateStatus(const SystemStatus& status) {
-    std::lock_guard<std::mutex> lock(status_mutex_);
-    status_ = status;
+    status_.store(status);
+    if (subscribers_.load(std::memory_order_relaxed) > 0) {
+        status_event_.signal();
+    }
 }
 
-std::string ControlInterface::processJsonCommand(const std::string& json_command) {
-    try {
-        // Parse the JSON command
-        protocol::ParsedCommand cmd = protocol::parseCommand(json_command);
-
-        // Check protocol version compatibility
-        if (!cmd.version.empty() && cmd.version != PROTOCOL_VERSION) {
-            LOG_WARN("ControlInterface", "Protocol version mismatch: client="
-                     << cmd.version << " server=" << PROTOCOL_VERSION);
-        }
-
-        // Process command based on type
-        switch (cmd.type) {
-            case protocol::CommandType::GET_STATUS: {
-                std::lock_guard<std::mutex> lock(status_mutex_);
-
-                // Convert internal OperatingMode to string for status response
-                std::string mode_str;
-                switch (status_.mode) {
-                    case OperatingMode::AUTO:
-                        mode_str = "auto";
-                        break;
-                    case OperatingMode::MANUAL:
-                        mode_str = "manual";
-                        break;
-                    case OperatingMode::MANUAL_TEMPORARY:
-                        mode_str = "manual_temporary";
-                        break;
+bool ControlInterface::isQuery(protocol::CommandType type) {
+    const protocol::CommandSpec* spec = protocol::commandSpec(type);
+    return spec != nullptr && spec->route == protocol::Route::QUERY;
+}
+
+json ControlInterface::answerQuery(protocol::CommandType type, const SystemStatus& status) const {
+    using namespace protocol;
+
+    const bool calibrated = lut_ != nullptr && lut_->is_loaded();
+    const bool thermal_enabled = thermal_ != nullptr && thermal_->isEnabled();
+
+    switch (type) {
+        case CommandType::GET_STATUS: {
+            int64_t cache_age;
+            int64_t verified_age;
+            outputAgesNow(status, cache_age, verified_age);
+
+            return makeStatusResponse(
+                StateManager::modeName(status.mode),
+                status.current_brightness,
+                status.lux,
+                status.zone,
+                status.sensor_available ? "available" : "unavailable",
+                calibrated,
+                status.nits,
+                thermal_enabled,
+                status.thermal_has_reading,
+                status.thermal_has_reading ? status.backlight_temp_c : 0.0,
+                status.thermal_has_reading ? status.thermal_factor : 1.0,
+                cache_age,
+                verified_age);
+        }
+
+        case CommandType::GET_CONFIG: {
+            json data;
+            data["mode"] = StateManager::modeToString(status.mode);
+            data["manual_brightness"] = status.manual_brightness;
+            data["last_auto_brightness"] = status.last_auto_brightness;
+            data["output_type"] = output_type_;
+            data["calibrated"] = calibrated;
+            if (calibrated) {
+                // LUT-intrinsic min/max - constant for the panel,
+                // does NOT vary with thermal compensation. Slider
+                // UIs reading this can rely on a stable range.
+                data["calibration_min_nits"] = lut_->min_nits();
+                data["calibration_max_nits"] = lut_->max_nits();
+                if (!lut_->label().empty()) {
+                    data["calibration_label"] = lut_->label();
                 }
+            }
+            // Thermal-compensation diagnostics (additive).
+            data["thermal_enabled"] = thermal_enabled;
+            if (thermal_enabled) {
+                data["thermal_reference_temp_c"] = thermal_->referenceTempC();
+                data["thermal_factor_min"] = thermal_->minFactor();
+                data["thermal_factor_max"] = thermal_->maxFactor();
+                if (!thermal_->label().empty()) {
+                    data["thermal_label"] = thermal_->label();
+                }
+            }
+            return makeResponse(ResponseStatus::SUCCESS, "Configuration retrieved successfully", data);
+        }
 
-                return protocol::generateStatusResponse(
-                    mode_str,
-                    status_.current_brightness,
-                    status_.lux,
-                    status_.zone
-                );
-            }
-
-            case protocol::CommandType::SET_MODE:
-            case protocol::CommandType::SET_BRIGHTNESS:
-            case protocol::CommandType::ADJUST_BRIGHTNESS:
-            case protocol::CommandType::GET_CONFIG:
-                // These will be handled in main.cpp
-                return protocol::generateResponse(
-                    protocol::ResponseStatus::SUCCESS,
-                    "Command queued for processing",
-                    nlohmann::json::object()
-                );
-
-            case protocol::CommandType::UNKNOWN:
-            default:
-                return protocol::generateErrorResponse(
-                    "Unknown command type",
-                    "UNKNOWN_COMMAND"
-                );
+        case CommandType::GET_CALIBRATION_INFO: {
+            json data;
+            data["calibrated"] = calibrated;
+            if (calibrated) {
+                // LUT-intrinsic values - constant for the panel.
+                data["min_nits"] = lut_->min_nits();
+                data["max_nits"] = lut_->max_nits();
+                data["label"] = lut_->label();
+                data["output_type"] = lut_->output_type_tag();
+                data["row_count"] = static_cast<int>(lut_->row_count());
+            } else {
+                data["min_nits"] = nullptr;
+                data["max_nits"] = nullptr;
+                data["label"] = "";
+                data["output_type"] = "";
+                data["row_count"] = 0;
+            }
+            // Thermal-compensation diagnostics (additive). Old clients
+            // that don't read these keys are unaffected.
+            data["thermal_enabled"] = thermal_enabled;
+            if (thermal_enabled) {
+                data["thermal_label"] = thermal_->label();
+                data["thermal_reference_temp_c"] = thermal_->referenceTempC();
+                data["thermal_factor_min"] = thermal_->minFactor();
+                data["thermal_factor_max"] = thermal_->maxFactor();
+                data["thermal_row_count"] = static_cast<int>(thermal_->rowCount());
+                if (status.thermal_has_reading) {
+                    data["backlight_temp_c"] = status.backlight_temp_c;
+                    data["thermal_factor"] = status.thermal_factor;
+                } else {
+                    data["backlight_temp_c"] = nullptr;
+                    data["thermal_factor"] = nullptr;
+                }
+            }
+            return makeResponse(ResponseStatus::SUCCESS, "Calibration info retrieved", data);
         }
 
-    } catch (const nlohmann::json::parse_error& e) {
-        LOG_ERROR("ControlInterface", "JSON parse error: " << e.what());
-        return protocol::generateErrorResponse(
-            std::string("Invalid JSON: ") + e.what(),
-            "PARSE_ERROR"
-        );
-    } catch (const std::exception& e) {
-        LOG_ERROR("ControlInterface", "Command processing error: " << e.what());
-        return protocol::generateErrorResponse(
-            std::string("Internal error: ") + e.what(),
-            "INTERNAL_ERROR"
-        );
+        case CommandType::GET_ABSOLUTE_BRIGHTNESS: {
+            json data;
+            data["brightness_pct"] = status.current_brightness;
+            data["calibrated"] = calibrated;
+            if (calibrated) {
+                data["nits"] = status.nits;
+            } else {
+                data["nits"] = nullptr;
+            }
+            return makeResponse(ResponseStatus::SUCCESS, "Absolute brightness retrieved", data);
+        }
+
+        default:
+            return makeErrorResponse("Unknown command type", "UNKNOWN_COMMAND");
     }
 }
 
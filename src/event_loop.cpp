@@ -0,0 +1,194 @@
+#include "als-dimmer/event_loop.hpp"
+#include "als-dimmer/logger.hpp"
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+namespace als_dimmer {
+
+// ============================================================================
+// EventLoop
+// ============================================================================
+
+EventLoop::EventLoop() : epoll_fd_(-1) {
+}
+
+EventLoop::~EventLoop() {
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool EventLoop::init() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        LOG_ERROR("EventLoop", "epoll_create1 failed: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool EventLoop::add(int fd, uint32_t events, uint64_t token) {
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u64 = token;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        LOG_ERROR("EventLoop", "epoll_ctl(ADD, fd " << fd << ") failed: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool EventLoop::modify(int fd, uint32_t events, uint64_t token) {
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    ev.events = events;
+    ev.data.u64 = token;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) < 0) {
+        LOG_ERROR("EventLoop", "epoll_ctl(MOD, fd " << fd << ") failed: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::remove(int fd) {
+    // Kernels before 2.6.9 required a non-null event pointer for DEL
+    struct epoll_event ev;
+    std::memset(&ev, 0, sizeof(ev));
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &ev);
+}
+
+int EventLoop::wait(Event* out, int max_events, int timeout_ms) {
+    static constexpr int MAX_BATCH = 32;
+    struct epoll_event evs[MAX_BATCH];
+    if (max_events > MAX_BATCH) {
+        max_events = MAX_BATCH;
+    }
+
+    int n = epoll_wait(epoll_fd_, evs, max_events, timeout_ms);
+    if (n < 0) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        LOG_ERROR("EventLoop", "epoll_wait failed: " << strerror(errno));
+        return -1;
+    }
+
+    for (int i = 0; i < n; ++i) {
+        out[i].token = evs[i].data.u64;
+        out[i].events = evs[i].events;
+    }
+    return n;
+}
+
+// ============================================================================
+// TimerFd
+// ============================================================================
+
+TimerFd::TimerFd() : fd_(-1) {
+}
+
+TimerFd::~TimerFd() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool TimerFd::init() {
+    fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd_ < 0) {
+        LOG_ERROR("TimerFd", "timerfd_create failed: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+static struct timespec msToTimespec(int ms) {
+    struct timespec ts;
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = static_cast<long>(ms % 1000) * 1000000L;
+    return ts;
+}
+
+bool TimerFd::armPeriodic(int interval_ms) {
+    struct itimerspec spec;
+    spec.it_interval = msToTimespec(interval_ms);
+    spec.it_value = msToTimespec(interval_ms);
+    if (timerfd_settime(fd_, 0, &spec, nullptr) < 0) {
+        LOG_ERROR("TimerFd", "timerfd_settime failed: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool TimerFd::armOneShot(int delay_ms) {
+    struct itimerspec spec;
+    spec.it_interval = msToTimespec(0);
+    spec.it_value = msToTimespec(delay_ms);
+    if (timerfd_settime(fd_, 0, &spec, nullptr) < 0) {
+        LOG_ERROR("TimerFd", "timerfd_settime failed: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool TimerFd::disarm() {
+    return armOneShot(0);
+}
+
+uint64_t TimerFd::consume() {
+    uint64_t expirations = 0;
+    ssize_t n = read(fd_, &expirations, sizeof(expirations));
+    if (n != static_cast<ssize_t>(sizeof(expirations))) {
+        return 0;  // EAGAIN: nothing expired yet
+    }
+    return expirations;
+}
+
+// ============================================================================
+// EventFd
+// ============================================================================
+
+EventFd::EventFd() : fd_(-1) {
+}
+
+EventFd::~EventFd() {
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool EventFd::init() {
+    fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd_ < 0) {
+        LOG_ERROR("EventFd", "eventfd failed: " << strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void EventFd::signal() {
+    if (fd_ < 0) {
+        return;
+    }
+    uint64_t one = 1;
+    // EAGAIN only happens when the counter would overflow, in which case
+    // the reader is already guaranteed to wake up - safe to ignore.
+    ssize_t n = write(fd_, &one, sizeof(one));
+    (void)n;
+}
+
+uint64_t EventFd::consume() {
+    uint64_t value = 0;
+    ssize_t n = read(fd_, &value, sizeof(value));
+    if (n != static_cast<ssize_t>(sizeof(value))) {
+        return 0;
+    }
+    return value;
+}
+
+} // namespace als_dimmer
@@ -1,14 +1,37 @@
 #include "als-dimmer/json_protocol.hpp"
+#include "als-dimmer/command_registry.hpp"
+#include <cmath>
+#include <cstdio>
 #include <sstream>
+#include <stdexcept>
 
 namespace als_dimmer {
 namespace protocol {
 
 ParsedCommand parseCommand(const std::string& json_str) {
-    ParsedCommand cmd;
+    return parseCommand(json_str.data(), json_str.size());
+}
 
-    // Parse JSON string
-    json j = json::parse(json_str);
+namespace {
+
+// One command object, already parsed as JSON, into `cmd`. The id comes
+// first so that it is known when anything after it throws.
+void fromJson(const json& j, ParsedCommand& cmd) {
+    cmd.type = CommandType::UNKNOWN;
+    cmd.spec = nullptr;
+    cmd.id.clear();
+    cmd.batch.clear();
+    cmd.bare_batch = false;
+
+    // Optional request id, echoed in the response so a client with several
+    // requests in flight can tell which one was answered
+    if (j.contains("id")) {
+        const json& id = j["id"];
+        if (!id.is_string() && !id.is_number()) {
+            throw std::invalid_argument("'id' must be a string or a number");
+        }
+        cmd.id = id.dump();
+    }
 
     // Check protocol version
     if (j.contains("version")) {
@@ -19,46 +42,122 @@ ParsedCommand parseCommand(const std::string& json_str) {
 
     // Get command type
     if (!j.contains("command")) {
-        cmd.type = CommandType::UNKNOWN;
-        return cmd;
-    }
-
-    std::string command_str = j["command"].get<std::string>();
-
-    // Map command string to CommandType
-    if (command_str == "get_status") {
-        cmd.type = CommandType::GET_STATUS;
-    } else if (command_str == "set_mode") {
-        cmd.type = CommandType::SET_MODE;
-    } else if (command_str == "set_brightness") {
-        cmd.type = CommandType::SET_BRIGHTNESS;
-    } else if (command_str == "adjust_brightness") {
-        cmd.type = CommandType::ADJUST_BRIGHTNESS;
-    } else if (command_str == "get_config") {
-        cmd.type = CommandType::GET_CONFIG;
-    } else if (command_str == "get_absolute_brightness") {
-        cmd.type = CommandType::GET_ABSOLUTE_BRIGHTNESS;
-    } else if (command_str == "set_absolute_brightness") {
-        cmd.type = CommandType::SET_ABSOLUTE_BRIGHTNESS;
-    } else if (command_str == "get_calibration_info") {
-        cmd.type = CommandType::GET_CALIBRATION_INFO;
-    } else {
-        cmd.type = CommandType::UNKNOWN;
+        return;
+    }
+
+    // Map the command name through the registry's perfect hash
+    const json& name = j["command"];
+    if (name.is_string()) {
+        const std::string& command_str = name.get_ref<const std::string&>();
+        cmd.spec = findCommand(command_str.data(), command_str.size());
+    }
+    if (cmd.spec == nullptr) {
+        return;
     }
+    cmd.type = cmd.spec->type;
 
-    // Extract parameters if present
+    // Extract parameters if present, checked against the command's schema
     if (j.contains("params")) {
         cmd.params = j["params"];
     } else {
         cmd.params = json::object();
     }
+    validateParams(*cmd.spec, cmd.params);
+}
+
+// Fill batch.batch from a JSON array of command objects. Every entry is
+// checked here, before anything runs, so a batch is either rejected as a
+// whole or executed as a whole.
+void parseBatch(const json& commands, ParsedCommand& batch) {
+    if (!commands.is_array() || commands.empty()) {
+        throw std::invalid_argument("A batch must be a non-empty array of commands");
+    }
+
+    batch.batch.clear();
+    batch.batch.reserve(commands.size());
+    for (size_t i = 0; i < commands.size(); ++i) {
+        std::string where = "Batch entry " + std::to_string(i + 1) + ": ";
+        if (!commands[i].is_object()) {
+            throw std::invalid_argument(where + "not a command object");
+        }
+        batch.batch.emplace_back();
+        try {
+            fromJson(commands[i], batch.batch.back());
+        } catch (const ParamError& e) {
+            throw ParamError(where + e.what());
+        }
+        const ParsedCommand& entry = batch.batch.back();
+        if (entry.spec == nullptr) {
+            throw std::invalid_argument(where + "unknown command");
+        }
+        if (!entry.spec->batchable) {
+            throw std::invalid_argument(where + entry.spec->name + " cannot be batched");
+        }
+    }
+}
+
+} // namespace
+
+ParsedCommand parseCommand(const char* data, size_t len) {
+    // Parse JSON text
+    return parseCommand(json::parse(data, data + len));
+}
+
+ParsedCommand parseCommand(const char* data, size_t len, Encoding encoding) {
+    ParsedCommand cmd;
+    parseCommand(data, len, encoding, cmd);
+    return cmd;
+}
 
+ParsedCommand parseCommand(const json& j) {
+    ParsedCommand cmd;
+    parseCommand(j, cmd);
     return cmd;
 }
 
+void parseCommand(const char* data, size_t len, Encoding encoding, ParsedCommand& out) {
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+    switch (encoding) {
+        case Encoding::CBOR:
+            parseCommand(json::from_cbor(bytes, bytes + len), out);
+            break;
+        case Encoding::MSGPACK:
+            parseCommand(json::from_msgpack(bytes, bytes + len), out);
+            break;
+        case Encoding::JSON:
+        default:
+            parseCommand(json::parse(data, data + len), out);
+            break;
+    }
+}
+
+void parseCommand(const json& j, ParsedCommand& out) {
+    // A bare array is shorthand for {"command":"batch","params":{"commands":[...]}}
+    if (j.is_array()) {
+        out.type = CommandType::BATCH;
+        out.spec = commandSpec(CommandType::BATCH);
+        out.version = "unknown";
+        out.id.clear();
+        out.params = json::object();
+        out.bare_batch = true;
+        parseBatch(j, out);
+        return;
+    }
+
+    fromJson(j, out);
+    if (out.type == CommandType::BATCH) {
+        parseBatch(out.params["commands"], out);
+        out.params.erase("commands");  // Now in out.batch
+    }
+}
+
 std::string generateResponse(ResponseStatus status,
                             const std::string& message,
                             const json& data) {
+    return makeResponse(status, message, data).dump();
+}
+
+json makeResponse(ResponseStatus status, const std::string& message, const json& data) {
     json response;
     response["version"] = PROTOCOL_VERSION;
     response["status"] = responseStatusToString(status);
@@ -68,7 +167,271 @@ std::string generateResponse(ResponseStatus status,
         response["data"] = data;
     }
 
-    return response.dump();
+    return response;
+}
+
+void addRequestId(std::string& response, const std::string& id) {
+    if (id.empty() || response.empty() || response[0] != '{') {
+        return;
+    }
+    bool empty_object = response.size() > 1 && response[1] == '}';
+    response.insert(1, "\"id\":" + id + (empty_object ? "" : ","));
+}
+
+void appendWithRequestId(std::string& out, const std::string& response, const std::string& id) {
+    if (id.empty() || response.empty() || response[0] != '{') {
+        out += response;
+        return;
+    }
+    out += "{\"id\":";
+    out += id;
+    if (response.size() > 1 && response[1] != '}') {
+        out += ',';
+    }
+    out.append(response, 1, std::string::npos);
+}
+
+JsonWriter& JsonWriter::beginObject() {
+    out_ += '{';
+    need_comma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+    out_ += '}';
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* name) {
+    if (need_comma_) {
+        out_ += ',';
+    }
+    out_ += '"';
+    out_ += name;  // Keys are literals; nothing to escape
+    out_ += "\":";
+    need_comma_ = false;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* s) {
+    // Escapes exactly what dump() escapes (with ensure_ascii off)
+    static const char hex[] = "0123456789abcdef";
+    out_ += '"';
+    for (const char* p = s; *p != '\0'; ++p) {
+        unsigned char c = static_cast<unsigned char>(*p);
+        switch (c) {
+            case '"':
+                out_ += "\\\"";
+                break;
+            case '\\':
+                out_ += "\\\\";
+                break;
+            case '\b':
+                out_ += "\\b";
+                break;
+            case '\f':
+                out_ += "\\f";
+                break;
+            case '\n':
+                out_ += "\\n";
+                break;
+            case '\r':
+                out_ += "\\r";
+                break;
+            case '\t':
+                out_ += "\\t";
+                break;
+            default:
+                if (c < 0x20) {
+                    out_ += "\\u00";
+                    out_ += hex[c >> 4];
+                    out_ += hex[c & 0x0f];
+                } else {
+                    out_ += static_cast<char>(c);
+                }
+                break;
+        }
+    }
+    out_ += '"';
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(bool b) {
+    out_ += b ? "true" : "false";
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(int64_t n) {
+    char buf[24];
+    char* end = buf + sizeof(buf);
+    char* p = end;
+    uint64_t u = n < 0 ? 0 - static_cast<uint64_t>(n) : static_cast<uint64_t>(n);
+    do {
+        *--p = static_cast<char>('0' + u % 10);
+        u /= 10;
+    } while (u != 0);
+    if (n < 0) {
+        *--p = '-';
+    }
+    out_.append(p, static_cast<size_t>(end - p));
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::value(double d) {
+    if (!std::isfinite(d)) {
+        return null();
+    }
+    // dump()'s own shortest round-trip formatter (Grisu2)
+    char buf[64];
+    char* end = nlohmann::detail::to_chars(buf, buf + sizeof(buf), d);
+    out_.append(buf, static_cast<size_t>(end - buf));
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::raw(const std::string& json_text) {
+    out_ += json_text;
+    need_comma_ = true;
+    return *this;
+}
+
+JsonWriter& JsonWriter::null() {
+    out_ += "null";
+    need_comma_ = true;
+    return *this;
+}
+
+namespace {
+
+// Everything after "data": of a success response
+void finishResponse(JsonWriter& w, const char* message) {
+    w.key("message").value(message)
+     .key("status").value("success")
+     .key("version").value(PROTOCOL_VERSION)
+     .endObject();
+}
+
+// "{", the request id first (as addRequestId() puts it), and the "data" key
+JsonWriter& beginResponse(JsonWriter& w, const std::string& id) {
+    w.beginObject();
+    if (!id.empty()) {
+        w.key("id").raw(id);
+    }
+    return w.key("data");
+}
+
+} // namespace
+
+void writeStatusResponse(std::string& out, const std::string& id,
+                         const char* mode,
+                         int current_brightness,
+                         float current_lux,
+                         const char* current_zone,
+                         const char* sensor_status,
+                         bool calibrated,
+                         double nits,
+                         bool thermal_enabled,
+                         bool thermal_has_reading,
+                         double backlight_temp_c,
+                         double thermal_factor,
+                         int64_t output_cache_age_ms,
+                         int64_t output_verified_age_ms) {
+    // Keys in makeStatusResponse()'s sorted order
+    JsonWriter w(out);
+    beginResponse(w, id).beginObject();
+    bool thermal_live = thermal_enabled && thermal_has_reading;
+    w.key("backlight_temp_c");
+    thermal_live ? w.value(backlight_temp_c) : w.null();
+    w.key("brightness").value(current_brightness);
+    w.key("calibrated").value(calibrated);
+    w.key("lux").value(static_cast<double>(current_lux));
+    w.key("mode").value(mode);
+    w.key("nits");
+    calibrated ? w.value(nits) : w.null();
+    w.key("output_cache_age_ms");
+    output_cache_age_ms >= 0 ? w.value(output_cache_age_ms) : w.null();
+    w.key("output_verified_age_ms");
+    output_verified_age_ms >= 0 ? w.value(output_verified_age_ms) : w.null();
+    w.key("sensor_status").value(sensor_status);
+    w.key("thermal_enabled").value(thermal_enabled);
+    w.key("thermal_factor");
+    thermal_live ? w.value(thermal_factor) : w.null();
+    w.key("zone").value(current_zone);
+    w.endObject();
+    finishResponse(w, "Status retrieved successfully");
+}
+
+void writeBrightnessResponse(std::string& out, const std::string& id, int brightness) {
+    JsonWriter w(out);
+    beginResponse(w, id).beginObject().key("brightness").value(brightness).endObject();
+    finishResponse(w, "Brightness set successfully");
+}
+
+void writeAdjustResponse(std::string& out, const std::string& id, int brightness, int delta) {
+    JsonWriter w(out);
+    beginResponse(w, id).beginObject()
+        .key("brightness").value(brightness)
+        .key("delta").value(delta)
+        .endObject();
+    finishResponse(w, "Brightness adjusted successfully");
+}
+
+void writeCoalescedResponse(std::string& out, const std::string& id, CommandType type) {
+    JsonWriter w(out);
+    beginResponse(w, id).beginObject().key("coalesced").value(true).endObject();
+    char message[64];
+    std::snprintf(message, sizeof(message), "Superseded by a newer %s command", commandTypeName(type));
+    finishResponse(w, message);
+}
+
+void writeBatchResponse(std::string& out, const std::string& id, const std::string& results,
+                        int errors) {
+    JsonWriter w(out);
+    beginResponse(w, id).beginObject()
+        .key("errors").value(errors)
+        .key("results").raw(results)
+        .endObject();
+    finishResponse(w, errors == 0 ? "Batch executed" : "Batch executed with errors");
+}
+
+void writeResponse(std::string& out, const std::string& id, const Response& response) {
+    switch (response.kind) {
+        case Response::Kind::BRIGHTNESS_SET:
+            writeBrightnessResponse(out, id, response.brightness);
+            break;
+        case Response::Kind::BRIGHTNESS_ADJUSTED:
+            writeAdjustResponse(out, id, response.brightness, response.delta);
+            break;
+        case Response::Kind::TEXT:
+        default:
+            appendWithRequestId(out, response.text, id);
+            break;
+    }
+}
+
+void encodeMessage(const json& message, Encoding encoding, std::string& out) {
+    if (encoding == Encoding::JSON) {
+        out += message.dump();
+        out += '\n';
+        return;
+    }
+
+    // Reserve the length prefix, encode straight after it, then fill it in
+    size_t header = out.size();
+    out.append(FRAME_HEADER_BYTES, '\0');
+    if (encoding == Encoding::CBOR) {
+        json::to_cbor(message, nlohmann::detail::output_adapter<char>(out));
+    } else {
+        json::to_msgpack(message, nlohmann::detail::output_adapter<char>(out));
+    }
+    uint32_t len = static_cast<uint32_t>(out.size() - header - FRAME_HEADER_BYTES);
+    for (size_t i = 0; i < FRAME_HEADER_BYTES; ++i) {
+        out[header + i] = static_cast<char>((len >> (8 * (FRAME_HEADER_BYTES - 1 - i))) & 0xff);
+    }
 }
 
 std::string generateStatusResponse(const std::string& mode,
@@ -81,7 +444,28 @@ std::string generateStatusResponse(const std::string& mode,
                                    bool thermal_enabled,
                                    bool thermal_has_reading,
                                    double backlight_temp_c,
-                                   double thermal_factor) {
+                                   double thermal_factor,
+                                   int64_t output_cache_age_ms,
+                                   int64_t output_verified_age_ms) {
+    return makeStatusResponse(mode, current_brightness, current_lux, current_zone, sensor_status,
+                              calibrated, nits, thermal_enabled, thermal_has_reading,
+                              backlight_temp_c, thermal_factor, output_cache_age_ms,
+                              output_verified_age_ms).dump();
+}
+
+json makeStatusResponse(const std::string& mode,
+                        int current_brightness,
+                        float current_lux,
+                        const std::string& current_zone,
+                        const std::string& sensor_status,
+                        bool calibrated,
+                        double nits,
+                        bool thermal_enabled,
+                        bool thermal_has_reading,
+                        double backlight_temp_c,
+                        double thermal_factor,
+                        int64_t output_cache_age_ms,
+                        int64_t output_verified_age_ms) {
     json data;
     data["mode"] = mode;  // Now accepts: "auto", "manual", or "manual_temporary"
     data["brightness"] = current_brightness;
@@ -107,10 +491,22 @@ std::string generateStatusResponse(const std::string& mode,
         data["backlight_temp_c"] = nullptr;
         data["thermal_factor"] = nullptr;
     }
+    // Output-state cache: `brightness` comes from the cache, these say how
+    // old it is and when the hardware last confirmed it.
+    if (output_cache_age_ms >= 0) {
+        data["output_cache_age_ms"] = output_cache_age_ms;
+    } else {
+        data["output_cache_age_ms"] = nullptr;
+    }
+    if (output_verified_age_ms >= 0) {
+        data["output_verified_age_ms"] = output_verified_age_ms;
+    } else {
+        data["output_verified_age_ms"] = nullptr;
+    }
 
-    return generateResponse(ResponseStatus::SUCCESS,
-                          "Status retrieved successfully",
-                          data);
+    return makeResponse(ResponseStatus::SUCCESS,
+                        "Status retrieved successfully",
+                        data);
 }
 
 std::string generateConfigResponse(const json& config_data) {
@@ -121,37 +517,54 @@ std::string generateConfigResponse(const json& config_data) {
 
 std::string generateErrorResponse(const std::string& error_message,
                                  const std::string& error_code) {
+    return makeErrorResponse(error_message, error_code).dump();
+}
+
+json makeErrorResponse(const std::string& error_message, const std::string& error_code) {
     json data;
     if (!error_code.empty()) {
         data["error_code"] = error_code;
     }
 
-    return generateResponse(ResponseStatus::ERROR,
-                          error_message,
-                          data);
+    return makeResponse(ResponseStatus::ERROR,
+                        error_message,
+                        data);
 }
 
 std::string commandTypeToString(CommandType type) {
-    switch (type) {
-        case CommandType::GET_STATUS:
-            return "get_status";
-        case CommandType::SET_MODE:
-            return "set_mode";
-        case CommandType::SET_BRIGHTNESS:
-            return "set_brightness";
-        case CommandType::ADJUST_BRIGHTNESS:
-            return "adjust_brightness";
-        case CommandType::GET_CONFIG:
-            return "get_config";
-        case CommandType::GET_ABSOLUTE_BRIGHTNESS:
-            return "get_absolute_brightness";
-        case CommandType::SET_ABSOLUTE_BRIGHTNESS:
-            return "set_absolute_brightness";
-        case CommandType::GET_CALIBRATION_INFO:
-            return "get_calibration_info";
-        case CommandType::UNKNOWN:
+    return commandTypeName(type);
+}
+
+const char* commandTypeName(CommandType type) {
+    const CommandSpec* spec = commandSpec(type);
+    if (spec != nullptr) {
+        return spec->name;
+    }
+    return type == CommandType::SHUTDOWN ? "shutdown" : "unknown";
+}
+
+bool stringToEncoding(const std::string& name, Encoding& out) {
+    if (name == "json") {
+        out = Encoding::JSON;
+    } else if (name == "cbor") {
+        out = Encoding::CBOR;
+    } else if (name == "msgpack") {
+        out = Encoding::MSGPACK;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+std::string encodingToString(Encoding encoding) {
+    switch (encoding) {
+        case Encoding::CBOR:
+            return "cbor";
+        case Encoding::MSGPACK:
+            return "msgpack";
+        case Encoding::JSON:
         default:
-            return "unknown";
+            return "json";
     }
 }
 
@@ -0,0 +1,131 @@
+#include "als-dimmer/loop_stats.hpp"
+#include "als-dimmer/logger.hpp"
+#include <algorithm>
+#include <limits>
+
+namespace als_dimmer {
+
+constexpr size_t LoopStats::WINDOW;
+
+namespace {
+
+// min/avg/max/p99 over the first n entries of values (n > 0). Works on a
+// stack copy so the ring order is left alone.
+void describe(const int32_t* values, size_t n,
+              int64_t& min_out, int64_t& avg_out, int64_t& max_out, int64_t& p99_out) {
+    int32_t sorted[LoopStats::WINDOW];
+    std::copy(values, values + n, sorted);
+
+    int64_t sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += sorted[i];
+    }
+    auto minmax = std::minmax_element(sorted, sorted + n);
+    min_out = *minmax.first;
+    max_out = *minmax.second;
+    avg_out = sum / static_cast<int64_t>(n);
+
+    // Nearest-rank p99
+    size_t rank = (n * 99 + 99) / 100;
+    size_t idx = rank > 0 ? rank - 1 : 0;
+    std::nth_element(sorted, sorted + idx, sorted + n);
+    p99_out = sorted[idx];
+}
+
+int32_t clampUs(int64_t us) {
+    return static_cast<int32_t>(std::min<int64_t>(us, std::numeric_limits<int32_t>::max()));
+}
+
+} // namespace
+
+LoopStats::LoopStats() {
+    reset();
+}
+
+void LoopStats::reset() {
+    next_ = 0;
+    count_ = 0;
+    interval_ms_ = 0;
+    have_last_tick_ = false;
+    reset_time_ = std::chrono::steady_clock::now();
+    ticks_ = 0;
+    missed_ticks_ = 0;
+    steps_ = 0;
+    overruns_ = 0;
+    work_sum_us_ = 0;
+    work_max_us_ = 0;
+}
+
+void LoopStats::onTick(std::chrono::steady_clock::time_point now, int interval_ms,
+                       uint64_t expirations) {
+    ticks_++;
+    interval_ms_ = interval_ms;
+    if (expirations > 1) {
+        missed_ticks_ += expirations - 1;
+        LOG_DEBUG("LoopStats", "Missed " << (expirations - 1) << " tick(s) at "
+                  << interval_ms << " ms interval");
+    }
+
+    if (have_last_tick_) {
+        int64_t period_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            now - last_tick_).count();
+        // A wakeup that swallowed several expirations spans several periods
+        period_us /= static_cast<int64_t>(std::max<uint64_t>(1, expirations));
+        int64_t jitter_us = period_us - static_cast<int64_t>(interval_ms) * 1000;
+        if (jitter_us < 0) {
+            jitter_us = -jitter_us;
+        }
+
+        periods_us_[next_] = clampUs(period_us);
+        jitter_us_[next_] = clampUs(jitter_us);
+        next_ = (next_ + 1) % WINDOW;
+        if (count_ < WINDOW) {
+            count_++;
+        }
+    }
+    last_tick_ = now;
+    have_last_tick_ = true;
+}
+
+void LoopStats::onScheduleChange() {
+    have_last_tick_ = false;
+}
+
+void LoopStats::onStep(std::chrono::steady_clock::time_point started,
+                       std::chrono::steady_clock::time_point finished,
+                       int budget_ms) {
+    int64_t work_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        finished - started).count();
+    steps_++;
+    work_sum_us_ += work_us;
+    work_max_us_ = std::max(work_max_us_, work_us);
+    if (work_us > static_cast<int64_t>(budget_ms) * 1000) {
+        overruns_++;
+        LOG_WARN("LoopStats", "Control step overran its budget: " << work_us / 1000
+                 << " ms > " << budget_ms << " ms");
+    }
+}
+
+LoopStats::Summary LoopStats::summarize() const {
+    Summary s = Summary();
+    s.interval_ms = interval_ms_;
+    s.samples = count_;
+    if (count_ > 0) {
+        describe(periods_us_, count_, s.period_min_us, s.period_avg_us,
+                 s.period_max_us, s.period_p99_us);
+        int64_t jitter_min_unused = 0;
+        describe(jitter_us_, count_, jitter_min_unused, s.jitter_avg_us,
+                 s.jitter_max_us, s.jitter_p99_us);
+    }
+    s.ticks = ticks_;
+    s.missed_ticks = missed_ticks_;
+    s.steps = steps_;
+    s.overruns = overruns_;
+    s.work_avg_us = steps_ > 0 ? work_sum_us_ / static_cast<int64_t>(steps_) : 0;
+    s.work_max_us = work_max_us_;
+    s.since_reset_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - reset_time_).count();
+    return s;
+}
+
+} // namespace als_dimmer
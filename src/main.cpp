@@ -7,12 +7,23 @@
 #include "als-dimmer/csv_logger.hpp"
 #include "als-dimmer/logger.hpp"
 #include "als-dimmer/json_protocol.hpp"
+#include "als-dimmer/command_registry.hpp"
 #include "als-dimmer/notifier.hpp"
 #include "als-dimmer/sensors/can_als_sensor.hpp"
 #include "als-dimmer/sensors/null_sensor.hpp"
 #include "als-dimmer/brightness_to_nits_lut.hpp"
 #include "als-dimmer/thermal_compensation.hpp"
 #include "als-dimmer/wp_adjust_restore.hpp"
+#include "als-dimmer/event_loop.hpp"
+#include "als-dimmer/tick_scheduler.hpp"
+#include "als-dimmer/sensor_sampler.hpp"
+#include "als-dimmer/ramp_engine.hpp"
+#include "als-dimmer/output_cache.hpp"
+#include "als-dimmer/loop_stats.hpp"
+#include "als-dimmer/metrics.hpp"
+#include "als-dimmer/alloc_check.hpp"
+#include "als-dimmer/realtime.hpp"
+#include "als-dimmer/status_page.hpp"
 #include "json.hpp"
 #include <iostream>
 #include <fstream>
@@ -24,7 +35,11 @@
 #include <csignal>
 #include <atomic>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <climits>
+#include <utility>
+#include <sys/epoll.h>
 
 using json = nlohmann::json;
 
@@ -155,6 +170,35 @@ void restoreWhitePointCalibration(als_dimmer::OutputInterface& output,
     }
 }
 
+// Rolling min/avg/max over a stream of latency samples (microseconds).
+// The main loop keeps one for tick wakeups and one for command pickup and
+// summarizes them in the debug log once a minute.
+struct LatencyWindow {
+    int64_t min_us = LLONG_MAX;
+    int64_t max_us = 0;
+    int64_t sum_us = 0;
+    uint64_t count = 0;
+
+    void add(int64_t us) {
+        if (us < min_us) min_us = us;
+        if (us > max_us) max_us = us;
+        sum_us += us;
+        count++;
+    }
+
+    void reset() {
+        *this = LatencyWindow();
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, const LatencyWindow& w) {
+    if (w.count == 0) {
+        return os << "n/a";
+    }
+    return os << w.min_us << "/" << (w.sum_us / static_cast<int64_t>(w.count))
+              << "/" << w.max_us << " us (n=" << w.count << ")";
+}
+
 } // namespace
 
 namespace als_dimmer {
@@ -312,357 +356,433 @@ void printUsage(const char* program_name) {
     std::cout << "  " << program_name << " --config configs/config.json --csvlog /tmp/data.csv --foreground\n";
 }
 
-// Process TCP commands
-std::string processCommand(const std::string& command,
-                          als_dimmer::StateManager& state_mgr,
-                          als_dimmer::ControlInterface& control,
-                          float current_lux,
-                          int current_brightness,
-                          std::chrono::steady_clock::time_point& manual_temp_start,
-                          als_dimmer::ZoneMapper* zone_mapper,
-                          bool& manual_override_occurred,
-                          std::string& manual_override_type,
-                          als_dimmer::Notifier& notifier,
-                          bool sensor_available,
-                          const als_dimmer::BrightnessToNitsLut& b2n_lut,
-                          const std::string& output_type,
-                          const als_dimmer::ThermalCompensation& thermal) {
-    (void)control;  // Reserved for future use (broadcasting status updates)
-
-    using namespace als_dimmer::protocol;
-
-    // Check if this is a JSON command (starts with '{')
-    if (!command.empty() && command[0] == '{') {
-        try {
-            // Parse JSON command
-            ParsedCommand parsed_cmd = parseCommand(command);
-
-            // Process JSON command based on type
-            switch (parsed_cmd.type) {
-                case CommandType::GET_STATUS: {
-                    std::string zone_name;
-                    if (zone_mapper) {
-                        zone_name = zone_mapper->getCurrentZoneName(current_lux);
-                    } else {
-                        zone_name = "simple";
-                    }
-
-                    // Convert internal OperatingMode to string for status response
-                    std::string mode_str;
-                    als_dimmer::OperatingMode current_mode = state_mgr.getMode();
-                    switch (current_mode) {
-                        case als_dimmer::OperatingMode::AUTO:
-                            mode_str = "auto";
-                            break;
-                        case als_dimmer::OperatingMode::MANUAL:
-                            mode_str = "manual";
-                            break;
-                        case als_dimmer::OperatingMode::MANUAL_TEMPORARY:
-                            mode_str = "manual_temporary";
-                            break;
-                    }
-
-                    bool calibrated = b2n_lut.is_loaded();
-                    double nits = 0.0;
-                    if (calibrated) {
-                        bool clamped_unused = false;
-                        nits = b2n_lut.pctToNits(static_cast<double>(current_brightness),
-                                                 clamped_unused);
-                        // Apply thermal correction so the reported nits matches
-                        // what a colorimeter would actually measure right now.
-                        // factor() returns 1.0 when thermal compensation is
-                        // disabled or has no temp reading - so when the feature
-                        // is off, this multiplication is a no-op and behavior
-                        // is bit-identical to before the feature was added.
-                        nits *= thermal.factor();
-                    }
-
-                    bool thermal_has_reading = thermal.hasReading();
-                    return generateStatusResponse(
-                        mode_str,
-                        current_brightness,
-                        current_lux,
-                        zone_name,
-                        sensor_available ? "available" : "unavailable",
-                        calibrated,
-                        nits,
-                        thermal.isEnabled(),
-                        thermal_has_reading,
-                        thermal_has_reading ? thermal.lastTempC() : 0.0,
-                        thermal_has_reading ? thermal.factor() : 1.0
-                    );
-                }
-
-                case CommandType::SET_MODE: {
-                    if (!parsed_cmd.params.contains("mode")) {
-                        return generateErrorResponse("Missing 'mode' parameter", "INVALID_PARAMS");
-                    }
-
-                    std::string mode_str = parsed_cmd.params["mode"].get<std::string>();
-                    if (mode_str == "manual_temporary") {
-                        return generateErrorResponse(
-                            "MANUAL_TEMPORARY is managed automatically; clients may only request 'auto' or 'manual'",
-                            "INVALID_PARAMS");
-                    }
-                    if (mode_str != "auto" && mode_str != "manual") {
-                        return generateErrorResponse("Mode must be 'auto' or 'manual'", "INVALID_PARAMS");
-                    }
-                    if (mode_str == "auto" && !sensor_available) {
-                        return generateErrorResponse(
-                            "Cannot switch to AUTO mode: ALS sensor unavailable",
-                            "SENSOR_UNAVAILABLE");
-                    }
+// Snapshot of the state the read-only queries report. Used both to publish
+// the per-iteration status and to answer a query queued behind a write.
+void fillStatus(als_dimmer::SystemStatus& status,
+                const als_dimmer::StateManager& state_mgr,
+                float current_lux,
+                int current_brightness,
+                als_dimmer::ZoneMapper* zone_mapper,
+                bool sensor_available,
+                const als_dimmer::BrightnessToNitsLut& b2n_lut,
+                const als_dimmer::ThermalCompensation& thermal,
+                const als_dimmer::CachedOutput& output_cache) {
+    status.mode = state_mgr.getMode();
+    status.lux = current_lux;
+    status.current_brightness = current_brightness;
+    status.manual_brightness = state_mgr.getManualBrightness();
+    status.last_auto_brightness = state_mgr.getLastAutoBrightness();
+
+    const char* zone_name = zone_mapper ? zone_mapper->getCurrentZoneName(current_lux).c_str()
+                                        : "simple";
+    std::strncpy(status.zone, zone_name, sizeof(status.zone) - 1);
+    status.zone[sizeof(status.zone) - 1] = '\0';
+
+    status.sensor_available = sensor_available;
+    status.nits = 0.0;
+    if (b2n_lut.is_loaded()) {
+        bool clamped_unused = false;
+        // Apply thermal correction so the reported nits matches what a
+        // colorimeter would actually measure right now. factor() returns
+        // 1.0 when thermal compensation is disabled or has no temp reading.
+        status.nits = b2n_lut.pctToNits(static_cast<double>(current_brightness), clamped_unused) *
+                      thermal.factor();
+    }
+    status.thermal_has_reading = thermal.hasReading();
+    status.backlight_temp_c = status.thermal_has_reading ? thermal.lastTempC() : 0.0;
+    status.thermal_factor = status.thermal_has_reading ? thermal.factor() : 1.0;
+    status.output_cache_age_ms = output_cache.cacheAgeMs();
+    status.output_verified_age_ms = output_cache.verifiedAgeMs();
+    status.published_at = std::chrono::steady_clock::now();
+}
 
-                    // When switching to MANUAL mode, preserve current brightness
-                    // to avoid jarring brightness jumps (smooth handover of control)
-                    if (mode_str == "manual") {
-                        state_mgr.setManualBrightness(current_brightness);
-                        LOG_DEBUG("main", "Preserving current brightness " << current_brightness << "% for MANUAL mode");
-                    }
+// Same snapshot in the fixed layout of the shared-memory status page
+void fillStatusPage(als_dimmer::StatusPageData& page, const als_dimmer::SystemStatus& status,
+                    bool calibrated) {
+    switch (status.mode) {
+        case als_dimmer::OperatingMode::AUTO:
+            page.mode = als_dimmer::STATUS_PAGE_MODE_AUTO;
+            break;
+        case als_dimmer::OperatingMode::MANUAL:
+            page.mode = als_dimmer::STATUS_PAGE_MODE_MANUAL;
+            break;
+        case als_dimmer::OperatingMode::MANUAL_TEMPORARY:
+            page.mode = als_dimmer::STATUS_PAGE_MODE_MANUAL_TEMPORARY;
+            break;
+    }
+    page.lux = status.lux;
+    page.brightness = status.current_brightness;
+    page.manual_brightness = status.manual_brightness;
+    page.last_auto_brightness = status.last_auto_brightness;
+    std::memcpy(page.zone, status.zone, sizeof(page.zone));
+    page.sensor_available = status.sensor_available ? 1 : 0;
+    page.calibrated = calibrated ? 1 : 0;
+    page.nits = calibrated ? status.nits : 0.0;
+    page.thermal_has_reading = status.thermal_has_reading ? 1 : 0;
+    page.backlight_temp_c = status.backlight_temp_c;
+    page.thermal_factor = status.thermal_factor;
+}
 
-                    auto new_mode = als_dimmer::StateManager::stringToMode(mode_str);
-                    state_mgr.setMode(new_mode);
-                    state_mgr.save();
-                    LOG_INFO("main", "Mode set to: " << mode_str << " (JSON)");
-                    notifier.emitModeChanged(mode_str);
+// Runs the commands the control interface queues for the main loop. Each
+// one is dispatched through the handler column of its registry row
+// (command_registry.hpp); by then its params have been checked against the
+// row's schema, so anything required is present and numbers are in range.
+class CommandProcessor : public als_dimmer::protocol::CommandHandlers {
+public:
+    using ParsedCommand = als_dimmer::protocol::ParsedCommand;
+    using Response = als_dimmer::protocol::Response;
+
+    CommandProcessor(als_dimmer::StateManager& state_mgr,
+                     als_dimmer::ControlInterface& control,
+                     const als_dimmer::RampEngine& ramp,
+                     const float& current_lux,
+                     const bool& sensor_available,
+                     std::chrono::steady_clock::time_point& manual_temp_start,
+                     als_dimmer::ZoneMapper* zone_mapper,
+                     bool& manual_override_occurred,
+                     const char*& manual_override_type,
+                     als_dimmer::Notifier& notifier,
+                     const als_dimmer::BrightnessToNitsLut& b2n_lut,
+                     const als_dimmer::ThermalCompensation& thermal,
+                     const als_dimmer::CachedOutput& output_cache,
+                     als_dimmer::LoopStats& loop_stats)
+        : state_mgr_(state_mgr), control_(control), ramp_(ramp), current_lux_(current_lux),
+          sensor_available_(sensor_available), manual_temp_start_(manual_temp_start),
+          zone_mapper_(zone_mapper), manual_override_occurred_(manual_override_occurred),
+          manual_override_type_(manual_override_type), notifier_(notifier), b2n_lut_(b2n_lut),
+          thermal_(thermal), output_cache_(output_cache), loop_stats_(loop_stats) {}
+
+    void run(const ParsedCommand& cmd, Response& response) {
+        using namespace als_dimmer::protocol;
+        failed_ = false;
+        try {
+            if (cmd.type == CommandType::SHUTDOWN) {
+                return answer(response, generateResponse(ResponseStatus::SUCCESS, "Shutting down"));
+            }
+            if (cmd.spec == nullptr || cmd.spec->handler == nullptr) {
+                return fail(response, "Unknown command type", "UNKNOWN_COMMAND");
+            }
+            (this->*cmd.spec->handler)(cmd, response);
+        } catch (const std::exception& e) {
+            // Params are schema-checked before they get here; last resort only
+            return fail(response, std::string("Internal error: ") + e.what(), "INTERNAL_ERROR");
+        }
+    }
 
-                    json data;
-                    data["mode"] = mode_str;
-                    return generateResponse(ResponseStatus::SUCCESS,
-                                           "Mode set successfully", data);
-                }
+    void query(const ParsedCommand& cmd, Response& response) override {
+        // Normally answered by the control interface from the last
+        // published status; this is a query queued behind a write
+        // from the same client, so answer it from live state.
+        als_dimmer::SystemStatus status;
+        fillStatus(status, state_mgr_, current_lux_, currentBrightness(), zone_mapper_,
+                   sensor_available_, b2n_lut_, thermal_, output_cache_);
+        answer(response, control_.answerQuery(cmd.type, status).dump());
+    }
 
-                case CommandType::SET_BRIGHTNESS: {
-                    if (!parsed_cmd.params.contains("brightness")) {
-                        return generateErrorResponse("Missing 'brightness' parameter", "INVALID_PARAMS");
-                    }
+    void setMode(const ParsedCommand& cmd, Response& response) override {
+        using namespace als_dimmer::protocol;
+        std::string mode_str = cmd.params["mode"].get<std::string>();
+        if (mode_str == "manual_temporary") {
+            return fail(response,
+                "MANUAL_TEMPORARY is managed automatically; clients may only request 'auto' or 'manual'",
+                "INVALID_PARAMS");
+        }
+        if (mode_str != "auto" && mode_str != "manual") {
+            return fail(response, "Mode must be 'auto' or 'manual'", "INVALID_PARAMS");
+        }
+        if (mode_str == "auto" && !sensor_available_) {
+            return fail(response,
+                "Cannot switch to AUTO mode: ALS sensor unavailable",
+                "SENSOR_UNAVAILABLE");
+        }
 
-                    int brightness = parsed_cmd.params["brightness"].get<int>();
-                    if (brightness < 0 || brightness > 100) {
-                        return generateErrorResponse("Brightness must be 0-100", "INVALID_PARAMS");
-                    }
+        // When switching to MANUAL mode, preserve current brightness
+        // to avoid jarring brightness jumps (smooth handover of control)
+        if (mode_str == "manual") {
+            int current_brightness = currentBrightness();
+            state_mgr_.setManualBrightness(current_brightness);
+            LOG_DEBUG("main", "Preserving current brightness " << current_brightness << "% for MANUAL mode");
+        }
 
-                    state_mgr.setManualBrightness(brightness);
+        auto new_mode = als_dimmer::StateManager::stringToMode(mode_str);
+        state_mgr_.setMode(new_mode);
+        if (!defer_save_) {
+            state_mgr_.save();
+        }
+        LOG_INFO("main", "Mode set to: " << mode_str << " (JSON)");
+        notifier_.emitModeChanged(mode_str);
 
-                    // Set override tracking flags for CSV logging
-                    manual_override_occurred = true;
-                    manual_override_type = "set_brightness";
+        json data;
+        data["mode"] = mode_str;
+        answer(response, generateResponse(ResponseStatus::SUCCESS, "Mode set successfully", data));
+    }
 
-                    // If in AUTO mode, switch to MANUAL_TEMPORARY
-                    if (state_mgr.getMode() == als_dimmer::OperatingMode::AUTO) {
-                        state_mgr.setMode(als_dimmer::OperatingMode::MANUAL_TEMPORARY);
-                        manual_temp_start = std::chrono::steady_clock::now();
-                        LOG_INFO("main", "Switched to MANUAL_TEMPORARY mode (JSON)");
-                        notifier.emitModeChanged("manual_temporary");
-                    } else if (state_mgr.getMode() == als_dimmer::OperatingMode::MANUAL_TEMPORARY) {
-                        manual_temp_start = std::chrono::steady_clock::now();
-                    }
-                    notifier.emitBrightnessChanged(brightness);
-                    state_mgr.save();
+    void setBrightness(const ParsedCommand& cmd, Response& response) override {
+        int brightness = cmd.params["brightness"].get<int>();
+        state_mgr_.setManualBrightness(brightness);
+
+        // Set override tracking flags for CSV logging
+        manual_override_occurred_ = true;
+        manual_override_type_ = "set_brightness";
+
+        // If in AUTO mode, switch to MANUAL_TEMPORARY
+        if (state_mgr_.getMode() == als_dimmer::OperatingMode::AUTO) {
+            state_mgr_.setMode(als_dimmer::OperatingMode::MANUAL_TEMPORARY);
+            manual_temp_start_ = std::chrono::steady_clock::now();
+            LOG_INFO("main", "Switched to MANUAL_TEMPORARY mode (JSON)");
+            notifier_.emitModeChanged("manual_temporary");
+        } else if (state_mgr_.getMode() == als_dimmer::OperatingMode::MANUAL_TEMPORARY) {
+            manual_temp_start_ = std::chrono::steady_clock::now();
+        }
+        notifier_.emitBrightnessChanged(brightness);
+        if (!defer_save_) {
+            state_mgr_.save();
+        }
 
-                    json data;
-                    data["brightness"] = brightness;
-                    return generateResponse(ResponseStatus::SUCCESS,
-                                           "Brightness set successfully", data);
-                }
+        // Slider traffic: written by the control interface straight
+        // into the client's buffer, same text as the DOM gives
+        response.kind = Response::Kind::BRIGHTNESS_SET;
+        response.brightness = brightness;
+    }
 
-                case CommandType::ADJUST_BRIGHTNESS: {
-                    if (!parsed_cmd.params.contains("delta")) {
-                        return generateErrorResponse("Missing 'delta' parameter", "INVALID_PARAMS");
-                    }
+    void adjustBrightness(const ParsedCommand& cmd, Response& response) override {
+        int delta = cmd.params["delta"].get<int>();
+        int current = state_mgr_.getManualBrightness();
+        int new_brightness = std::max(0, std::min(100, current + delta));
 
-                    int delta = parsed_cmd.params["delta"].get<int>();
-                    int current = state_mgr.getManualBrightness();
-                    int new_brightness = std::max(0, std::min(100, current + delta));
+        state_mgr_.setManualBrightness(new_brightness);
 
-                    state_mgr.setManualBrightness(new_brightness);
+        // Set override tracking flags for CSV logging
+        manual_override_occurred_ = true;
+        manual_override_type_ = "adjust_brightness";
 
-                    // Set override tracking flags for CSV logging
-                    manual_override_occurred = true;
-                    manual_override_type = "adjust_brightness";
+        if (state_mgr_.getMode() == als_dimmer::OperatingMode::AUTO) {
+            state_mgr_.setMode(als_dimmer::OperatingMode::MANUAL_TEMPORARY);
+            manual_temp_start_ = std::chrono::steady_clock::now();
+            notifier_.emitModeChanged("manual_temporary");
+        } else if (state_mgr_.getMode() == als_dimmer::OperatingMode::MANUAL_TEMPORARY) {
+            manual_temp_start_ = std::chrono::steady_clock::now();
+        }
+        notifier_.emitBrightnessChanged(new_brightness);
+        if (!defer_save_) {
+            state_mgr_.save();
+        }
 
-                    if (state_mgr.getMode() == als_dimmer::OperatingMode::AUTO) {
-                        state_mgr.setMode(als_dimmer::OperatingMode::MANUAL_TEMPORARY);
-                        manual_temp_start = std::chrono::steady_clock::now();
-                        notifier.emitModeChanged("manual_temporary");
-                    } else if (state_mgr.getMode() == als_dimmer::OperatingMode::MANUAL_TEMPORARY) {
-                        manual_temp_start = std::chrono::steady_clock::now();
-                    }
-                    notifier.emitBrightnessChanged(new_brightness);
-                    state_mgr.save();
-
-                    json data;
-                    data["brightness"] = new_brightness;
-                    data["delta"] = delta;
-                    return generateResponse(ResponseStatus::SUCCESS,
-                                           "Brightness adjusted successfully", data);
-                }
+        response.kind = Response::Kind::BRIGHTNESS_ADJUSTED;
+        response.brightness = new_brightness;
+        response.delta = delta;
+    }
 
-                case CommandType::GET_CONFIG: {
-                    // Return current configuration
-                    json data;
-                    data["mode"] = als_dimmer::StateManager::modeToString(state_mgr.getMode());
-                    data["manual_brightness"] = state_mgr.getManualBrightness();
-                    data["last_auto_brightness"] = state_mgr.getLastAutoBrightness();
-                    data["output_type"] = output_type;
-                    data["calibrated"] = b2n_lut.is_loaded();
-                    if (b2n_lut.is_loaded()) {
-                        // LUT-intrinsic min/max - constant for the panel,
-                        // does NOT vary with thermal compensation. Slider
-                        // UIs reading this can rely on a stable range.
-                        data["calibration_min_nits"] = b2n_lut.min_nits();
-                        data["calibration_max_nits"] = b2n_lut.max_nits();
-                        if (!b2n_lut.label().empty()) {
-                            data["calibration_label"] = b2n_lut.label();
-                        }
-                    }
-                    // Thermal-compensation diagnostics (additive).
-                    data["thermal_enabled"] = thermal.isEnabled();
-                    if (thermal.isEnabled()) {
-                        data["thermal_reference_temp_c"] = thermal.referenceTempC();
-                        data["thermal_factor_min"] = thermal.minFactor();
-                        data["thermal_factor_max"] = thermal.maxFactor();
-                        if (!thermal.label().empty()) {
-                            data["thermal_label"] = thermal.label();
-                        }
-                    }
-                    return generateConfigResponse(data);
-                }
+    void getLoopStats(const ParsedCommand& cmd, Response& response) override {
+        using namespace als_dimmer::protocol;
+        // Control loop timing. Optional {"reset": true} clears the
+        // window and counters after reporting them.
+        als_dimmer::LoopStats::Summary stats = loop_stats_.summarize();
+        json data;
+        data["interval_ms"] = stats.interval_ms;
+        data["samples"] = static_cast<int>(stats.samples);
+        data["period_min_us"] = stats.period_min_us;
+        data["period_avg_us"] = stats.period_avg_us;
+        data["period_max_us"] = stats.period_max_us;
+        data["period_p99_us"] = stats.period_p99_us;
+        data["jitter_avg_us"] = stats.jitter_avg_us;
+        data["jitter_max_us"] = stats.jitter_max_us;
+        data["jitter_p99_us"] = stats.jitter_p99_us;
+        data["ticks"] = stats.ticks;
+        data["missed_ticks"] = stats.missed_ticks;
+        data["steps"] = stats.steps;
+        data["overruns"] = stats.overruns;
+        data["work_avg_us"] = stats.work_avg_us;
+        data["work_max_us"] = stats.work_max_us;
+        data["since_reset_ms"] = stats.since_reset_ms;
+
+        // Scheduling the control thread actually runs with
+        // (control.realtime may have been partly refused)
+        als_dimmer::RealtimeProfile::ThreadState rt =
+            als_dimmer::RealtimeProfile::currentThreadState();
+        data["sched_policy"] = rt.policy;
+        data["sched_priority"] = rt.priority;
+        data["cpus"] = rt.cpus;
+        data["memory_locked"] = als_dimmer::RealtimeProfile::memoryLocked();
+
+        if (cmd.params.value("reset", false)) {
+            loop_stats_.reset();
+        }
+        answer(response, generateResponse(ResponseStatus::SUCCESS, "Loop statistics retrieved", data));
+    }
 
-                case CommandType::GET_CALIBRATION_INFO: {
-                    json data;
-                    data["calibrated"] = b2n_lut.is_loaded();
-                    if (b2n_lut.is_loaded()) {
-                        // LUT-intrinsic values - constant for the panel.
-                        data["min_nits"] = b2n_lut.min_nits();
-                        data["max_nits"] = b2n_lut.max_nits();
-                        data["label"] = b2n_lut.label();
-                        data["output_type"] = b2n_lut.output_type_tag();
-                        data["row_count"] = static_cast<int>(b2n_lut.row_count());
-                    } else {
-                        data["min_nits"] = nullptr;
-                        data["max_nits"] = nullptr;
-                        data["label"] = "";
-                        data["output_type"] = "";
-                        data["row_count"] = 0;
-                    }
-                    // Thermal-compensation diagnostics (additive). Old clients
-                    // that don't read these keys are unaffected.
-                    data["thermal_enabled"] = thermal.isEnabled();
-                    if (thermal.isEnabled()) {
-                        data["thermal_label"] = thermal.label();
-                        data["thermal_reference_temp_c"] = thermal.referenceTempC();
-                        data["thermal_factor_min"] = thermal.minFactor();
-                        data["thermal_factor_max"] = thermal.maxFactor();
-                        data["thermal_row_count"] = static_cast<int>(thermal.rowCount());
-                        if (thermal.hasReading()) {
-                            data["backlight_temp_c"] = thermal.lastTempC();
-                            data["thermal_factor"] = thermal.factor();
-                        } else {
-                            data["backlight_temp_c"] = nullptr;
-                            data["thermal_factor"] = nullptr;
-                        }
-                    }
-                    return generateResponse(ResponseStatus::SUCCESS,
-                                          "Calibration info retrieved", data);
-                }
+    void getMetrics(const ParsedCommand& cmd, Response& response) override {
+        using namespace als_dimmer::protocol;
+        // Per-stage latency histograms and bus transaction
+        // counters. Keys are flat (<stage>_p99_us, ...) so simple
+        // clients can pick values out without a JSON parser.
+        // Optional {"reset": true} clears them after reporting.
+        als_dimmer::Metrics& metrics = als_dimmer::Metrics::getInstance();
+        json data;
+        for (int i = 0; i < static_cast<int>(als_dimmer::Stage::COUNT); ++i) {
+            auto stage = static_cast<als_dimmer::Stage>(i);
+            const als_dimmer::LatencyHistogram& h = metrics.stage(stage);
+            std::string name = als_dimmer::Metrics::stageName(stage);
+            uint64_t count = h.count();
+            data[name + "_count"] = count;
+            data[name + "_avg_us"] = count ? h.sumUs() / count : 0;
+            data[name + "_p50_us"] = h.percentileUs(50.0);
+            data[name + "_p90_us"] = h.percentileUs(90.0);
+            data[name + "_p99_us"] = h.percentileUs(99.0);
+            data[name + "_max_us"] = h.maxUs();
+        }
+        data["sensor_transactions"] = metrics.transactions(als_dimmer::BusDevice::SENSOR);
+        data["sensor_errors"] = metrics.errors(als_dimmer::BusDevice::SENSOR);
+        data["output_transactions"] = metrics.transactions(als_dimmer::BusDevice::OUTPUT);
+        data["output_errors"] = metrics.errors(als_dimmer::BusDevice::OUTPUT);
 
-                case CommandType::GET_ABSOLUTE_BRIGHTNESS: {
-                    json data;
-                    data["brightness_pct"] = current_brightness;
-                    data["calibrated"] = b2n_lut.is_loaded();
-                    if (b2n_lut.is_loaded()) {
-                        bool clamped_unused = false;
-                        double nits = b2n_lut.pctToNits(static_cast<double>(current_brightness),
-                                                       clamped_unused);
-                        // Apply thermal correction. factor() is 1.0 when
-                        // thermal compensation is disabled, so this is a
-                        // no-op for unaffected configs.
-                        data["nits"] = nits * thermal.factor();
-                    } else {
-                        data["nits"] = nullptr;
-                    }
-                    return generateResponse(ResponseStatus::SUCCESS,
-                                          "Absolute brightness retrieved",
-                                          data);
-                }
+        if (cmd.params.value("reset", false)) {
+            metrics.reset();
+        }
+        answer(response, generateResponse(ResponseStatus::SUCCESS, "Metrics retrieved", data));
+    }
 
-                case CommandType::SET_ABSOLUTE_BRIGHTNESS: {
-                    if (!b2n_lut.is_loaded()) {
-                        return generateErrorResponse(
-                            "Calibration table not loaded; cannot map nits to brightness",
-                            "CALIBRATION_NOT_LOADED");
-                    }
-                    if (!parsed_cmd.params.contains("nits")) {
-                        return generateErrorResponse("Missing 'nits' parameter", "INVALID_PARAMS");
-                    }
-                    double target_nits = parsed_cmd.params["nits"].get<double>();
-                    if (target_nits < 0.0) {
-                        return generateErrorResponse("nits must be >= 0", "INVALID_PARAMS");
-                    }
+    void setAbsoluteBrightness(const ParsedCommand& cmd, Response& response) override {
+        using namespace als_dimmer::protocol;
+        if (!b2n_lut_.is_loaded()) {
+            return fail(response,
+                "Calibration table not loaded; cannot map nits to brightness",
+                "CALIBRATION_NOT_LOADED");
+        }
+        double target_nits = cmd.params["nits"].get<double>();
+
+        // Inverse-thermal-correct the target before LUT lookup so
+        // the brightness % we choose is the one that produces the
+        // user-requested nits AT THE CURRENT TEMPERATURE. When
+        // thermal compensation is disabled, factor() == 1.0 and
+        // this is a no-op vs prior behavior.
+        double tc_factor = thermal_.factor();
+        double scaled_target = (tc_factor > 0.0)
+                                ? target_nits / tc_factor
+                                : target_nits;
+        bool clamped = false;
+        double pct = b2n_lut_.nitsToPct(scaled_target, clamped);
+        int brightness = std::max(0, std::min(100, static_cast<int>(pct + 0.5)));
+        bool actual_clamped_unused = false;
+        double actual_nits = b2n_lut_.pctToNits(static_cast<double>(brightness),
+                                                actual_clamped_unused)
+                             * tc_factor;
+
+        state_mgr_.setManualBrightness(brightness);
+        manual_override_occurred_ = true;
+        manual_override_type_ = "set_absolute_brightness";
+
+        if (state_mgr_.getMode() == als_dimmer::OperatingMode::AUTO) {
+            state_mgr_.setMode(als_dimmer::OperatingMode::MANUAL_TEMPORARY);
+            manual_temp_start_ = std::chrono::steady_clock::now();
+            notifier_.emitModeChanged("manual_temporary");
+        } else if (state_mgr_.getMode() == als_dimmer::OperatingMode::MANUAL_TEMPORARY) {
+            manual_temp_start_ = std::chrono::steady_clock::now();
+        }
+        notifier_.emitBrightnessChanged(brightness);
+        if (!defer_save_) {
+            state_mgr_.save();
+        }
 
-                    // Inverse-thermal-correct the target before LUT lookup so
-                    // the brightness % we choose is the one that produces the
-                    // user-requested nits AT THE CURRENT TEMPERATURE. When
-                    // thermal compensation is disabled, factor() == 1.0 and
-                    // this is a no-op vs prior behavior.
-                    double tc_factor = thermal.factor();
-                    double scaled_target = (tc_factor > 0.0)
-                                            ? target_nits / tc_factor
-                                            : target_nits;
-                    bool clamped = false;
-                    double pct = b2n_lut.nitsToPct(scaled_target, clamped);
-                    int brightness = std::max(0, std::min(100, static_cast<int>(pct + 0.5)));
-                    bool actual_clamped_unused = false;
-                    double actual_nits = b2n_lut.pctToNits(static_cast<double>(brightness),
-                                                          actual_clamped_unused)
-                                         * tc_factor;
-
-                    state_mgr.setManualBrightness(brightness);
-                    manual_override_occurred = true;
-                    manual_override_type = "set_absolute_brightness";
-
-                    if (state_mgr.getMode() == als_dimmer::OperatingMode::AUTO) {
-                        state_mgr.setMode(als_dimmer::OperatingMode::MANUAL_TEMPORARY);
-                        manual_temp_start = std::chrono::steady_clock::now();
-                        notifier.emitModeChanged("manual_temporary");
-                    } else if (state_mgr.getMode() == als_dimmer::OperatingMode::MANUAL_TEMPORARY) {
-                        manual_temp_start = std::chrono::steady_clock::now();
-                    }
-                    notifier.emitBrightnessChanged(brightness);
-                    state_mgr.save();
-
-                    json data;
-                    data["brightness_pct"] = brightness;
-                    data["target_nits"] = target_nits;
-                    data["actual_nits"] = actual_nits;
-                    data["clamped"] = clamped;
-                    return generateResponse(ResponseStatus::SUCCESS,
+        json data;
+        data["brightness_pct"] = brightness;
+        data["target_nits"] = target_nits;
+        data["actual_nits"] = actual_nits;
+        data["clamped"] = clamped;
+        answer(response, generateResponse(ResponseStatus::SUCCESS,
                                           clamped ? "Absolute brightness set (clamped to LUT range)"
                                                   : "Absolute brightness set successfully",
-                                          data);
-                }
+                                          data));
+    }
 
-                case CommandType::UNKNOWN:
-                default:
-                    return generateErrorResponse("Unknown command type", "UNKNOWN_COMMAND");
+    void batch(const ParsedCommand& cmd, Response& response) override {
+        using namespace als_dimmer::protocol;
+        // Run every entry back to back in this drain, so no other
+        // client's command lands in between and the output is
+        // applied once afterwards. Entries that fail don't stop
+        // the rest; each gets its own response, carrying its id.
+        // State is saved once at the end instead of per entry.
+        std::string results = "[";
+        int errors = 0;
+        defer_save_ = true;
+        for (size_t i = 0; i < cmd.batch.size(); ++i) {
+            const ParsedCommand& entry = cmd.batch[i];
+            auto mode_before = state_mgr_.getMode();
+            int manual_before = state_mgr_.getManualBrightness();
+            run(entry, entry_response_);
+            if (state_mgr_.getMode() != mode_before ||
+                state_mgr_.getManualBrightness() != manual_before) {
+                batch_wrote_ = true;
+            }
+            if (failed_) {
+                errors++;
             }
+            if (i > 0) {
+                results += ',';
+            }
+            writeResponse(results, entry.id, entry_response_);
+        }
+        defer_save_ = false;
+        batch_wrote_ = false;
+        results += ']';
+        if (state_mgr_.isDirty()) {
+            state_mgr_.save();
+        }
 
-        } catch (const json::parse_error& e) {
-            return generateErrorResponse(
-                std::string("JSON parse error: ") + e.what(), "PARSE_ERROR");
-        } catch (const std::exception& e) {
-            return generateErrorResponse(
-                std::string("Internal error: ") + e.what(), "INTERNAL_ERROR");
+        if (cmd.bare_batch) {
+            return answer(response, std::move(results));
         }
+        // Wrapped as serialized, without parsing the results back
+        response.kind = Response::Kind::TEXT;
+        response.text.clear();
+        writeBatchResponse(response.text, std::string(), results, errors);
     }
 
-    // Non-JSON command - return error
-    return generateErrorResponse(
-        "Invalid command format. Only JSON protocol is supported. "
-        "Please send commands in JSON format starting with '{'",
-        "INVALID_FORMAT");
-}
+private:
+    // Brightness the status and set_mode see. The output only moves in the
+    // control step after the drain, so inside a batch, once an entry has
+    // set a manual brightness, later entries see that target rather than
+    // the value the ramp still holds - as if each entry had been answered
+    // after its own control step.
+    int currentBrightness() const {
+        if (batch_wrote_ && state_mgr_.getMode() != als_dimmer::OperatingMode::AUTO) {
+            return state_mgr_.getManualBrightness();
+        }
+        return ramp_.currentBrightness();
+    }
+
+    // The response to anything but the two hot acknowledgements is text
+    static void answer(Response& response, std::string text) {
+        response.kind = Response::Kind::TEXT;
+        response.text = std::move(text);
+    }
+
+    // Every error response goes through here, so a batch can count them
+    void fail(Response& response, const std::string& message, const char* code) {
+        failed_ = true;
+        answer(response, als_dimmer::protocol::generateErrorResponse(message, code));
+    }
+
+    als_dimmer::StateManager& state_mgr_;
+    als_dimmer::ControlInterface& control_;
+    const als_dimmer::RampEngine& ramp_;
+    const float& current_lux_;
+    const bool& sensor_available_;
+    std::chrono::steady_clock::time_point& manual_temp_start_;
+    als_dimmer::ZoneMapper* zone_mapper_;
+    bool& manual_override_occurred_;
+    const char*& manual_override_type_;
+    als_dimmer::Notifier& notifier_;
+    const als_dimmer::BrightnessToNitsLut& b2n_lut_;
+    const als_dimmer::ThermalCompensation& thermal_;
+    const als_dimmer::CachedOutput& output_cache_;
+    als_dimmer::LoopStats& loop_stats_;
+
+    bool defer_save_ = false;   // Inside a batch: saved once at its end
+    bool batch_wrote_ = false;  // An earlier entry of this batch changed the target
+    bool failed_ = false;       // The last run() answered with an error
+    Response entry_response_;  // Reused for batch entries
+};
 
 int main(int argc, char* argv[]) {
     std::string config_file;
@@ -761,8 +881,13 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // Create output
-    auto output = createOutput(config);
+    // Create output, behind the output-state cache so brightness queries
+    // don't turn into bus reads (DDC/CI VCP reads cost tens of ms)
+    std::unique_ptr<als_dimmer::CachedOutput> output;
+    if (auto device_output = createOutput(config)) {
+        output = std::make_unique<als_dimmer::CachedOutput>(
+            std::move(device_output), config.control.output_verify_interval_sec);
+    }
     if (!output || !output->init()) {
         LOG_ERROR("main", "Failed to initialize output");
         return 1;
@@ -853,11 +978,19 @@ int main(int argc, char* argv[]) {
 
     // Initialize control interface (TCP and/or Unix sockets)
     als_dimmer::ControlInterface control(config.control);
+    control.setCalibration(&b2n_lut, &thermal, output->getType());
     if (!control.start()) {
         LOG_ERROR("main", "Failed to start control interface");
         return 1;
     }
 
+    // Optional shared-memory copy of the status for local readers. Not
+    // fatal: the sockets serve the same information.
+    als_dimmer::StatusPageWriter status_page;
+    if (!config.control.status_page.empty() && !status_page.open(config.control.status_page)) {
+        LOG_WARN("main", "Status page disabled");
+    }
+
     // Initialize notifier for state change callbacks
     als_dimmer::Notifier notifier(config.notification);
     if (config.notification.enabled && !config.notification.on_change_script.empty()) {
@@ -888,6 +1021,22 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    // Real-time profile (control.realtime): memory is locked here, the ramp
+    // thread applies the scheduling settings to itself and the control loop
+    // right before it starts, after all normal-priority threads exist.
+    als_dimmer::RealtimeProfile realtime(config.control.realtime);
+    realtime.lockMemory();
+
+    // Output writes go through the ramp engine: animated on its own thread
+    // when control.ramp is enabled, a synchronous pass-through otherwise.
+    als_dimmer::RampEngine ramp(*output, config.control.ramp);
+    if (!ramp.start(realtime.enabled() ? &realtime : nullptr)) {
+        LOG_ERROR("main", "Failed to start output ramp engine");
+        control.stop();
+        thermal.stopPolling();
+        return 1;
+    }
+
     // Register signal handlers for clean shutdown
     std::signal(SIGTERM, signalHandler);
     std::signal(SIGINT, signalHandler);
@@ -896,7 +1045,7 @@ int main(int argc, char* argv[]) {
     LOG_INFO("main", "Starting control loop (update interval: " << config.control.update_interval_ms << " ms)");
     LOG_INFO("main", "TCP control available on " << config.control.listen_address << ":" << config.control.listen_port);
 
-    auto loop_start = std::chrono::steady_clock::now();
+    auto last_periodic_save = std::chrono::steady_clock::now();
     auto manual_temp_start = std::chrono::steady_clock::now();
     auto last_sensor_healthy_time = std::chrono::steady_clock::now();
     float current_lux = 0.0f;
@@ -904,127 +1053,444 @@ int main(int argc, char* argv[]) {
 
     // CSV logging state tracking
     uint64_t iteration_seq = 0;
-    int previous_brightness = output->getCurrentBrightness();
-    std::string previous_zone_name = "";
+    int previous_brightness = ramp.currentBrightness();
+    const char* previous_zone_name = "";  // points into config-owned zone names
     auto csv_start_time = std::chrono::steady_clock::now();
 
     // Manual override tracking for CSV logging
     bool manual_override_occurred = false;
-    std::string manual_override_type = "";
+    const char* manual_override_type = "";
+
+    // Event sources. The loop blocks in epoll_wait() instead of sleeping:
+    //   - tick timerfd: periodic control step, scheduled by the kernel so
+    //     the period does not stretch with the work done per iteration
+    //   - command eventfd: signalled by ControlInterface on every queued
+    //     command, so set_brightness etc. is handled immediately
+    //   - sampler eventfd: SensorSampler reads the sensor on its own
+    //     thread and signals when new samples are queued
+    //   - resume timerfd: one-shot, armed while in MANUAL_TEMPORARY for
+    //     the auto-resume deadline
+    enum : uint64_t { EV_TICK = 1, EV_COMMAND = 2, EV_SENSOR = 3, EV_RESUME = 4 };
+    als_dimmer::EventLoop event_loop;
+    als_dimmer::TimerFd tick_timer;
+    als_dimmer::TimerFd resume_timer;
+    if (!event_loop.init() || !tick_timer.init() || !resume_timer.init() ||
+        !event_loop.add(tick_timer.fd(), EPOLLIN, EV_TICK) ||
+        !event_loop.add(resume_timer.fd(), EPOLLIN, EV_RESUME) ||
+        !event_loop.add(control.commandEventFd(), EPOLLIN, EV_COMMAND)) {
+        LOG_ERROR("main", "Failed to set up control loop event sources");
+        control.stop();
+        thermal.stopPolling();
+        return 1;
+    }
+    // Tick interval: fixed at update_interval_ms unless control.adaptive_tick
+    // is enabled, in which case TickScheduler moves it with lux dynamics.
+    als_dimmer::TickScheduler tick_scheduler(config.control);
+    int tick_interval_ms = tick_scheduler.intervalMs();
+    if (config.control.adaptive_tick.enabled) {
+        LOG_INFO("main", "Adaptive tick enabled: "
+                 << config.control.adaptive_tick.min_interval_ms << "-"
+                 << config.control.adaptive_tick.max_interval_ms << " ms");
+    }
+    tick_timer.armPeriodic(tick_interval_ms);
+
+    // Sensor acquisition runs on its own thread at the tick cadence. A sensor
+    // given up on by the watchdog moves to retired_sensor rather than being
+    // destroyed, since a stuck read may still be using it until the sampler
+    // is joined (declared after it, so destroyed first).
+    std::unique_ptr<als_dimmer::SensorInterface> retired_sensor;
+    als_dimmer::SensorSampler sampler(*sensor);
+    if (sensor_available) {
+        if (!sampler.start(tick_interval_ms) ||
+            !event_loop.add(sampler.eventFd(), EPOLLIN, EV_SENSOR)) {
+            LOG_ERROR("main", "Failed to start sensor sampler");
+            control.stop();
+            thermal.stopPolling();
+            return 1;
+        }
+    }
+    bool sensor_healthy = sensor_available;  // from the newest sample
+
+    auto next_tick_deadline = std::chrono::steady_clock::now() +
+                              std::chrono::milliseconds(tick_interval_ms);
+
+    // Wakeup latency reporting (tick: timer deadline -> loop running;
+    // command: queued by the client thread -> picked up by the loop)
+    LatencyWindow tick_latency;
+    LatencyWindow command_latency;
+
+    // Period jitter / overrun accounting, reported by get_loop_stats
+    als_dimmer::LoopStats loop_stats;
+    auto latency_report_time = std::chrono::steady_clock::now();
+
+    // Drain queued sensor samples: the newest one becomes current_lux, all
+    // of them feed the tick scheduler's lux rate filter.
+    auto drainSamples = [&]() {
+        als_dimmer::SensorSample sample;
+        while (sampler.pop(sample)) {
+            current_lux = sample.lux;
+            sensor_healthy = sample.healthy;
+            if (sample.healthy) {
+                last_sensor_healthy_time = sample.taken_at;
+                tick_scheduler.addSample(sample.lux, sample.taken_at);
+            }
+        }
+    };
+
+    // Watchdog: if no healthy sample arrives for sensor_failure_timeout_sec
+    // (unhealthy reads, or a read stuck in the sampler thread), demote to
+    // NullSensor + MANUAL so the user keeps control.
+    auto checkSensorWatchdog = [&]() {
+        auto unhealthy_for = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - last_sensor_healthy_time).count();
+        if (unhealthy_for < config.control.sensor_failure_timeout_sec) {
+            return;
+        }
+        LOG_WARN("main", "No healthy sensor sample for " << unhealthy_for
+                 << "s; demoting to NullSensor and forcing MANUAL mode");
+        event_loop.remove(sampler.eventFd());
+        sampler.requestStop();
+        retired_sensor = std::move(sensor);
+        sensor = std::make_unique<als_dimmer::NullSensor>();
+        sensor->init();
+        sensor_available = false;
+        sensor_healthy = false;
+        current_lux = -1.0f;
+        if (state_mgr.getMode() != als_dimmer::OperatingMode::MANUAL) {
+            if (state_mgr.getManualBrightness() <= 0) {
+                state_mgr.setManualBrightness(config.control.fallback_brightness);
+            }
+            state_mgr.setMode(als_dimmer::OperatingMode::MANUAL);
+            notifier.emitModeChanged("manual");
+        }
+        state_mgr.save();
+    };
+
+    // ALS_DIMMER_ALLOC_CHECK builds: a wakeup that handled no commands and
+    // produced no output (log line, CSV row, notifier script, state save)
+    // must not touch the heap. Compiled out otherwise.
+    struct QuietMarks {
+        uint64_t allocations;
+        uint64_t log_lines;
+        uint64_t csv_rows;
+        uint64_t state_saves;
+        uint64_t scripts;
+    };
+    auto quietMarks = [&]() {
+        als_dimmer::Metrics& metrics = als_dimmer::Metrics::getInstance();
+        return QuietMarks{als_dimmer::alloc_check::threadAllocations(),
+                          als_dimmer::Logger::getInstance().linesLogged(),
+                          metrics.stage(als_dimmer::Stage::CSV_LOG).count(),
+                          metrics.stage(als_dimmer::Stage::STATE_SAVE).count(),
+                          notifier.invocations()};
+    };
+    auto checkQuietWakeup = [&](const QuietMarks& start, bool handled_commands) {
+        QuietMarks end = quietMarks();
+        if (handled_commands || end.log_lines != start.log_lines ||
+            end.csv_rows != start.csv_rows || end.state_saves != start.state_saves ||
+            end.scripts != start.scripts) {
+            return;
+        }
+        uint64_t allocations = end.allocations - start.allocations;
+        if (allocations != 0) {
+            LOG_ERROR("main", "Allocation check failed: " << allocations
+                      << " heap allocation(s) in a quiet iteration (seq " << iteration_seq << ")");
+            std::abort();
+        }
+    };
+
+    // Tickless idle: in MANUAL with no sensor sampling (minimal_i2c or no
+    // sensor) and no CSV log, a control step can't change anything, so the
+    // tick timer is disarmed and the loop sleeps until a command arrives.
+    // Ramps run on their own thread and thermal polling on its own, so
+    // neither needs ticks.
+    auto canIdle = [&]() {
+        return state_mgr.getMode() == als_dimmer::OperatingMode::MANUAL &&
+               !csv_logger &&
+               (!sensor_available || config.control.minimal_i2c);
+    };
+    bool tick_idle = false;
+    bool sampler_paused = false;
+
+    // manual_temp_start the auto-resume timer is currently armed for
+    const auto resume_not_armed = std::chrono::steady_clock::time_point::min();
+    auto resume_armed_for = resume_not_armed;
+
+    // Reused for every dequeued command so draining keeps its buffers
+    als_dimmer::QueuedCommand queued;
+    als_dimmer::protocol::Response response;
+    CommandProcessor commands(state_mgr, control, ramp, current_lux, sensor_available,
+                              manual_temp_start, zone_mapper.get(), manual_override_occurred,
+                              manual_override_type, notifier, b2n_lut, thermal, *output,
+                              loop_stats);
+
+    // Reply to a command that changed the mode or manual brightness. It is
+    // held (with `queued`) until the control step has applied the change
+    // and the status is published: once a client has its reply, the
+    // control interface answers its next query from that status.
+    bool reply_held = false;
+    als_dimmer::protocol::Response held_response;
+
+    // State the control interface answers read-only queries from, published
+    // after every wakeup that may have changed it
+    als_dimmer::SystemStatus published_status;
+    als_dimmer::StatusPageData page_data = {};
+    auto publishStatus = [&]() {
+        fillStatus(published_status, state_mgr, current_lux, ramp.currentBrightness(),
+                   zone_mapper.get(), sensor_available, b2n_lut, thermal, *output);
+        control.updateStatus(published_status);
+        if (status_page.isOpen()) {
+            fillStatusPage(page_data, published_status, b2n_lut.is_loaded());
+            status_page.publish(page_data);
+        }
+        if (reply_held) {
+            control.sendResponseTo(queued, held_response);
+            reply_held = false;
+        }
+    };
+    publishStatus();
+
+    realtime.applyToCurrentThread("control");
 
     while (!should_exit && !g_shutdown_requested.load()) {
+        // Idle with unsaved state: wake up for the periodic save
+        int wait_timeout_ms = -1;
+        if (tick_idle && state_mgr.isDirty()) {
+            auto until_save = std::chrono::duration_cast<std::chrono::milliseconds>(
+                last_periodic_save + std::chrono::seconds(60) -
+                std::chrono::steady_clock::now()).count();
+            wait_timeout_ms = static_cast<int>(std::max<int64_t>(0, until_save));
+        }
+        // ...and for the next scheduled output readback
+        if (tick_idle) {
+            int64_t until_verify = output->msUntilVerify();
+            if (until_verify >= 0 && (wait_timeout_ms < 0 || until_verify < wait_timeout_ms)) {
+                wait_timeout_ms = static_cast<int>(until_verify);
+            }
+        }
+
+        // Commands left queued behind a held reply: don't sleep on them
+        bool backlog = control.hasCommand();
+
+        als_dimmer::EventLoop::Event events[4];
+        int n_events = event_loop.wait(events, 4, backlog ? 0 : wait_timeout_ms);
+        if (n_events < 0) {
+            // epoll itself failed - don't spin, fall back to a plain sleep
+            std::this_thread::sleep_for(std::chrono::milliseconds(tick_interval_ms));
+            n_events = 0;
+        }
+        QuietMarks wakeup_marks{};
+        if (als_dimmer::alloc_check::ENABLED) {
+            wakeup_marks = quietMarks();
+        }
+
+        bool tick = (n_events == 0 && wait_timeout_ms >= 0 && !backlog);  // idle save/readback deadline
+        bool resume_due = false;
+        for (int i = 0; i < n_events; ++i) {
+            switch (events[i].token) {
+                case EV_TICK: {
+                    uint64_t expirations = tick_timer.consume();
+                    if (expirations == 0) {
+                        break;
+                    }
+                    auto now = std::chrono::steady_clock::now();
+                    int64_t latency_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                        now - next_tick_deadline).count();
+                    tick_latency.add(latency_us);
+                    LOG_TRACE("main", "Tick wakeup latency: " << latency_us << " us"
+                              << " (expirations: " << expirations << ")");
+                    next_tick_deadline += std::chrono::milliseconds(
+                        tick_interval_ms * static_cast<int64_t>(expirations));
+                    loop_stats.onTick(now, tick_interval_ms, expirations);
+                    tick = true;
+                    break;
+                }
+                case EV_COMMAND:
+                    control.consumeCommandEvent();
+                    break;
+                case EV_RESUME:
+                    if (resume_timer.consume() > 0) {
+                        resume_due = true;
+                        tick = true;
+                    }
+                    break;
+                case EV_SENSOR:
+                    sampler.consumeEvent();
+                    if (sensor_available) {
+                        drainSamples();
+                        // Sharp lux change between ticks: step now rather
+                        // than waiting out a slow tick
+                        if (tick_scheduler.wantsFastTick()) {
+                            tick = true;
+                        }
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
         // Process TCP commands
-        while (control.hasCommand()) {
-            als_dimmer::QueuedCommand queued = control.getNextCommand();
-
-            std::string response = processCommand(queued.command, state_mgr, control, current_lux,
-                                                  output->getCurrentBrightness(), manual_temp_start,
-                                                  zone_mapper.get(),
-                                                  manual_override_occurred, manual_override_type,
-                                                  notifier, sensor_available,
-                                                  b2n_lut, output->getType(),
-                                                  thermal);
-            control.sendResponseTo(queued.client_fd, response);
-            if (queued.close_after_response && queued.client_fd >= 0) {
-                close(queued.client_fd);
+        auto mode_before = state_mgr.getMode();
+        int manual_brightness_before = state_mgr.getManualBrightness();
+        bool draining = control.hasCommand();
+        auto drain_start = std::chrono::steady_clock::now();
+        while (control.nextCommand(queued)) {
+            command_latency.add(std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - queued.enqueued_at).count());
+
+            commands.run(queued.command, response);
+
+            // A write is answered after the control step below has applied
+            // it; the rest of the queue waits for the next wakeup
+            if (state_mgr.getMode() != mode_before ||
+                state_mgr.getManualBrightness() != manual_brightness_before) {
+                std::swap(held_response, response);
+                reply_held = true;
+                break;
             }
+            control.sendResponseTo(queued, response);
 
-            if (queued.command == "SHUTDOWN") {
+            if (queued.command.type == als_dimmer::protocol::CommandType::SHUTDOWN) {
                 should_exit = true;
                 break;
             }
         }
+        if (draining) {
+            als_dimmer::Metrics::getInstance().stage(als_dimmer::Stage::COMMAND_DRAIN).record(
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now() - drain_start).count());
+        }
+
+        // A command that changed what should be on the output applies it
+        // right away instead of waiting for the next (possibly slow) tick.
+        if (state_mgr.getMode() != mode_before ||
+            state_mgr.getManualBrightness() != manual_brightness_before) {
+            tick = true;
+        }
+
+        // MANUAL_TEMPORARY auto-resume is a one-shot timer, re-armed when a
+        // manual adjustment moves manual_temp_start and disarmed on leaving
+        // the mode
+        if (state_mgr.getMode() == als_dimmer::OperatingMode::MANUAL_TEMPORARY) {
+            if (manual_temp_start != resume_armed_for) {
+                auto remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    manual_temp_start + std::chrono::seconds(config.control.auto_resume_timeout_sec) -
+                    std::chrono::steady_clock::now()).count();
+                // Round up so the timer never fires just short of the
+                // deadline; armOneShot(0) would disarm
+                resume_timer.armOneShot(static_cast<int>(std::max<int64_t>(1, remaining_ms + 1)));
+                resume_armed_for = manual_temp_start;
+            }
+        } else if (resume_armed_for != resume_not_armed) {
+            resume_timer.disarm();
+            resume_armed_for = resume_not_armed;
+        }
 
-        // Check for auto-resume from MANUAL_TEMPORARY (skip when sensor is unavailable)
-        if (sensor_available &&
+        // Everything below is the control step
+        if (!tick || should_exit) {
+            publishStatus();
+            if (als_dimmer::alloc_check::ENABLED && !should_exit) {
+                checkQuietWakeup(wakeup_marks, draining);
+            }
+            continue;
+        }
+        auto step_start = std::chrono::steady_clock::now();
+
+        // Auto-resume from MANUAL_TEMPORARY once its timer fired (skip when
+        // sensor is unavailable). The elapsed check covers an adjustment that
+        // arrived in the same wakeup and pushed the deadline out.
+        if (resume_due && sensor_available &&
             state_mgr.getMode() == als_dimmer::OperatingMode::MANUAL_TEMPORARY) {
-            auto now = std::chrono::steady_clock::now();
-            auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - manual_temp_start).count();
+            auto elapsed = std::chrono::steady_clock::now() - manual_temp_start;
 
-            if (elapsed >= config.control.auto_resume_timeout_sec) {
+            if (elapsed >= std::chrono::seconds(config.control.auto_resume_timeout_sec)) {
                 LOG_INFO("main", "Auto-resuming AUTO mode (timeout expired)");
                 state_mgr.setMode(als_dimmer::OperatingMode::AUTO);
                 notifier.emitModeChanged("auto");
             }
         }
 
-        // Read sensor: skip when sensor isn't available, or in MANUAL modes
-        // when minimal_i2c is enabled. Otherwise read and feed the watchdog.
-        if (sensor_available &&
-            (!config.control.minimal_i2c ||
-             state_mgr.getMode() == als_dimmer::OperatingMode::AUTO)) {
-            current_lux = sensor->readLux();
-
-            // Sensor watchdog: if the sensor stays unhealthy long enough,
-            // demote to NullSensor + MANUAL so the user keeps control.
-            if (sensor->isHealthy()) {
-                last_sensor_healthy_time = std::chrono::steady_clock::now();
-            } else {
-                auto unhealthy_for = std::chrono::duration_cast<std::chrono::seconds>(
-                    std::chrono::steady_clock::now() - last_sensor_healthy_time).count();
-                if (unhealthy_for >= config.control.sensor_failure_timeout_sec) {
-                    LOG_WARN("main", "Sensor unhealthy for " << unhealthy_for
-                             << "s; demoting to NullSensor and forcing MANUAL mode");
-                    sensor = std::make_unique<als_dimmer::NullSensor>();
-                    sensor->init();
-                    sensor_available = false;
-                    current_lux = -1.0f;
-                    if (state_mgr.getMode() != als_dimmer::OperatingMode::MANUAL) {
-                        if (state_mgr.getManualBrightness() <= 0) {
-                            state_mgr.setManualBrightness(config.control.fallback_brightness);
-                        }
-                        state_mgr.setMode(als_dimmer::OperatingMode::MANUAL);
-                        notifier.emitModeChanged("manual");
-                    }
-                    state_mgr.save();
+        // Sensor samples arrive from the sampler thread; here we only decide
+        // whether it should keep reading (not in MANUAL modes when
+        // minimal_i2c is enabled) and run the watchdog.
+        if (sensor_available) {
+            bool sampling = !config.control.minimal_i2c ||
+                            state_mgr.getMode() == als_dimmer::OperatingMode::AUTO;
+            sampler.setPaused(!sampling);
+            if (sampling) {
+                if (sampler_paused) {
+                    // Reads were skipped (minimal_i2c in MANUAL, possibly
+                    // idle for hours); start a fresh watchdog window so it
+                    // doesn't fire before the first new sample.
+                    last_sensor_healthy_time = std::chrono::steady_clock::now();
                 }
+                checkSensorWatchdog();
             }
-        } else if (!sensor_available) {
-            current_lux = -1.0f;
+            sampler_paused = !sampling;
         } else {
-            // Sensor available but read skipped (minimal_i2c in MANUAL); keep
-            // the watchdog timer fresh so it doesn't fire on the next AUTO read.
-            last_sensor_healthy_time = std::chrono::steady_clock::now();
+            current_lux = -1.0f;
         }
 
         // Control logic based on operating mode
+        int brightness_error = 0;  // Feeds the tick scheduler; 0 in MANUAL modes
         if (state_mgr.getMode() == als_dimmer::OperatingMode::AUTO) {
             if (current_lux >= 0) {
                 // Map lux to brightness using zone mapper (or simple mapping as fallback)
                 int target_brightness;
                 const als_dimmer::Zone* current_zone = nullptr;
-                std::string current_zone_name;
-                std::string curve_type;
+                // Config-owned or static strings: the steady-state
+                // iteration makes no heap allocations
+                const char* current_zone_name;
+                const char* curve_type;
 
-                if (zone_mapper) {
-                    target_brightness = zone_mapper->mapLuxToBrightness(current_lux);
-                    current_zone = zone_mapper->selectZone(current_lux);
-                    current_zone_name = zone_mapper->getCurrentZoneName(current_lux);
-                    curve_type = current_zone ? current_zone->curve : "unknown";
-                } else {
-                    target_brightness = mapLuxToBrightnessSimple(current_lux);
-                    current_zone_name = "simple";
-                    curve_type = "linear";
+                {
+                    als_dimmer::ScopedStageTimer timer(als_dimmer::Stage::ZONE_MAP);
+                    if (zone_mapper) {
+                        target_brightness = zone_mapper->mapLuxToBrightness(current_lux);
+                        current_zone = zone_mapper->selectZone(current_lux);
+                        current_zone_name = zone_mapper->getCurrentZoneName(current_lux).c_str();
+                        curve_type = current_zone ? current_zone->curve.c_str() : "unknown";
+                    } else {
+                        target_brightness = mapLuxToBrightnessSimple(current_lux);
+                        current_zone_name = "simple";
+                        curve_type = "linear";
+                    }
                 }
 
                 // Calculate smooth brightness transition with diagnostics
-                int current_brightness = output->getCurrentBrightness();
-                auto transition_info = brightness_ctrl.calculateNextBrightnessWithInfo(
-                    target_brightness, current_brightness, current_zone);
+                int current_brightness = ramp.currentBrightness();
+                als_dimmer::BrightnessController::TransitionInfo transition_info;
+                {
+                    als_dimmer::ScopedStageTimer timer(als_dimmer::Stage::CONTROLLER);
+                    transition_info = brightness_ctrl.calculateNextBrightnessWithInfo(
+                        target_brightness, current_brightness, current_zone);
+                }
+                if (ramp.enabled()) {
+                    // The ramp engine fades to the target by itself; no
+                    // per-tick stepping
+                    transition_info.next_brightness = target_brightness;
+                    transition_info.step_size = target_brightness - current_brightness;
+                    transition_info.step_category = "ramp";
+                }
 
                 // Apply brightness
-                output->setBrightness(transition_info.next_brightness);
+                ramp.setTarget(transition_info.next_brightness);
                 state_mgr.setLastAutoBrightness(transition_info.next_brightness);
+                brightness_error = target_brightness - transition_info.next_brightness;
 
                 // Notify external tools of actual output changes
-                notifier.emitBrightnessChanged(transition_info.next_brightness);
-                notifier.emitZoneChanged(current_zone_name);
+                {
+                    als_dimmer::ScopedStageTimer timer(als_dimmer::Stage::NOTIFIER);
+                    notifier.emitBrightnessChanged(transition_info.next_brightness);
+                    notifier.emitZoneChanged(current_zone_name);
+                }
 
                 // CSV logging (AUTO mode)
                 if (csv_logger) {
                     auto now = std::chrono::steady_clock::now();
                     double timestamp = std::chrono::duration<double>(now - csv_start_time).count();
-                    bool zone_changed = (current_zone_name != previous_zone_name);
+                    bool zone_changed = std::strcmp(current_zone_name, previous_zone_name) != 0;
 
                     // Extract time-of-day info for ML
                     auto now_time_t = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
@@ -1036,7 +1502,7 @@ int main(int argc, char* argv[]) {
                     log_data.timestamp = timestamp;
                     log_data.seq = iteration_seq;
                     log_data.lux = current_lux;
-                    log_data.sensor_healthy = sensor->isHealthy();
+                    log_data.sensor_healthy = sensor_healthy;
                     log_data.zone_name = current_zone_name;
                     log_data.zone_changed = zone_changed;
                     log_data.curve = curve_type;
@@ -1058,7 +1524,10 @@ int main(int argc, char* argv[]) {
                     log_data.hour_of_day = hour_of_day;
                     log_data.day_of_week = day_of_week;
 
-                    csv_logger->logIteration(log_data);
+                    {
+                        als_dimmer::ScopedStageTimer timer(als_dimmer::Stage::CSV_LOG);
+                        csv_logger->logIteration(log_data);
+                    }
 
                     previous_zone_name = current_zone_name;
                     manual_override_occurred = false;  // Clear flag after logging
@@ -1084,25 +1553,28 @@ int main(int argc, char* argv[]) {
         } else {
             // MANUAL or MANUAL_TEMPORARY: use manual brightness
             int manual_brightness = state_mgr.getManualBrightness();
-            int current_brightness_before = output->getCurrentBrightness();
-            output->setBrightness(manual_brightness);
-            notifier.emitBrightnessChanged(manual_brightness);
+            int current_brightness_before = ramp.currentBrightness();
+            ramp.setTarget(manual_brightness, config.control.ramp.manual_fade_ms);
+            {
+                als_dimmer::ScopedStageTimer timer(als_dimmer::Stage::NOTIFIER);
+                notifier.emitBrightnessChanged(manual_brightness);
+            }
 
-            std::string mode_str = als_dimmer::StateManager::modeToString(state_mgr.getMode());
+            const char* mode_str = als_dimmer::StateManager::modeName(state_mgr.getMode());
             LOG_DEBUG("main", mode_str << ": Brightness=" << manual_brightness << "%");
 
             // CSV logging (MANUAL mode)
             if (csv_logger) {
                 // Calculate what AUTO mode WOULD target (even though we're in MANUAL mode)
                 int auto_target_brightness = 0;
-                std::string zone_name = "manual";
-                std::string curve_type = "manual";
+                const char* zone_name = "manual";
+                const char* curve_type = "manual";
 
                 if (current_lux >= 0 && zone_mapper) {
                     auto_target_brightness = zone_mapper->mapLuxToBrightness(current_lux);
-                    zone_name = zone_mapper->getCurrentZoneName(current_lux);
+                    zone_name = zone_mapper->getCurrentZoneName(current_lux).c_str();
                     const als_dimmer::Zone* zone = zone_mapper->selectZone(current_lux);
-                    curve_type = zone ? zone->curve : "unknown";
+                    curve_type = zone ? zone->curve.c_str() : "unknown";
                 } else if (current_lux >= 0) {
                     auto_target_brightness = mapLuxToBrightnessSimple(current_lux);
                     zone_name = "simple";
@@ -1122,7 +1594,7 @@ int main(int argc, char* argv[]) {
                 log_data.timestamp = timestamp;
                 log_data.seq = iteration_seq;
                 log_data.lux = current_lux;
-                log_data.sensor_healthy = sensor->isHealthy();
+                log_data.sensor_healthy = sensor_healthy;
                 log_data.zone_name = zone_name;
                 log_data.zone_changed = false;
                 log_data.curve = curve_type;
@@ -1144,7 +1616,10 @@ int main(int argc, char* argv[]) {
                 log_data.hour_of_day = hour_of_day;
                 log_data.day_of_week = day_of_week;
 
-                csv_logger->logIteration(log_data);
+                {
+                    als_dimmer::ScopedStageTimer timer(als_dimmer::Stage::CSV_LOG);
+                    csv_logger->logIteration(log_data);
+                }
 
                 manual_override_occurred = false;  // Clear flag after logging
                 manual_override_type = "";
@@ -1154,15 +1629,64 @@ int main(int argc, char* argv[]) {
             iteration_seq++;
         }
 
-        // Periodic state save (every 60 seconds if dirty)
         auto now = std::chrono::steady_clock::now();
-        auto uptime = std::chrono::duration_cast<std::chrono::seconds>(now - loop_start).count();
-        if (uptime % 60 == 0 && state_mgr.isDirty()) {
-            state_mgr.save();
+        loop_stats.onStep(step_start, now, tick_interval_ms);
+
+        // Pick the next tick interval; re-arming restarts the period from now.
+        // When idle the timer stays disarmed until a step leaves idle.
+        int next_interval_ms = tick_scheduler.update(brightness_error, now);
+        bool idle = canIdle();
+        if (idle) {
+            if (!tick_idle) {
+                tick_timer.disarm();
+                loop_stats.onScheduleChange();
+                LOG_DEBUG("main", "Tickless idle: waiting for commands");
+            }
+        } else if (tick_idle || next_interval_ms != tick_interval_ms) {
+            if (tick_idle) {
+                LOG_DEBUG("main", "Leaving tickless idle");
+            }
+            tick_interval_ms = next_interval_ms;
+            tick_timer.armPeriodic(tick_interval_ms);
+            next_tick_deadline = now + std::chrono::milliseconds(tick_interval_ms);
+            loop_stats.onScheduleChange();
+            if (sensor_available) {
+                sampler.setInterval(tick_interval_ms);
+            }
+        }
+        tick_idle = idle;
+
+        // Periodic state save (every 60 seconds if dirty). Tracked against the
+        // last save rather than uptime % 60, which a variable tick can step over.
+        if (now - last_periodic_save >= std::chrono::seconds(60)) {
+            if (state_mgr.isDirty()) {
+                state_mgr.save();
+            }
+            last_periodic_save = now;
         }
 
-        // Sleep for update interval
-        std::this_thread::sleep_for(std::chrono::milliseconds(config.control.update_interval_ms));
+        // Once a minute, summarize wakeup latency so the event-driven loop's
+        // responsiveness can be checked on target at --log-level debug.
+        if (now - latency_report_time >= std::chrono::seconds(60)) {
+            LOG_DEBUG("main", "Wakeup latency min/avg/max: tick " << tick_latency
+                      << ", command " << command_latency);
+            tick_latency.reset();
+            command_latency.reset();
+            latency_report_time = now;
+        }
+
+        // Scheduled hardware readback (output_verify_interval_sec), also
+        // with the ramp on, where nothing else reads the output while it
+        // is settled. Puts the target back if it was changed behind our back.
+        if (output->verifyDue()) {
+            ramp.resync();
+        }
+
+        publishStatus();
+
+        if (als_dimmer::alloc_check::ENABLED) {
+            checkQuietWakeup(wakeup_marks, draining);
+        }
     }
 
     // Cleanup
@@ -1171,6 +1695,9 @@ int main(int argc, char* argv[]) {
     }
     state_mgr.save();
     control.stop();
+    status_page.close();
+    sampler.stop();
+    ramp.stop();
     // Explicitly join the thermal polling thread before destructors run, so
     // logs are tidy and we don't risk a race against `thermal` going out of
     // scope while it's still polling. The destructor would do the same, but
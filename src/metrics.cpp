@@ -0,0 +1,114 @@
+#include "als-dimmer/metrics.hpp"
+#include <algorithm>
+
+namespace als_dimmer {
+
+constexpr size_t LatencyHistogram::BUCKETS;
+
+// ============================================================================
+// LatencyHistogram
+// ============================================================================
+
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& b : buckets_) {
+        b.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_us_.store(0, std::memory_order_relaxed);
+    max_us_.store(0, std::memory_order_relaxed);
+}
+
+// Bucket layout: 0-3 us map 1:1 to buckets 0-3. Above that, each power of
+// two [2^k, 2^(k+1)) is split into 4 equal sub-buckets starting at index
+// 4 * (k - 1).
+size_t LatencyHistogram::bucketFor(uint64_t us) {
+    if (us < 4) {
+        return static_cast<size_t>(us);
+    }
+    int msb = 63 - __builtin_clzll(us);
+    size_t sub = static_cast<size_t>((us >> (msb - 2)) & 3);
+    size_t index = static_cast<size_t>(msb - 1) * 4 + sub;
+    return std::min(index, BUCKETS - 1);
+}
+
+uint64_t LatencyHistogram::bucketUpperUs(size_t index) {
+    if (index < 4) {
+        return index;
+    }
+    int msb = static_cast<int>(index / 4) + 1;
+    uint64_t sub = index % 4;
+    uint64_t width = 1ULL << (msb - 2);
+    return ((4 + sub) << (msb - 2)) + width - 1;
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    buckets_[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(us, std::memory_order_relaxed);
+
+    uint64_t prev = max_us_.load(std::memory_order_relaxed);
+    while (us > prev &&
+           !max_us_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::percentileUs(double percent) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    // Nearest rank
+    uint64_t rank = static_cast<uint64_t>(percent / 100.0 * static_cast<double>(total) + 0.999999);
+    rank = std::max<uint64_t>(1, std::min(rank, total));
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketUpperUs(i), maxUs());
+        }
+    }
+    return maxUs();
+}
+
+// ============================================================================
+// Metrics
+// ============================================================================
+
+Metrics::Metrics() {
+    for (size_t i = 0; i < static_cast<size_t>(BusDevice::COUNT); ++i) {
+        transactions_[i].store(0, std::memory_order_relaxed);
+        errors_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Metrics::reset() {
+    for (auto& h : stages_) {
+        h.reset();
+    }
+    for (size_t i = 0; i < static_cast<size_t>(BusDevice::COUNT); ++i) {
+        transactions_[i].store(0, std::memory_order_relaxed);
+        errors_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* Metrics::stageName(Stage s) {
+    switch (s) {
+        case Stage::COMMAND_DRAIN: return "command_drain";
+        case Stage::SENSOR_READ:   return "sensor_read";
+        case Stage::ZONE_MAP:      return "zone_map";
+        case Stage::CONTROLLER:    return "controller";
+        case Stage::OUTPUT_WRITE:  return "output_write";
+        case Stage::CSV_LOG:       return "csv_log";
+        case Stage::NOTIFIER:      return "notifier";
+        case Stage::STATE_SAVE:    return "state_save";
+        case Stage::COUNT:
+        default:                   return "unknown";
+    }
+}
+
+} // namespace als_dimmer
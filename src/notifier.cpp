@@ -1,6 +1,7 @@
 #include "als-dimmer/notifier.hpp"
 #include "als-dimmer/logger.hpp"
 #include <sys/wait.h>
+#include <sched.h>
 #include <unistd.h>
 #include <signal.h>
 #include <cstring>
@@ -40,7 +41,7 @@ void Notifier::emitBrightnessChanged(int brightness) {
     invokeScript("brightness_changed", std::to_string(brightness));
 }
 
-void Notifier::emitZoneChanged(const std::string& zone) {
+void Notifier::emitZoneChanged(const char* zone) {
     if (!isEnabled()) return;
     if (zone == last_zone_) return;
 
@@ -50,6 +51,7 @@ void Notifier::emitZoneChanged(const std::string& zone) {
 
 void Notifier::invokeScript(const std::string& event_type, const std::string& value) {
     LOG_DEBUG("Notifier", "Emitting " << event_type << " = " << value);
+    invocations_++;
 
     // Fire-and-forget via fork+exec.
     // Double-fork to avoid zombies: the intermediate child exits immediately,
@@ -71,7 +73,17 @@ void Notifier::invokeScript(const std::string& event_type, const std::string& va
             _exit(0);
         }
 
-        // Grandchild — exec the callback script
+        // Grandchild — drop any CPU pinning inherited from a real-time
+        // control thread (control.realtime.cpus); its RT priority was
+        // already reset on fork.
+        cpu_set_t all_cpus;
+        CPU_ZERO(&all_cpus);
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            CPU_SET(cpu, &all_cpus);
+        }
+        sched_setaffinity(0, sizeof(all_cpus), &all_cpus);
+
+        // Exec the callback script
         execl(config_.on_change_script.c_str(),
               config_.on_change_script.c_str(),
               event_type.c_str(),
@@ -0,0 +1,125 @@
+#include "als-dimmer/output_cache.hpp"
+#include "als-dimmer/logger.hpp"
+#include "als-dimmer/metrics.hpp"
+
+namespace als_dimmer {
+
+CachedOutput::CachedOutput(std::unique_ptr<OutputInterface> inner, int verify_interval_sec)
+    : inner_(std::move(inner)),
+      verify_interval_sec_(verify_interval_sec) {
+}
+
+int64_t CachedOutput::nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool CachedOutput::init() {
+    if (!inner_->init()) {
+        return false;
+    }
+    verify();
+    return true;
+}
+
+bool CachedOutput::setBrightness(int brightness) {
+    if (brightness < 0) brightness = 0;
+    if (brightness > 100) brightness = 100;
+    if (brightness == cached_.load() && cache_exact_.load() && !verify_requested_.load()) {
+        return true;
+    }
+
+    bool ok;
+    {
+        ScopedStageTimer timer(Stage::OUTPUT_WRITE);
+        ok = inner_->setBrightness(brightness);
+    }
+    if (!ok) {
+        // Device state is unknown now - read it back next time it's asked for
+        requestVerify();
+        return false;
+    }
+    cached_.store(brightness);
+    cache_exact_.store(true);
+    markFresh(nowNs());
+    return true;
+}
+
+bool CachedOutput::setNativeBrightness(int native_value) {
+    bool ok;
+    {
+        ScopedStageTimer timer(Stage::OUTPUT_WRITE);
+        ok = inner_->setNativeBrightness(native_value);
+    }
+    if (!ok) {
+        requestVerify();
+        return false;
+    }
+    // Same nearest-percent rounding the native-capable outputs use
+    int native_max = inner_->getNativeMax();
+    if (native_value < 0) native_value = 0;
+    if (native_value > native_max) native_value = native_max;
+    cached_.store((native_value * 100 + native_max / 2) / native_max);
+    cache_exact_.store(false);  // a rounded percent; setBrightness() must still land exactly
+    markFresh(nowNs());
+    return true;
+}
+
+int CachedOutput::getCurrentBrightness() {
+    if (verifyDue()) {
+        return verify();
+    }
+    return cached_.load();
+}
+
+int64_t CachedOutput::msUntilVerify() const {
+    if (verify_requested_.load()) {
+        return 0;
+    }
+    if (verify_interval_sec_ <= 0) {
+        return -1;
+    }
+    int64_t last = last_attempt_ns_.load();
+    if (last < 0) {
+        return 0;
+    }
+    int64_t due_ns = last + static_cast<int64_t>(verify_interval_sec_) * 1000000000LL;
+    int64_t now_ns = nowNs();
+    return now_ns >= due_ns ? 0 : (due_ns - now_ns + 999999) / 1000000;
+}
+
+int CachedOutput::verify() {
+    verify_requested_.store(false);
+    int64_t now_ns = nowNs();
+    last_attempt_ns_.store(now_ns);  // a dead readback path isn't retried every call
+    int hw = inner_->getCurrentBrightness();
+    if (hw < 0) {
+        LOG_WARN("CachedOutput", "Readback from " << inner_->getType()
+                 << " failed; keeping cached " << cached_.load() << "%");
+        return cached_.load();
+    }
+
+    int previous = cached_.exchange(hw);
+    if (hw != previous && last_verify_ns_.load() >= 0) {
+        LOG_INFO("CachedOutput", inner_->getType() << " reads back " << hw
+                 << "%, cache had " << previous << "% (changed outside the daemon?)");
+    }
+    cache_exact_.store(true);
+    last_verify_ns_.store(now_ns);
+    markFresh(now_ns);
+    return hw;
+}
+
+int64_t CachedOutput::cacheAgeMs() const {
+    return (nowNs() - last_update_ns_.load()) / 1000000;
+}
+
+int64_t CachedOutput::verifiedAgeMs() const {
+    int64_t last = last_verify_ns_.load();
+    if (last < 0) {
+        return -1;
+    }
+    return (nowNs() - last) / 1000000;
+}
+
+} // namespace als_dimmer
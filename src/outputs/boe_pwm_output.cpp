@@ -1,5 +1,6 @@
 #include "als-dimmer/outputs/boe_pwm_output.hpp"
 #include "als-dimmer/logger.hpp"
+#include "als-dimmer/metrics.hpp"
 
 #include <fcntl.h>
 #include <linux/i2c-dev.h>
@@ -114,7 +115,9 @@ bool BoePwmOutput::configureMpq3367() {
     // Reg 0x01 = 0xAA : PSE=1, TH_S=01 (5V), FSW=01 (400kHz), CH=010 (4 strings)
     auto write_reg = [&](uint8_t reg, uint8_t val) -> bool {
         uint8_t buf[2] = {reg, val};
-        if (write(i2c_fd_, buf, 2) != 2) {
+        bool ok = write(i2c_fd_, buf, 2) == 2;
+        Metrics::getInstance().countTransaction(BusDevice::OUTPUT, ok);
+        if (!ok) {
             LOG_ERROR("BoePwmOutput", "I2C write reg 0x"
                       << std::hex << static_cast<int>(reg) << " failed: "
                       << std::dec << std::strerror(errno));
@@ -175,6 +178,7 @@ bool BoePwmOutput::writeSysfs(const std::string& path, const std::string& value)
     }
     f << value;
     f.flush();
+    Metrics::getInstance().countTransaction(BusDevice::OUTPUT, f.good());
     if (!f.good()) {
         LOG_ERROR("BoePwmOutput", "write '" << value << "' to " << path << " failed");
         return false;
@@ -182,6 +186,30 @@ bool BoePwmOutput::writeSysfs(const std::string& path, const std::string& value)
     return true;
 }
 
+// Per-brightness-change write: plain open/write into a stack buffer, so the
+// control loop doesn't allocate a filebuf and a string on every change.
+bool BoePwmOutput::writeDutyCycle(int duty_ns) {
+    char buf[16];
+    int len = std::snprintf(buf, sizeof(buf), "%d", duty_ns);
+    int fd = open(duty_cycle_path_.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOG_ERROR("BoePwmOutput", "open " << duty_cycle_path_ << " for write failed: "
+                  << std::strerror(errno));
+        Metrics::getInstance().countTransaction(BusDevice::OUTPUT, false);
+        return false;
+    }
+    bool ok = write(fd, buf, len) == len;
+    int saved_errno = errno;
+    close(fd);
+    Metrics::getInstance().countTransaction(BusDevice::OUTPUT, ok);
+    if (!ok) {
+        LOG_ERROR("BoePwmOutput", "write '" << buf << "' to " << duty_cycle_path_
+                  << " failed: " << std::strerror(saved_errno));
+        return false;
+    }
+    return true;
+}
+
 static bool dirExists(const std::string& path) {
     struct stat st;
     if (stat(path.c_str(), &st) != 0) return false;
@@ -334,7 +362,7 @@ bool BoePwmOutput::setBrightness(int brightness) {
         return true;
     }
 
-    if (!writeSysfs(duty_cycle_path_, std::to_string(duty_ns))) {
+    if (!writeDutyCycle(duty_ns)) {
         return false;
     }
 
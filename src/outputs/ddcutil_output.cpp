@@ -1,4 +1,5 @@
 #include "als-dimmer/interfaces.hpp"
+#include "als-dimmer/metrics.hpp"
 #include <iostream>
 #include <memory>
 
@@ -85,6 +86,7 @@ public:
 
         // VCP feature code 0x10 is brightness
         DDCA_Status rc = ddca_set_non_table_vcp_value(dh_, 0x10, 0, brightness);
+        Metrics::getInstance().countTransaction(BusDevice::OUTPUT, rc == 0);
 
         if (rc != 0) {
             std::cerr << "[DDCUtil] Failed to set brightness: " << ddca_rc_name(rc) << "\n";
@@ -102,6 +104,7 @@ public:
 
         DDCA_Non_Table_Vcp_Value valrec;
         DDCA_Status rc = ddca_get_non_table_vcp_value(dh_, 0x10, &valrec);
+        Metrics::getInstance().countTransaction(BusDevice::OUTPUT, rc == 0);
 
         if (rc != 0) {
             std::cerr << "[DDCUtil] Failed to get brightness: " << ddca_rc_name(rc) << "\n";
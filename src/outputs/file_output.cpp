@@ -1,9 +1,11 @@
 #include "als-dimmer/interfaces.hpp"
 #include "als-dimmer/logger.hpp"
-#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <memory>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace als_dimmer {
 
@@ -56,14 +58,18 @@ public:
     }
 
 private:
+    // open/write/close with a stack buffer: no allocation per write
     bool writeBrightnessToFile(int brightness) {
-        std::ofstream file(file_path_);
-        if (!file.is_open()) {
+        int fd = open(file_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
             return false;
         }
 
-        file << brightness << "\n";
-        return file.good();
+        char buf[16];
+        int len = std::snprintf(buf, sizeof(buf), "%d\n", brightness);
+        bool ok = write(fd, buf, len) == len;
+        close(fd);
+        return ok;
     }
 
     std::string file_path_;
@@ -1,8 +1,14 @@
 #include "als-dimmer/interfaces.hpp"
 #include "als-dimmer/logger.hpp"
+#include "als-dimmer/metrics.hpp"
 #include <fstream>
 #include <sstream>
 #include <memory>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace als_dimmer {
 
@@ -106,18 +112,52 @@ public:
         return "fpga_sysfs_dimmer";
     }
 
+    int getNativeMax() const override {
+        return max_value_;
+    }
+
+    bool setNativeBrightness(int native_value) override {
+        if (native_value < 0) {
+            native_value = 0;
+        } else if (native_value > max_value_) {
+            native_value = max_value_;
+        }
+
+        if (native_value == last_hw_value_) {
+            LOG_TRACE("FPGASysfsOutput", "Skipping write - value unchanged: " << native_value);
+            return true;
+        }
+
+        if (!writeToSysfs(native_value)) {
+            LOG_ERROR("FPGASysfsOutput", "Failed to write brightness " << native_value
+                      << " to " << sysfs_path_);
+            return false;
+        }
+
+        last_hw_value_ = native_value;
+        current_brightness_ = (native_value * 100 + max_value_ / 2) / max_value_;
+        return true;
+    }
+
 private:
+    // open/write/close with a stack buffer: no allocation per write
     bool writeToSysfs(int value) {
-        std::ofstream file(sysfs_path_);
-        if (!file.is_open()) {
+        int fd = open(sysfs_path_.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0) {
             LOG_ERROR("FPGASysfsOutput", "Cannot open sysfs node for writing: " << sysfs_path_);
+            Metrics::getInstance().countTransaction(BusDevice::OUTPUT, false);
             return false;
         }
 
-        file << value;
+        char buf[16];
+        int len = std::snprintf(buf, sizeof(buf), "%d", value);
+        bool ok = write(fd, buf, len) == len;
+        int saved_errno = errno;
+        close(fd);
+        Metrics::getInstance().countTransaction(BusDevice::OUTPUT, ok);
 
-        if (!file.good()) {
-            LOG_ERROR("FPGASysfsOutput", "Write failed to sysfs node");
+        if (!ok) {
+            LOG_ERROR("FPGASysfsOutput", "Write failed to sysfs node: " << strerror(saved_errno));
             return false;
         }
 
@@ -1,4 +1,5 @@
 #include "als-dimmer/outputs/i2c_dimmer_output.hpp"
+#include "als-dimmer/metrics.hpp"
 #include <iostream>
 #include <memory>
 #include <fcntl.h>
@@ -15,7 +16,8 @@ I2CDimmerOutput::I2CDimmerOutput(const std::string& device, uint8_t address, Dim
     , address_(address)
     , type_(type)
     , fd_(-1)
-    , current_brightness_(0) {
+    , current_brightness_(0)
+    , current_native_(0) {
 
     // Set parameters based on dimmer type
     if (type_ == DimmerType::DIMMER_200) {
@@ -66,17 +68,35 @@ bool I2CDimmerOutput::setBrightness(int brightness) {
     // Clamp to valid range
     brightness = std::max(0, std::min(100, brightness));
 
+    // Scale to native brightness
+    int native_value = scaleToNative(brightness);
+
     // Skip redundant I2C writes if value hasn't changed
-    if (brightness == current_brightness_) {
+    if (brightness == current_brightness_ && native_value == current_native_) {
         return true;
     }
 
-    // Scale to native brightness
-    int native_value = scaleToNative(brightness);
-
     // Write to I2C dimmer
     if (writeI2CBrightness(native_value)) {
         current_brightness_ = brightness;
+        current_native_ = native_value;
+        return true;
+    }
+
+    return false;
+}
+
+bool I2CDimmerOutput::setNativeBrightness(int native_value) {
+    native_value = std::max(0, std::min(max_native_brightness_, native_value));
+
+    // Skip redundant I2C writes if value hasn't changed
+    if (native_value == current_native_) {
+        return true;
+    }
+
+    if (writeI2CBrightness(native_value)) {
+        current_native_ = native_value;
+        current_brightness_ = (native_value * 100 + max_native_brightness_ / 2) / max_native_brightness_;
         return true;
     }
 
@@ -160,6 +180,7 @@ bool I2CDimmerOutput::writeI2CBrightness(int native_value) {
 
     // Write to I2C device
     ssize_t result = write(fd_, buffer, buffer_len);
+    Metrics::getInstance().countTransaction(BusDevice::OUTPUT, result == buffer_len);
     if (result != buffer_len) {
         std::cerr << "[I2CDimmer]  I2C write failed (wrote " << result << " of " << buffer_len
                   << " bytes): " << strerror(errno) << "\n";
@@ -207,6 +228,7 @@ bool I2CDimmerOutput::writeWhitePointRegister(uint8_t reg, int value) {
     };
 
     ssize_t result = write(fd_, buffer, sizeof(buffer));
+    Metrics::getInstance().countTransaction(BusDevice::OUTPUT, result == static_cast<ssize_t>(sizeof(buffer)));
     if (result != static_cast<ssize_t>(sizeof(buffer))) {
         std::cerr << "[I2CDimmer]  White-point I2C write failed for register 0x"
                   << std::hex << static_cast<int>(reg) << std::dec
@@ -1,5 +1,6 @@
 #include "als-dimmer/outputs/i2c_pwm_output.hpp"
 #include "als-dimmer/logger.hpp"
+#include "als-dimmer/metrics.hpp"
 
 #include <algorithm>
 #include <cerrno>
@@ -70,7 +71,9 @@ bool I2CPwmOutput::writeI2cByte(uint8_t slave_addr, uint8_t reg, uint8_t value)
         return false;
     }
     uint8_t buf[2] = {reg, value};
-    if (write(fd_, buf, 2) != 2) {
+    bool ok = write(fd_, buf, 2) == 2;
+    Metrics::getInstance().countTransaction(BusDevice::OUTPUT, ok);
+    if (!ok) {
         LOG_ERROR("I2CPwmOutput", "I2C write to 0x"
                   << std::hex << static_cast<int>(slave_addr)
                   << " reg 0x" << static_cast<int>(reg) << std::dec
@@ -176,6 +179,22 @@ bool I2CPwmOutput::setBrightness(int brightness) {
     return true;
 }
 
+bool I2CPwmOutput::setNativeBrightness(int native_value) {
+    native_value = std::max(0, std::min(max_value_, native_value));
+    if (native_value == last_native_value_) {
+        return true;
+    }
+
+    if (!writeI2cByte(address_, duty_register_,
+                      static_cast<uint8_t>(native_value))) {
+        return false;
+    }
+
+    last_native_value_ = native_value;
+    current_brightness_ = (native_value * 100 + max_value_ / 2) / max_value_;
+    return true;
+}
+
 std::unique_ptr<OutputInterface> createI2CPwmOutput(const std::string& device,
                                                     uint8_t address,
                                                     uint8_t duty_register,
@@ -0,0 +1,223 @@
+#include "als-dimmer/ramp_engine.hpp"
+#include "als-dimmer/logger.hpp"
+#include <sys/epoll.h>
+#include <algorithm>
+#include <cmath>
+
+namespace als_dimmer {
+
+namespace {
+enum : uint64_t { EV_FRAME = 1, EV_WAKE = 2 };
+}
+
+RampEngine::RampEngine(OutputInterface& output, const RampConfig& config)
+    : output_(output),
+      config_(config),
+      native_max_(std::max(1, output.getNativeMax())),
+      target_(0),
+      fade_ms_(0),
+      fading_(false),
+      last_native_(-1) {
+    int current = std::max(0, output_.getCurrentBrightness());
+    start_pos_ = static_cast<float>(current);
+    position_ = start_pos_;
+    target_ = current;
+    current_brightness_.store(current);
+}
+
+RampEngine::~RampEngine() {
+    stop();
+}
+
+bool RampEngine::start(const RealtimeProfile* realtime) {
+    if (!config_.enabled || started_) {
+        return true;
+    }
+    if (!loop_.init() || !frame_timer_.init() || !wake_.init() ||
+        !loop_.add(frame_timer_.fd(), EPOLLIN, EV_FRAME) ||
+        !loop_.add(wake_.fd(), EPOLLIN, EV_WAKE)) {
+        LOG_ERROR("RampEngine", "Failed to set up ramp event sources");
+        return false;
+    }
+
+    realtime_ = realtime;
+    stop_requested_.store(false);
+    started_ = true;
+    thread_ = std::thread(&RampEngine::run, this);
+    LOG_INFO("RampEngine", "Output ramp at " << config_.rate_hz << " Hz (native 0-" << native_max_
+             << ", fade up " << config_.fade_up_ms << " ms, down " << config_.fade_down_ms << " ms)");
+    return true;
+}
+
+void RampEngine::stop() {
+    if (!started_) return;
+    stop_requested_.store(true);
+    wake_.signal();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    started_ = false;
+    LOG_DEBUG("RampEngine", "Ramp stopped (" << framesWritten() << " frames written, "
+              << framesSkipped() << " skipped)");
+}
+
+bool RampEngine::setTarget(int brightness) {
+    brightness = std::max(0, std::min(100, brightness));
+    float from;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        from = position_;
+    }
+    int fade_ms = (brightness >= from) ? config_.fade_up_ms : config_.fade_down_ms;
+    return setTarget(brightness, fade_ms);
+}
+
+bool RampEngine::setTarget(int brightness, int fade_ms) {
+    brightness = std::max(0, std::min(100, brightness));
+
+    if (!config_.enabled) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            target_ = brightness;
+        }
+        return output_.setBrightness(brightness);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (brightness == target_) {
+            return true;  // already there or on the way
+        }
+        start_pos_ = position_;
+        target_ = brightness;
+        fade_ms_ = std::max(0, fade_ms);
+        fade_start_ = std::chrono::steady_clock::now();
+        fading_ = true;
+    }
+    wake_.signal();
+    return true;
+}
+
+void RampEngine::resync() {
+    if (!config_.enabled || !started_) {
+        resyncOutput();
+        return;
+    }
+    resync_requested_.store(true);
+    wake_.signal();
+}
+
+void RampEngine::resyncOutput() {
+    int target;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (fading_) {
+            return;  // The fade ends with a write of the target anyway
+        }
+        target = target_;
+    }
+    int hw = output_.getCurrentBrightness();
+    if (hw < 0 || hw == target) {
+        return;
+    }
+    LOG_INFO("RampEngine", "Output shows " << hw << "%, restoring " << target << "%");
+    output_.setBrightness(target);
+    last_native_ = -1;
+    current_brightness_.store(output_.getCurrentBrightness());
+}
+
+int RampEngine::currentBrightness() const {
+    if (!config_.enabled) {
+        return output_.getCurrentBrightness();
+    }
+    return current_brightness_.load();
+}
+
+bool RampEngine::frame(std::chrono::steady_clock::time_point now) {
+    float position;
+    int target;
+    bool done;
+    {
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!fading_) {
+            return false;
+        }
+        float elapsed_ms = std::chrono::duration<float, std::milli>(now - fade_start_).count();
+        float t = (fade_ms_ > 0) ? elapsed_ms / static_cast<float>(fade_ms_) : 1.0f;
+        done = t >= 1.0f;
+        position_ = done ? static_cast<float>(target_)
+                         : start_pos_ + (static_cast<float>(target_) - start_pos_) * t;
+        position = position_;
+        target = target_;
+        if (done) {
+            fading_ = false;
+        }
+    }
+
+    if (done) {
+        // Land exactly on the percent value so the output's own mapping
+        // (and getCurrentBrightness()) agree with the target
+        output_.setBrightness(target);
+        last_native_ = -1;
+        frames_written_.fetch_add(1, std::memory_order_relaxed);
+    } else {
+        int native = static_cast<int>(std::lround(position * native_max_ / 100.0f));
+        if (native != last_native_) {
+            output_.setNativeBrightness(native);
+            last_native_ = native;
+            frames_written_.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            frames_skipped_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    current_brightness_.store(output_.getCurrentBrightness());
+    return !done;
+}
+
+void RampEngine::run() {
+    const int frame_ms = std::max(1, 1000 / config_.rate_hz);
+    bool timer_armed = false;
+    if (realtime_) {
+        realtime_->applyToCurrentThread("ramp");
+    }
+
+    while (!stop_requested_.load()) {
+        EventLoop::Event events[2];
+        int n = loop_.wait(events, 2, -1);
+        if (n < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(frame_ms));
+            n = 0;
+        }
+
+        bool run_frame = false;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].token == EV_FRAME) {
+                frame_timer_.consume();
+                run_frame = true;
+            } else if (events[i].token == EV_WAKE) {
+                wake_.consume();
+                run_frame = true;  // new target: first frame right away
+            }
+        }
+        if (stop_requested_.load()) {
+            break;
+        }
+        if (resync_requested_.exchange(false)) {
+            resyncOutput();
+        }
+        if (!run_frame) {
+            continue;
+        }
+
+        bool fading = frame(std::chrono::steady_clock::now());
+        if (fading && !timer_armed) {
+            frame_timer_.armPeriodic(frame_ms);
+            timer_armed = true;
+        } else if (!fading && timer_armed) {
+            frame_timer_.disarm();
+            timer_armed = false;
+        }
+    }
+}
+
+} // namespace als_dimmer
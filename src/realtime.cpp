@@ -0,0 +1,148 @@
+#include "als-dimmer/realtime.hpp"
+#include "als-dimmer/logger.hpp"
+#include <alloca.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+namespace als_dimmer {
+
+std::atomic<bool> RealtimeProfile::memory_locked_{false};
+
+namespace {
+
+// Touch every page of the next `bytes` of stack so the thread's first deep
+// call path doesn't take page faults. With memory locked they stay resident.
+__attribute__((noinline)) void prefaultStack(size_t bytes) {
+    volatile unsigned char* stack = static_cast<volatile unsigned char*>(alloca(bytes));
+    for (size_t i = 0; i < bytes; i += 4096) {
+        stack[i] = 0;
+    }
+}
+
+const char* policyName(int policy) {
+    switch (policy) {
+        case SCHED_OTHER: return "other";
+        case SCHED_FIFO:  return "fifo";
+        case SCHED_RR:    return "rr";
+        case SCHED_BATCH: return "batch";
+        case SCHED_IDLE:  return "idle";
+        default:          return "unknown";
+    }
+}
+
+} // namespace
+
+RealtimeProfile::RealtimeProfile(const RealtimeConfig& config)
+    : config_(config) {
+}
+
+bool RealtimeProfile::lockMemory() {
+    if (!config_.enabled || !config_.lock_memory) {
+        return true;
+    }
+
+    // MCL_ONFAULT locks pages as they are touched instead of faulting in
+    // every mapping now - without it each thread's full 8 MB stack
+    // reservation becomes resident. Kernels before 4.4 reject it.
+    int rc = -1;
+#ifdef MCL_ONFAULT
+    rc = mlockall(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT);
+#endif
+    if (rc != 0) {
+        rc = mlockall(MCL_CURRENT | MCL_FUTURE);
+    }
+    if (rc != 0) {
+        LOG_WARN("Realtime", "mlockall failed: " << strerror(errno)
+                 << " (needs CAP_IPC_LOCK or a larger RLIMIT_MEMLOCK); memory not locked");
+        return false;
+    }
+    memory_locked_.store(true);
+    LOG_INFO("Realtime", "Process memory locked");
+    return true;
+}
+
+bool RealtimeProfile::applyToCurrentThread(const char* thread_name) const {
+    if (!config_.enabled) {
+        return true;
+    }
+    bool all_ok = true;
+
+    // CPU set first, so the thread never runs at RT priority elsewhere
+    if (!config_.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        std::ostringstream list;
+        for (size_t i = 0; i < config_.cpus.size(); ++i) {
+            CPU_SET(config_.cpus[i], &set);
+            list << (i ? "," : "") << config_.cpus[i];
+        }
+        if (sched_setaffinity(0, sizeof(set), &set) == 0) {
+            LOG_INFO("Realtime", thread_name << ": pinned to CPU " << list.str());
+        } else {
+            LOG_WARN("Realtime", thread_name << ": CPU affinity " << list.str()
+                     << " not applied: " << strerror(errno));
+            all_ok = false;
+        }
+    }
+
+    int policy = (config_.policy == "rr") ? SCHED_RR : SCHED_FIFO;
+    struct sched_param param;
+    std::memset(&param, 0, sizeof(param));
+    param.sched_priority = config_.priority;
+    if (sched_setscheduler(0, policy | SCHED_RESET_ON_FORK, &param) == 0) {
+        LOG_INFO("Realtime", thread_name << ": SCHED_" << (policy == SCHED_RR ? "RR" : "FIFO")
+                 << " priority " << config_.priority);
+    } else {
+        LOG_WARN("Realtime", thread_name << ": SCHED_" << (policy == SCHED_RR ? "RR" : "FIFO")
+                 << " priority " << config_.priority << " not applied: " << strerror(errno)
+                 << " (needs CAP_SYS_NICE or RLIMIT_RTPRIO); staying at normal priority");
+        all_ok = false;
+    }
+
+    if (config_.prefault_stack_kb > 0) {
+        prefaultStack(static_cast<size_t>(config_.prefault_stack_kb) * 1024);
+        LOG_DEBUG("Realtime", thread_name << ": prefaulted " << config_.prefault_stack_kb
+                  << " KB of stack");
+    }
+
+    return all_ok;
+}
+
+RealtimeProfile::ThreadState RealtimeProfile::currentThreadState() {
+    ThreadState state;
+    int policy = sched_getscheduler(0);
+    state.policy = policy < 0 ? "unknown" : policyName(policy & ~SCHED_RESET_ON_FORK);
+
+    struct sched_param param;
+    state.priority = (sched_getparam(0, &param) == 0) ? param.sched_priority : 0;
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        // Compress to ranges: 0,1,2,3,6 -> "0-3,6"
+        std::ostringstream list;
+        int run_start = -1;
+        for (int cpu = 0; cpu <= CPU_SETSIZE; ++cpu) {
+            bool in = cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set);
+            if (in && run_start < 0) {
+                run_start = cpu;
+            } else if (!in && run_start >= 0) {
+                if (list.tellp() > 0) {
+                    list << ",";
+                }
+                list << run_start;
+                if (cpu - 1 > run_start) {
+                    list << "-" << (cpu - 1);
+                }
+                run_start = -1;
+            }
+        }
+        state.cpus = list.str();
+    }
+    return state;
+}
+
+} // namespace als_dimmer
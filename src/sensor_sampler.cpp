@@ -0,0 +1,160 @@
+#include "als-dimmer/sensor_sampler.hpp"
+#include "als-dimmer/logger.hpp"
+#include "als-dimmer/metrics.hpp"
+#include <sys/epoll.h>
+#include <algorithm>
+
+namespace als_dimmer {
+
+constexpr size_t SensorSampler::RING_CAPACITY;
+
+namespace {
+enum : uint64_t { EV_WAKE = 1, EV_SENSOR = 2 };
+}
+
+SensorSampler::SensorSampler(SensorInterface& sensor) : sensor_(sensor) {
+}
+
+SensorSampler::~SensorSampler() {
+    stop();
+}
+
+bool SensorSampler::start(int interval_ms) {
+    if (started_) {
+        LOG_WARN("SensorSampler", "start() called twice; ignoring");
+        return true;
+    }
+    if (!loop_.init() || !wake_.init() || !sample_event_.init() ||
+        !loop_.add(wake_.fd(), EPOLLIN, EV_WAKE)) {
+        LOG_ERROR("SensorSampler", "Failed to set up sampler event sources");
+        return false;
+    }
+
+    if (sensor_.getPollFd() >= 0) {
+        LOG_INFO("SensorSampler", "Sensor " << sensor_.getType() << " provides a poll fd; "
+                 "samples are picked up on arrival");
+    }
+
+    interval_ms_.store(interval_ms);
+    stop_requested_.store(false);
+    started_ = true;
+    thread_ = std::thread(&SensorSampler::run, this);
+    LOG_INFO("SensorSampler", "Sampling " << sensor_.getType() << " every " << interval_ms << " ms");
+    return true;
+}
+
+void SensorSampler::requestStop() {
+    stop_requested_.store(true);
+    wake_.signal();
+}
+
+void SensorSampler::stop() {
+    if (!started_) return;
+    requestStop();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    started_ = false;
+    LOG_DEBUG("SensorSampler", "Sampler stopped (" << droppedSamples() << " samples dropped)");
+}
+
+void SensorSampler::setInterval(int interval_ms) {
+    if (interval_ms_.exchange(interval_ms) != interval_ms) {
+        wake_.signal();
+    }
+}
+
+void SensorSampler::setPaused(bool paused) {
+    if (paused_.exchange(paused) != paused) {
+        wake_.signal();
+    }
+}
+
+void SensorSampler::takeSample() {
+    SensorSample sample;
+    {
+        ScopedStageTimer timer(Stage::SENSOR_READ);
+        sample.lux = sensor_.readLux();
+    }
+    sample.healthy = sensor_.isHealthy();
+    sample.taken_at = std::chrono::steady_clock::now();
+
+    if (!ring_.push(sample)) {
+        // Consumer is RING_CAPACITY samples behind; it only needs the newest
+        // few anyway, so drop this one rather than block the sensor cadence.
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+    }
+    sample_event_.signal();
+}
+
+void SensorSampler::syncPollFd(bool paused) {
+    // Not watched while paused: an unread pushed sample would keep the fd
+    // ready and spin this thread. A sensor that reopened its device after
+    // a read error hands out a new fd (-1 in between), so follow it.
+    int wanted = paused ? -1 : sensor_.getPollFd();
+    if (wanted == poll_fd_) {
+        return;
+    }
+    if (poll_fd_ >= 0) {
+        loop_.remove(poll_fd_);  // Harmless if the sensor already closed it
+    }
+    poll_fd_ = -1;
+    if (wanted >= 0 && loop_.add(wanted, sensor_.getPollEvents(), EV_SENSOR)) {
+        poll_fd_ = wanted;
+    }
+}
+
+void SensorSampler::run() {
+    using clock = std::chrono::steady_clock;
+
+    auto next_read = clock::now();
+    bool was_paused = paused_.load();
+
+    while (!stop_requested_.load()) {
+        bool paused = paused_.load();
+        if (was_paused && !paused) {
+            next_read = clock::now();  // unpaused: read right away
+        }
+        was_paused = paused;
+        syncPollFd(paused);
+
+        int timeout_ms = -1;
+        if (!paused) {
+            auto until = std::chrono::duration_cast<std::chrono::milliseconds>(
+                next_read - clock::now()).count();
+            timeout_ms = static_cast<int>(std::max<int64_t>(0, until));
+        }
+
+        EventLoop::Event events[2];
+        int n = loop_.wait(events, 2, timeout_ms);
+        if (n < 0) {
+            // epoll failed - keep sampling on a plain sleep
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms_.load()));
+            n = 0;
+        }
+
+        bool read_now = false;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].token == EV_WAKE) {
+                wake_.consume();
+            } else if (events[i].token == EV_SENSOR && !paused_.load()) {
+                read_now = true;
+            }
+        }
+        if (stop_requested_.load()) {
+            break;
+        }
+        if (!paused_.load() && clock::now() >= next_read) {
+            read_now = true;
+        }
+
+        if (read_now) {
+            takeSample();
+            // Any read (timed or pushed) restarts the period, so a sensor
+            // that pushes on its own is only polled when it goes quiet.
+            next_read = clock::now() + std::chrono::milliseconds(interval_ms_.load());
+        }
+    }
+}
+
+} // namespace als_dimmer
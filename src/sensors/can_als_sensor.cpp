@@ -1,5 +1,6 @@
 #include "als-dimmer/sensors/can_als_sensor.hpp"
 #include "als-dimmer/logger.hpp"
+#include "als-dimmer/metrics.hpp"
 #include <cstring>
 #include <unistd.h>
 #include <fcntl.h>
@@ -156,11 +157,13 @@ bool CANALSSensor::receiveCANMessage(CANMessage& msg) {
             return false;
         }
         LOG_ERROR("CANALSSensor", "CAN receive error: " << strerror(errno));
+        Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
         return false;
     }
 
     if (nbytes < static_cast<int>(sizeof(frame))) {
         LOG_WARN("CANALSSensor", "Incomplete CAN frame received");
+        Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
         return false;
     }
 
@@ -174,8 +177,10 @@ bool CANALSSensor::receiveCANMessage(CANMessage& msg) {
     // Check data length
     if (frame.can_dlc != 8) {
         LOG_WARN("CANALSSensor", "Invalid CAN frame length: " << static_cast<int>(frame.can_dlc));
+        Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
         return false;
     }
+    Metrics::getInstance().countTransaction(BusDevice::SENSOR, true);
 
     // Copy data to our message structure
     std::memcpy(&msg, frame.data, sizeof(CANMessage));
@@ -1,4 +1,5 @@
 #include "als-dimmer/interfaces.hpp"
+#include "als-dimmer/metrics.hpp"
 #include <iostream>
 #include <memory>
 #include <cstring>
@@ -132,6 +133,7 @@ private:
         if (write(i2c_fd_, cmd, 4) != 4) {
             std::cerr << "[FPGA_OPT4001_LUX] Failed to write command: "
                       << strerror(errno) << "\n";
+            Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
             return false;
         }
 
@@ -139,8 +141,10 @@ private:
         if (read(i2c_fd_, buf, 4) != 4) {
             std::cerr << "[FPGA_OPT4001_LUX] Failed to read response: "
                       << strerror(errno) << "\n";
+            Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
             return false;
         }
+        Metrics::getInstance().countTransaction(BusDevice::SENSOR, true);
 
         value = (static_cast<uint32_t>(buf[0]) << 24) |
                 (static_cast<uint32_t>(buf[1]) << 16) |
@@ -1,4 +1,5 @@
 #include "als-dimmer/interfaces.hpp"
+#include "als-dimmer/metrics.hpp"
 #include <iostream>
 #include <memory>
 #include <cstring>
@@ -83,6 +84,7 @@ public:
         uint8_t cmd[4] = {0x00, 0x00, 0x00, 0x0C};
         if (write(i2c_fd_, cmd, 4) != 4) {
             std::cerr << "[FPGA_OPT4001] Failed to write command: " << strerror(errno) << "\n";
+            Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
             healthy_ = false;
             return -1.0f;
         }
@@ -91,9 +93,11 @@ public:
         uint8_t buf[4];
         if (read(i2c_fd_, buf, 4) != 4) {
             std::cerr << "[FPGA_OPT4001] Failed to read response: " << strerror(errno) << "\n";
+            Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
             healthy_ = false;
             return -1.0f;
         }
+        Metrics::getInstance().countTransaction(BusDevice::SENSOR, true);
 
         // Check for error condition (all bytes 0xFF)
         if (buf[0] == 0xFF && buf[1] == 0xFF && buf[2] == 0xFF && buf[3] == 0xFF) {
@@ -1,9 +1,11 @@
 #include "als-dimmer/interfaces.hpp"
 #include "als-dimmer/logger.hpp"
-#include <fstream>
+#include "als-dimmer/metrics.hpp"
 #include <sstream>
 #include <memory>
 #include <chrono>
+#include <fcntl.h>
+#include <unistd.h>
 
 namespace als_dimmer {
 
@@ -17,6 +19,13 @@ namespace als_dimmer {
  * Sysfs path example: /sys/class/harman_9090_fpga_ctrl/display_ivi/light_sensor_read
  * Raw value range: 0 - 16777215
  * Lux conversion: lux = raw_value * scale_factor
+ *
+ * The node is kept open for the sensor's lifetime and exposed via
+ * getPollFd(): if the driver calls sysfs_notify() on new conversions the
+ * sensor sampler wakes on EPOLLPRI, otherwise the fd simply never fires and
+ * timed reads keep polling as before. Reads go through the same fd
+ * (pread at offset 0) because that is what re-arms the kernfs notification.
+ * A failed read closes the fd, so the node is reopened on the next read.
  */
 class FPGAOpti4001SysfsSensor : public SensorInterface {
 public:
@@ -27,15 +36,19 @@ public:
         , healthy_(false)
         , consecutive_errors_(0)
         , last_read_time_(std::chrono::steady_clock::now())
+        , fd_(-1)
     {}
 
+    ~FPGAOpti4001SysfsSensor() override {
+        closeNode();
+    }
+
     bool init() override {
         LOG_DEBUG("FPGAOpti4001Sysfs", "Initializing with sysfs path: " << sysfs_path_);
         LOG_DEBUG("FPGAOpti4001Sysfs", "Scale factor: " << scale_factor_);
 
         // Try initial read to verify sysfs node exists and is accessible
-        std::ifstream file(sysfs_path_);
-        if (!file.is_open()) {
+        if (!openNode()) {
             LOG_WARN("FPGAOpti4001Sysfs", "Cannot open sysfs node (driver may not be loaded yet): " << sysfs_path_);
             // Don't fail init - driver might be loaded later
             healthy_ = false;
@@ -44,7 +57,7 @@ public:
 
         // Try to read a value to verify the node is functional
         std::string line;
-        if (std::getline(file, line)) {
+        if (readNode(line)) {
             try {
                 unsigned long raw_value = std::stoul(line);
                 last_lux_ = static_cast<float>(raw_value) * scale_factor_;
@@ -55,22 +68,26 @@ public:
                 LOG_WARN("FPGAOpti4001Sysfs", "Initial read parse error: " << e.what());
                 healthy_ = false;
             }
+        } else {
+            closeNode();  // Reopened by the first readLux()
         }
 
         return true;
     }
 
     float readLux() override {
-        std::ifstream file(sysfs_path_);
-        if (!file.is_open()) {
+        if (fd_ < 0 && !openNode()) {
             LOG_ERROR("FPGAOpti4001Sysfs", "Cannot open sysfs node: " << sysfs_path_);
             handleError();
             return -1.0f;
         }
 
         std::string line;
-        if (!std::getline(file, line)) {
+        if (!readNode(line)) {
             LOG_ERROR("FPGAOpti4001Sysfs", "Cannot read from sysfs node");
+            // The node may be gone (driver unloaded/reloaded): reopen it on
+            // the next read instead of retrying a stale handle forever
+            closeNode();
             handleError();
             return -1.0f;
         }
@@ -132,7 +149,48 @@ public:
         return "fpga_opti4001_sysfs";
     }
 
+    int getPollFd() const override {
+        return fd_;
+    }
+
+    // kernfs files always poll readable; only sysfs_notify() raises these
+    uint32_t getPollEvents() const override {
+        return EPOLLPRI | EPOLLERR;
+    }
+
 private:
+    bool openNode() {
+        fd_ = open(sysfs_path_.c_str(), O_RDONLY | O_CLOEXEC);
+        return fd_ >= 0;
+    }
+
+    // getPollFd() reads -1 until the next openNode(); the sensor sampler
+    // notices and registers the new fd then
+    void closeNode() {
+        if (fd_ >= 0) {
+            close(fd_);
+            fd_ = -1;
+        }
+    }
+
+    // Read the first line of the node from offset 0 (sysfs attributes are
+    // regenerated on every read from the start of the file).
+    bool readNode(std::string& line) {
+        char buf[64];
+        ssize_t n = pread(fd_, buf, sizeof(buf) - 1, 0);
+        Metrics::getInstance().countTransaction(BusDevice::SENSOR, n > 0);
+        if (n <= 0) {
+            return false;
+        }
+        buf[n] = '\0';
+        line.assign(buf);
+        size_t nl = line.find('\n');
+        if (nl != std::string::npos) {
+            line.erase(nl);
+        }
+        return true;
+    }
+
     void handleError() {
         consecutive_errors_++;
         if (consecutive_errors_ >= MAX_CONSECUTIVE_ERRORS) {
@@ -151,6 +209,7 @@ private:
     bool healthy_;
     int consecutive_errors_;
     std::chrono::steady_clock::time_point last_read_time_;
+    int fd_;  // Persistent handle; also the sysfs_notify poll fd
 };
 
 // Factory function
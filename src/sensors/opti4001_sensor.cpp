@@ -1,4 +1,5 @@
 #include "als-dimmer/interfaces.hpp"
+#include "als-dimmer/metrics.hpp"
 #include <iostream>
 #include <memory>
 #include <cstring>
@@ -198,6 +199,7 @@ private:
         // Write register address
         if (write(i2c_fd_, &reg, 1) != 1) {
             std::cerr << "[OPTI4001]  Failed to write register address: " << strerror(errno) << "\n";
+            Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
             return false;
         }
 
@@ -205,11 +207,13 @@ private:
         uint8_t buf[2];
         if (read(i2c_fd_, buf, 2) != 2) {
             std::cerr << "[OPTI4001]  Failed to read register value: " << strerror(errno) << "\n";
+            Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
             return false;
         }
 
         // Combine bytes (MSB first / big endian)
         value = (buf[0] << 8) | buf[1];
+        Metrics::getInstance().countTransaction(BusDevice::SENSOR, true);
         return true;
     }
 
@@ -221,9 +225,11 @@ private:
 
         if (write(i2c_fd_, buf, 3) != 3) {
             std::cerr << "[OPTI4001]  Failed to write register: " << strerror(errno) << "\n";
+            Metrics::getInstance().countTransaction(BusDevice::SENSOR, false);
             return false;
         }
 
+        Metrics::getInstance().countTransaction(BusDevice::SENSOR, true);
         return true;
     }
 
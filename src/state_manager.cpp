@@ -1,5 +1,6 @@
 #include "als-dimmer/state_manager.hpp"
 #include "als-dimmer/logger.hpp"
+#include "als-dimmer/metrics.hpp"
 #include "json.hpp"
 #include <fstream>
 #include <iostream>
@@ -64,6 +65,8 @@ bool StateManager::load() {
 }
 
 bool StateManager::save() {
+    ScopedStageTimer timer(Stage::STATE_SAVE);
+
     // Create directory if it doesn't exist
     char* path_copy = strdup(file_path_.c_str());
     char* dir = dirname(path_copy);
@@ -133,6 +136,10 @@ void StateManager::markDirty() {
 }
 
 std::string StateManager::modeToString(OperatingMode mode) {
+    return modeName(mode);
+}
+
+const char* StateManager::modeName(OperatingMode mode) {
     switch (mode) {
         case OperatingMode::AUTO:
             return "auto";
@@ -0,0 +1,87 @@
+#include "als-dimmer/status_page.hpp"
+#include "als-dimmer/logger.hpp"
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+namespace als_dimmer {
+
+StatusPageWriter::StatusPageWriter() : page_(nullptr), publish_count_(0) {
+}
+
+StatusPageWriter::~StatusPageWriter() {
+    close();
+}
+
+bool StatusPageWriter::open(const std::string& path) {
+    // Reuse an existing file rather than replacing it, so a reader that
+    // mapped it before a daemon restart keeps seeing live data. The path is
+    // usually in world-writable /dev/shm: never follow a symlink there, and
+    // only take over a plain file this user already owns, so nobody can
+    // point the daemon at another file or spoof the page.
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_NOFOLLOW | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("StatusPage", "Failed to open " << path << ": " << strerror(errno)
+                  << (errno == ELOOP ? " (it is a symlink)" : ""));
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid() || st.st_nlink != 1) {
+        LOG_ERROR("StatusPage", "Refusing to use " << path
+                  << ": not a regular file owned by this user; remove it and restart");
+        ::close(fd);
+        return false;
+    }
+    fchmod(fd, 0644);  // Whatever the umask, local readers need read access
+    if (ftruncate(fd, static_cast<off_t>(sizeof(StatusPage))) < 0) {
+        LOG_ERROR("StatusPage", "Failed to size " << path << ": " << strerror(errno));
+        ::close(fd);
+        return false;
+    }
+    void* addr = mmap(nullptr, sizeof(StatusPage), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        LOG_ERROR("StatusPage", "Failed to map " << path << ": " << strerror(errno));
+        return false;
+    }
+
+    page_ = static_cast<StatusPage*>(addr);
+    path_ = path;
+    publish_count_ = 0;
+
+    // Invalidate first so no reader trusts a half-initialised header
+    page_->magic.store(0, std::memory_order_release);
+    page_->layout_version = STATUS_PAGE_LAYOUT_VERSION;
+    page_->size = sizeof(StatusPage);
+    page_->daemon_pid = static_cast<int32_t>(getpid());
+    new (&page_->data) SeqLock<StatusPageData>();
+    page_->magic.store(STATUS_PAGE_MAGIC, std::memory_order_release);
+
+    LOG_INFO("StatusPage", "Publishing status to " << path);
+    return true;
+}
+
+void StatusPageWriter::close() {
+    if (page_ == nullptr) {
+        return;
+    }
+    page_->magic.store(0, std::memory_order_release);
+    munmap(page_, sizeof(StatusPage));
+    page_ = nullptr;
+    unlink(path_.c_str());
+}
+
+void StatusPageWriter::publish(StatusPageData& data) {
+    if (page_ == nullptr) {
+        return;
+    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);  // vDSO: no syscall
+    data.updated_ns = static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL +
+                      static_cast<uint64_t>(ts.tv_nsec);
+    data.publish_count = ++publish_count_;
+    page_->data.store(data);
+}
+
+} // namespace als_dimmer
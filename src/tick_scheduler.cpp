@@ -0,0 +1,119 @@
+#include "als-dimmer/tick_scheduler.hpp"
+#include "als-dimmer/logger.hpp"
+#include <cmath>
+#include <cstdlib>
+
+namespace als_dimmer {
+
+constexpr float TickScheduler::LUX_RATE_TAU_SEC;
+
+TickScheduler::TickScheduler(const ControlConfig& control)
+    : cfg_(control.adaptive_tick),
+      normal_interval_ms_(control.update_interval_ms),
+      rate_(Rate::NORMAL),
+      interval_ms_(control.update_interval_ms),
+      have_sample_(false),
+      last_log_lux_(0.0f),
+      lux_rate_percent_(0.0f),
+      settled_(false) {
+}
+
+void TickScheduler::addSample(float lux, std::chrono::steady_clock::time_point now) {
+    if (!cfg_.enabled || lux < 0.0f) {
+        return;
+    }
+
+    // +1 keeps log() finite in the dark and damps noise near 0 lux
+    float log_lux = std::log(lux + 1.0f);
+    if (!have_sample_) {
+        have_sample_ = true;
+        last_log_lux_ = log_lux;
+        last_sample_time_ = now;
+        return;
+    }
+
+    float dt = std::chrono::duration<float>(now - last_sample_time_).count();
+    if (dt <= 0.0f) {
+        return;
+    }
+
+    // Instantaneous relative rate (percent/s), then a first-order low-pass
+    // whose weight depends on dt so slow and fast ticks filter alike.
+    float instant = 100.0f * std::fabs(log_lux - last_log_lux_) / dt;
+    float alpha = dt / (LUX_RATE_TAU_SEC + dt);
+    lux_rate_percent_ += alpha * (instant - lux_rate_percent_);
+
+    last_log_lux_ = log_lux;
+    last_sample_time_ = now;
+}
+
+bool TickScheduler::wantsFastTick() const {
+    return cfg_.enabled && rate_ != Rate::FAST &&
+           lux_rate_percent_ >= cfg_.fast_lux_rate_percent;
+}
+
+int TickScheduler::update(int brightness_error, std::chrono::steady_clock::time_point now) {
+    if (!cfg_.enabled) {
+        return interval_ms_;
+    }
+
+    // No samples lately (sensor lost, or minimal_i2c skipping reads in
+    // MANUAL): a stale rate says nothing about the light, so forget it.
+    if (have_sample_ &&
+        now - last_sample_time_ > std::chrono::milliseconds(2 * cfg_.max_interval_ms)) {
+        have_sample_ = false;
+        lux_rate_percent_ = 0.0f;
+    }
+
+    Rate next;
+    if (lux_rate_percent_ >= cfg_.fast_lux_rate_percent) {
+        next = Rate::FAST;
+        settled_ = false;
+    } else if (lux_rate_percent_ <= cfg_.steady_lux_rate_percent &&
+               std::abs(brightness_error) <= cfg_.steady_error) {
+        if (!settled_) {
+            settled_ = true;
+            settled_since_ = now;
+        }
+        bool long_enough = now - settled_since_ >= std::chrono::seconds(cfg_.steady_time_sec);
+        next = long_enough ? Rate::SLOW : Rate::NORMAL;
+    } else {
+        next = Rate::NORMAL;
+        settled_ = false;
+    }
+
+    if (next != rate_) {
+        LOG_DEBUG("TickScheduler", "Tick " << rateToString(rate_) << " -> " << rateToString(next)
+                  << " (" << intervalFor(next) << " ms, lux rate " << lux_rate_percent_
+                  << " %/s, error " << brightness_error << ")");
+        rate_ = next;
+        interval_ms_ = intervalFor(next);
+    }
+    return interval_ms_;
+}
+
+int TickScheduler::intervalFor(Rate rate) const {
+    switch (rate) {
+        case Rate::FAST:
+            return cfg_.min_interval_ms;
+        case Rate::SLOW:
+            return cfg_.max_interval_ms;
+        case Rate::NORMAL:
+        default:
+            return normal_interval_ms_;
+    }
+}
+
+const char* TickScheduler::rateToString(Rate rate) {
+    switch (rate) {
+        case Rate::FAST:
+            return "fast";
+        case Rate::SLOW:
+            return "slow";
+        case Rate::NORMAL:
+        default:
+            return "normal";
+    }
+}
+
+} // namespace als_dimmer
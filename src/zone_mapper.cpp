@@ -66,9 +66,10 @@ const Zone* ZoneMapper::selectZone(float lux) const {
     return current_zone_;
 }
 
-std::string ZoneMapper::getCurrentZoneName(float lux) const {
+const std::string& ZoneMapper::getCurrentZoneName(float lux) const {
+    static const std::string unknown = "unknown";
     const Zone* zone = selectZone(lux);
-    return zone ? zone->name : "unknown";
+    return zone ? zone->name : unknown;
 }
 
 int ZoneMapper::calculateLinear(float lux, const Zone& zone) const {
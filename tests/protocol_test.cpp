@@ -0,0 +1,276 @@
+/**
+ * Protocol tests
+ *
+ * The JsonWriter fast paths (status responses, acknowledgements, the
+ * responses the main loop hands to ControlInterface::sendResponseTo(), and
+ * subscription events) must produce exactly the bytes the json DOM path
+ * does: clients written against the DOM output see no difference. Each
+ * check runs the shipped writer against the shipped DOM builder over
+ * awkward inputs - float/double edge cases, strings that need escaping,
+ * ids of every kind. A request rejected while parsing must still carry
+ * its id back, so the client can match the error to it.
+ *
+ * Run by ctest; exits non-zero on the first mismatch.
+ */
+
+#include "als-dimmer/control_interface.hpp"
+#include "als-dimmer/json_protocol.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+using als_dimmer::json;
+namespace protocol = als_dimmer::protocol;
+using als_dimmer::ControlInterface;
+using als_dimmer::SystemStatus;
+
+namespace {
+
+const char* const MODES[] = {"auto", "manual", "manual_temporary"};
+const int INTS[] = {0, 1, 64, 100, -1, -100, std::numeric_limits<int>::max(),
+                    std::numeric_limits<int>::min()};
+const float FLOATS[] = {0.0f, -0.0f, 0.1f, 1.0f, 312.5f, 3000.0f, 1e-7f, 123456.78f, 3.4e38f,
+                        std::numeric_limits<float>::quiet_NaN(),
+                        std::numeric_limits<float>::infinity()};
+const double DOUBLES[] = {0.0, -0.0, 1.0 / 3.0, 412.75, 0.97, 1e21, 1e-5, 5e-324, 41.5,
+                          -273.15, std::numeric_limits<double>::quiet_NaN()};
+const char* const STRINGS[] = {"indoor", "", "a\"b\\c", "tab\there\nnl\r\b\f", "\x01\x1f\x7f",
+                               "\xc3\xbc" "ber-bright \xe2\x98\x80", "/path/with/slashes"};
+const char* const IDS[] = {"", "42", "-7", "1.5", "\"abc\"", "\"with \\\"quotes\\\"\""};
+const int64_t AGES[] = {-1, 0, 123, 9007199254740993LL};
+
+template <typename T, size_t N>
+constexpr size_t countOf(const T (&)[N]) {
+    return N;
+}
+
+int g_failures = 0;
+
+bool same(const std::string& what, const std::string& fast, const std::string& dom) {
+    if (fast == dom) {
+        return true;
+    }
+    std::cerr << "MISMATCH in " << what << ":\n  writer: " << fast << "\n  dom:    " << dom << "\n";
+    g_failures++;
+    return false;
+}
+
+// The DOM path: dump, then the id
+std::string domText(const json& message, const std::string& id) {
+    std::string out = message.dump();
+    protocol::addRequestId(out, id);
+    return out;
+}
+
+void checkStatusResponses() {
+    std::mt19937 rng(7);
+    auto pick = [&rng](size_t n) { return static_cast<size_t>(rng() % n); };
+    std::string out;
+
+    for (int i = 0; i < 20000; ++i) {
+        const char* mode = MODES[pick(countOf(MODES))];
+        int brightness = INTS[pick(countOf(INTS))];
+        float lux = FLOATS[pick(countOf(FLOATS))];
+        const char* zone = STRINGS[pick(countOf(STRINGS))];
+        const char* sensor = (i & 1) ? "available" : "unavailable";
+        bool calibrated = (i & 2) != 0;
+        double nits = DOUBLES[pick(countOf(DOUBLES))];
+        bool thermal_enabled = (i & 4) != 0;
+        bool has_reading = (i & 8) != 0;
+        double temp = DOUBLES[pick(countOf(DOUBLES))];
+        double factor = DOUBLES[pick(countOf(DOUBLES))];
+        int64_t cache_age = AGES[pick(countOf(AGES))];
+        int64_t verified_age = AGES[pick(countOf(AGES))];
+        std::string id = IDS[pick(countOf(IDS))];
+
+        out.clear();
+        protocol::writeStatusResponse(out, id, mode, brightness, lux, zone, sensor, calibrated, nits,
+                                      thermal_enabled, has_reading, temp, factor, cache_age,
+                                      verified_age);
+        if (!same("status response", out,
+                  domText(protocol::makeStatusResponse(mode, brightness, lux, zone, sensor, calibrated,
+                                                       nits, thermal_enabled, has_reading, temp,
+                                                       factor, cache_age, verified_age), id))) {
+            return;
+        }
+    }
+}
+
+// What the main loop answers with, as ControlInterface::sendResponseTo()
+// writes it into the connection's buffer
+void checkResponses() {
+    std::string out;
+    protocol::Response response;
+
+    for (int b = -5; b <= 105; ++b) {
+        for (const char* id : IDS) {
+            json data;
+            data["brightness"] = b;
+            response.kind = protocol::Response::Kind::BRIGHTNESS_SET;
+            response.brightness = b;
+            out.clear();
+            protocol::writeResponse(out, id, response);
+            same("set_brightness ack", out,
+                 domText(protocol::makeResponse(protocol::ResponseStatus::SUCCESS,
+                                                "Brightness set successfully", data), id));
+
+            data["delta"] = b - 50;
+            response.kind = protocol::Response::Kind::BRIGHTNESS_ADJUSTED;
+            response.delta = b - 50;
+            out.clear();
+            protocol::writeResponse(out, id, response);
+            same("adjust_brightness ack", out,
+                 domText(protocol::makeResponse(protocol::ResponseStatus::SUCCESS,
+                                                "Brightness adjusted successfully", data), id));
+        }
+    }
+
+    for (const char* id : IDS) {
+        response.kind = protocol::Response::Kind::TEXT;
+        response.text = protocol::generateErrorResponse("Mode must be 'auto' or 'manual'",
+                                                        "INVALID_PARAMS");
+        out.clear();
+        protocol::writeResponse(out, id, response);
+        same("text response", out,
+             domText(protocol::makeErrorResponse("Mode must be 'auto' or 'manual'", "INVALID_PARAMS"),
+                     id));
+    }
+}
+
+void checkCoalescedResponses() {
+    const protocol::CommandType coalescable[] = {protocol::CommandType::SET_BRIGHTNESS,
+                                                 protocol::CommandType::SET_ABSOLUTE_BRIGHTNESS,
+                                                 protocol::CommandType::SET_MODE,
+                                                 protocol::CommandType::ADJUST_BRIGHTNESS};
+    std::string out;
+    for (protocol::CommandType type : coalescable) {
+        for (const char* id : IDS) {
+            json data;
+            data["coalesced"] = true;
+            out.clear();
+            protocol::writeCoalescedResponse(out, id, type);
+            same("coalesced answer", out,
+                 domText(protocol::makeResponse(
+                             protocol::ResponseStatus::SUCCESS,
+                             "Superseded by a newer " + protocol::commandTypeToString(type) + " command",
+                             data), id));
+        }
+    }
+}
+
+void checkBatchResponses() {
+    const char* const results[] = {"[]", "[{\"id\":1,\"status\":\"success\"}]",
+                                   "[{\"a\":1.5},{\"b\":null},{\"c\":\"x\\\"y\"}]"};
+    std::string out;
+    for (const char* text : results) {
+        for (int errors = 0; errors <= 2; ++errors) {
+            for (const char* id : IDS) {
+                json data;
+                data["errors"] = errors;
+                data["results"] = json::parse(text);
+                out.clear();
+                protocol::writeBatchResponse(out, id, text, errors);
+                same("batch response", out,
+                     domText(protocol::makeResponse(protocol::ResponseStatus::SUCCESS,
+                                                    errors == 0 ? "Batch executed"
+                                                                : "Batch executed with errors",
+                                                    data), id));
+            }
+        }
+    }
+}
+
+// The daemon's own event writer against its DOM builder, every topic
+void checkEvents() {
+    std::mt19937 rng(11);
+    auto pick = [&rng](size_t n) { return static_cast<size_t>(rng() % n); };
+    const als_dimmer::OperatingMode modes[] = {als_dimmer::OperatingMode::AUTO,
+                                               als_dimmer::OperatingMode::MANUAL,
+                                               als_dimmer::OperatingMode::MANUAL_TEMPORARY};
+    std::string out;
+
+    for (int i = 0; i < 5000; ++i) {
+        SystemStatus status;
+        status.mode = modes[pick(countOf(modes))];
+        status.lux = FLOATS[pick(countOf(FLOATS))];
+        status.current_brightness = INTS[pick(countOf(INTS))];
+        std::strncpy(status.zone, STRINGS[pick(countOf(STRINGS))], sizeof(status.zone) - 1);
+        status.sensor_available = (i & 1) != 0;
+        status.nits = DOUBLES[pick(countOf(DOUBLES))];
+        status.thermal_has_reading = (i & 2) != 0;
+        status.backlight_temp_c = DOUBLES[pick(countOf(DOUBLES))];
+        status.thermal_factor = DOUBLES[pick(countOf(DOUBLES))];
+        bool calibrated = (i & 4) != 0;
+
+        for (uint32_t topic = 0; topic < ControlInterface::TOPIC_COUNT; ++topic) {
+            out.clear();
+            ControlInterface::writeEvent(out, topic, status, calibrated);
+            if (!same("event", out, ControlInterface::makeEvent(topic, status, calibrated).dump())) {
+                return;
+            }
+        }
+    }
+}
+
+// Requests that fail after the id has been read: bad params, a malformed
+// or unbatchable batch. parseCommand() must leave the id in place for the
+// error response.
+void checkErrorIds() {
+    const char* const rejected[] = {
+        R"({"command":"set_brightness","params":{"brightness":"high"}})",
+        R"({"command":"set_brightness","params":{}})",
+        R"({"command":"set_mode","params":{"mode":7}})",
+        R"({"command":"batch","params":{"commands":[]}})",
+        R"({"command":"batch","params":{"commands":[{"command":"set_brightness","params":{}}]}})",
+        R"({"command":"batch","params":{"commands":[{"command":"nope"}]}})",
+        R"({"command":"batch","params":{"commands":[{"command":"batch","params":{"commands":[]}}]}})",
+    };
+
+    protocol::ParsedCommand cmd;
+    for (const char* text : rejected) {
+        for (const char* id : IDS) {
+            json request = json::parse(text);
+            if (id[0] != '\0') {
+                request["id"] = json::parse(id);
+            }
+            std::string bytes = request.dump();
+            bool threw = false;
+            try {
+                protocol::parseCommand(bytes.data(), bytes.size(), protocol::Encoding::JSON, cmd);
+            } catch (const std::invalid_argument&) {
+                threw = true;
+            }
+            if (!threw) {
+                std::cerr << "ACCEPTED: " << bytes << "\n";
+                g_failures++;
+                return;
+            }
+            if (!same("id of rejected " + bytes, cmd.id, id[0] != '\0' ? json::parse(id).dump() : "")) {
+                return;
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main() {
+    checkStatusResponses();
+    checkResponses();
+    checkCoalescedResponses();
+    checkBatchResponses();
+    checkEvents();
+    checkErrorIds();
+
+    if (g_failures > 0) {
+        std::cerr << g_failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "All protocol checks passed\n";
+    return 0;
+}
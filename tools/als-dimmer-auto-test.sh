@@ -5,6 +5,10 @@
 # Ramps brightness up and down in a loop to stress-test I2C bus contention
 # between als-dimmer and other I2C devices (e.g., himax touch controller).
 #
+# All steps go over one persistent connection (als-dimmer-client --batch), so
+# the timing summary at the end measures the daemon rather than process
+# startup. --spawn runs one client process per step instead.
+#
 # Usage:
 #   ./als-dimmer-auto-test.sh --brlow=5 --brhigh=99 --waitms=200 --loopcount=20
 # ==============================================================================
@@ -17,6 +21,7 @@ BR_HIGH=99
 WAIT_MS=200
 LOOP_COUNT=20
 CLIENT="als-dimmer-client"
+SPAWN=0
 
 # Parse arguments
 for arg in "$@"; do
@@ -26,6 +31,7 @@ for arg in "$@"; do
         --waitms=*)   WAIT_MS="${arg#*=}" ;;
         --loopcount=*) LOOP_COUNT="${arg#*=}" ;;
         --client=*)   CLIENT="${arg#*=}" ;;
+        --spawn)      SPAWN=1 ;;
         --help|-h)
             echo "Usage: $0 [OPTIONS]"
             echo ""
@@ -35,6 +41,7 @@ for arg in "$@"; do
             echo "  --waitms=N      Wait time in ms between steps (default: 200)"
             echo "  --loopcount=N   Number of ramp-up/down cycles (default: 20)"
             echo "  --client=PATH   Path to als-dimmer-client (default: als-dimmer-client)"
+            echo "  --spawn         Start one client process per step (old behaviour)"
             exit 0
             ;;
         *)
@@ -64,25 +71,47 @@ echo "  Brightness range: $BR_LOW - $BR_HIGH"
 echo "  Wait between steps: ${WAIT_MS}ms"
 echo "  Ramp-up/down cycles: $LOOP_COUNT"
 echo "  Client: $CLIENT"
+if [ "$SPAWN" -eq 1 ]; then
+    echo "  Mode: one client process per step"
+else
+    echo "  Mode: one persistent connection"
+fi
 echo "======================================"
 echo ""
 
-for cycle in $(seq 1 "$LOOP_COUNT"); do
-    echo "[Cycle $cycle/$LOOP_COUNT] Ramp UP: $BR_LOW -> $BR_HIGH"
-    for br in $(seq "$BR_LOW" "$BR_HIGH"); do
-        $CLIENT --brightness="$br" >/dev/null 2>&1 || echo "  [WARN] Failed to set brightness=$br"
-        sleep "$WAIT_SEC"
+# One line per step in als-dimmer-client --batch syntax
+generate_steps() {
+    for cycle in $(seq 1 "$LOOP_COUNT"); do
+        echo "# Cycle $cycle/$LOOP_COUNT"
+        for br in $(seq "$BR_LOW" "$BR_HIGH") $(seq "$BR_HIGH" -1 "$BR_LOW"); do
+            echo "brightness=$br"
+            echo "sleep $WAIT_MS"
+        done
     done
+}
 
-    echo "[Cycle $cycle/$LOOP_COUNT] Ramp DOWN: $BR_HIGH -> $BR_LOW"
-    for br in $(seq "$BR_HIGH" -1 "$BR_LOW"); do
-        $CLIENT --brightness="$br" >/dev/null 2>&1 || echo "  [WARN] Failed to set brightness=$br"
-        sleep "$WAIT_SEC"
-    done
-
-    echo "[Cycle $cycle/$LOOP_COUNT] Complete"
+if [ "$SPAWN" -eq 0 ]; then
+    # Failed steps are reported by the client; the summary is on stderr
+    generate_steps | $CLIENT --batch --quiet || echo "  [WARN] Some steps failed"
     echo ""
-done
+else
+    for cycle in $(seq 1 "$LOOP_COUNT"); do
+        echo "[Cycle $cycle/$LOOP_COUNT] Ramp UP: $BR_LOW -> $BR_HIGH"
+        for br in $(seq "$BR_LOW" "$BR_HIGH"); do
+            $CLIENT --brightness="$br" >/dev/null 2>&1 || echo "  [WARN] Failed to set brightness=$br"
+            sleep "$WAIT_SEC"
+        done
+
+        echo "[Cycle $cycle/$LOOP_COUNT] Ramp DOWN: $BR_HIGH -> $BR_LOW"
+        for br in $(seq "$BR_HIGH" -1 "$BR_LOW"); do
+            $CLIENT --brightness="$br" >/dev/null 2>&1 || echo "  [WARN] Failed to set brightness=$br"
+            sleep "$WAIT_SEC"
+        done
+
+        echo "[Cycle $cycle/$LOOP_COUNT] Complete"
+        echo ""
+    done
+fi
 
 echo "======================================"
 echo "  Stress test complete: $LOOP_COUNT cycles"
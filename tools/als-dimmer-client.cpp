@@ -8,7 +8,14 @@
 #include <string>
 #include <cstring>
 #include <cstdlib>
+#include <cerrno>
+#include <cmath>
 #include <sstream>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
@@ -23,6 +30,10 @@ constexpr const char* DEFAULT_IP = "127.0.0.1";
 constexpr int DEFAULT_PORT = 9000;
 constexpr const char* DEFAULT_SOCKET = "/tmp/als-dimmer.sock";
 
+// Batch/interactive sessions: requests allowed in flight at once
+constexpr int DEFAULT_WINDOW = 16;
+constexpr int MAX_WINDOW = 1024;
+
 // Exit codes
 constexpr int EXIT_SUCCESS_CODE = 0;
 constexpr int EXIT_INVALID_ARGS = 1;
@@ -54,13 +65,25 @@ struct CommandConfig {
         SET_ABSOLUTE_BRIGHTNESS,
         GET_MAX_BRIGHTNESS,
         GET_MIN_BRIGHTNESS,
-        GET_CALIBRATION_INFO
+        GET_CALIBRATION_INFO,
+        GET_LOOP_STATS,
+        GET_METRICS,
+        SUBSCRIBE
     };
     Type type = Type::NONE;
     int value = 0;
     double float_value = 0.0;  // for set_absolute_brightness (nits is a double)
     std::string mode;
+    std::string topics;        // for subscribe: comma-separated, or "all"
+    int min_interval_ms = 0;   // for subscribe
     bool json_output = false;
+
+    // Session modes: many commands over one connection instead of one
+    bool batch = false;        // --batch[=FILE]
+    bool interactive = false;  // --interactive
+    std::string batch_file;    // empty or "-" reads stdin
+    int window = DEFAULT_WINDOW;
+    bool quiet = false;        // only errors and the summary
 };
 
 void printUsage(const char* program_name) {
@@ -72,6 +95,14 @@ void printUsage(const char* program_name) {
               << "  --use-unix-socket    Use Unix domain socket instead of TCP\n\n"
               << "Output Options:\n"
               << "  --json               Output raw JSON response\n\n"
+              << "Session Options (one connection, many commands):\n"
+              << "  --batch[=FILE]       Run the commands in FILE (default: stdin), one per line\n"
+              << "  --interactive        Read commands from the terminal and print each response\n"
+              << "  --window=N           Requests in flight at once (default: " << DEFAULT_WINDOW << ")\n"
+              << "  --quiet              Print only errors and the timing summary\n"
+              << "  Each line is a command without the leading '--' (brightness=75, status,\n"
+              << "  adjust=-5, ...), a raw JSON request, 'sleep MS' to pause sending, or a\n"
+              << "  '#' comment. A timing summary goes to stderr at the end.\n\n"
               << "Commands:\n"
               << "  --status                  Get daemon status (mode, brightness, lux, zone, sensor, nits)\n"
               << "  --brightness              Get current brightness (0-100)\n"
@@ -83,7 +114,13 @@ void printUsage(const char* program_name) {
               << "  --absolute-brightness=N   Set brightness to N nits (requires calibrated LUT)\n"
               << "  --max-brightness          Print max nits supported by the loaded calibration LUT\n"
               << "  --min-brightness          Print min nits supported by the loaded calibration LUT\n"
-              << "  --calibration-info        Show LUT status, range, label, output_type tag\n\n"
+              << "  --calibration-info        Show LUT status, range, label, output_type tag\n"
+              << "  --loop-stats              Show control loop period jitter and overruns\n"
+              << "  --metrics                 Show per-stage latency and I2C transaction counters\n"
+              << "  --subscribe=TOPICS        Stream change events until interrupted; TOPICS is a\n"
+              << "                            comma list of brightness,mode,zone,lux,thermal,sensor\n"
+              << "                            or 'all'\n"
+              << "  --min-interval=MS         With --subscribe: at most one event per topic per MS\n\n"
               << "Examples:\n"
               << "  " << program_name << " --status\n"
               << "  " << program_name << " --brightness=75\n"
@@ -93,9 +130,11 @@ void printUsage(const char* program_name) {
               << "  " << program_name << " --absolute-brightness=750    # set 750 nits\n"
               << "  " << program_name << " --max-brightness             # discover panel range\n"
               << "  " << program_name << " --calibration-info\n"
+              << "  " << program_name << " --subscribe=brightness,mode --min-interval=200\n"
               << "  " << program_name << " --ip=192.168.1.100 --port=9000 --status\n"
               << "  " << program_name << " --use-unix-socket --status\n"
-              << "  " << program_name << " --status --json\n";
+              << "  " << program_name << " --status --json\n"
+              << "  printf 'brightness=20\\nsleep 500\\nstatus\\n' | " << program_name << " --batch\n";
 }
 
 std::string parseArgValue(const char* arg, const char* /*prefix*/) {
@@ -156,6 +195,60 @@ std::string buildJsonRequest(const std::string& command, const std::string& para
     return oss.str();
 }
 
+// Subscribe request: "all" omits the topic list, which the daemon reads as everything
+std::string buildSubscribeRequest(const std::string& topics, int min_interval_ms) {
+    std::ostringstream oss;
+    oss << "{\"version\":\"1.0\",\"command\":\"subscribe\",\"params\":{";
+    if (topics != "all") {
+        oss << "\"topics\":[";
+        size_t start = 0;
+        while (start <= topics.length()) {
+            size_t end = topics.find(',', start);
+            if (end == std::string::npos) {
+                end = topics.length();
+            }
+            oss << (start > 0 ? "," : "") << "\"" << topics.substr(start, end - start) << "\"";
+            start = end + 1;
+        }
+        oss << "],";
+    }
+    oss << "\"min_interval_ms\":" << min_interval_ms << "}}";
+    return oss.str();
+}
+
+// JSON request for a parsed command; empty if there is nothing to send
+std::string buildRequest(const CommandConfig& cmd) {
+    switch (cmd.type) {
+        case CommandConfig::Type::GET_STATUS:
+            return buildJsonRequest("get_status");
+        case CommandConfig::Type::GET_BRIGHTNESS:
+        case CommandConfig::Type::GET_MODE:
+            return buildJsonRequest("get_config");
+        case CommandConfig::Type::SET_BRIGHTNESS:
+            return buildJsonRequest("set_brightness", "brightness", cmd.value);
+        case CommandConfig::Type::SET_MODE:
+            return buildJsonRequest("set_mode", "mode", cmd.mode);
+        case CommandConfig::Type::ADJUST_BRIGHTNESS:
+            return buildJsonRequest("adjust_brightness", "delta", cmd.value);
+        case CommandConfig::Type::GET_ABSOLUTE_BRIGHTNESS:
+            return buildJsonRequest("get_absolute_brightness");
+        case CommandConfig::Type::SET_ABSOLUTE_BRIGHTNESS:
+            return buildJsonRequest("set_absolute_brightness", "nits", cmd.float_value);
+        case CommandConfig::Type::GET_MAX_BRIGHTNESS:
+        case CommandConfig::Type::GET_MIN_BRIGHTNESS:
+        case CommandConfig::Type::GET_CALIBRATION_INFO:
+            return buildJsonRequest("get_calibration_info");
+        case CommandConfig::Type::GET_LOOP_STATS:
+            return buildJsonRequest("get_loop_stats");
+        case CommandConfig::Type::GET_METRICS:
+            return buildJsonRequest("get_metrics");
+        case CommandConfig::Type::SUBSCRIBE:
+            return buildSubscribeRequest(cmd.topics, cmd.min_interval_ms);
+        default:
+            return "";
+    }
+}
+
 bool parseArguments(int argc, char* argv[], ConnectionConfig& conn, CommandConfig& cmd) {
     if (argc < 2) {
         return false;
@@ -221,6 +314,38 @@ bool parseArguments(int argc, char* argv[], ConnectionConfig& conn, CommandConfi
             cmd.type = CommandConfig::Type::GET_MIN_BRIGHTNESS;
         } else if (arg == "--calibration-info") {
             cmd.type = CommandConfig::Type::GET_CALIBRATION_INFO;
+        } else if (arg == "--loop-stats") {
+            cmd.type = CommandConfig::Type::GET_LOOP_STATS;
+        } else if (arg == "--metrics") {
+            cmd.type = CommandConfig::Type::GET_METRICS;
+        } else if (arg.rfind("--subscribe=", 0) == 0) {
+            cmd.type = CommandConfig::Type::SUBSCRIBE;
+            cmd.topics = parseArgValue(argv[i], "--subscribe=");
+            if (cmd.topics.empty()) {
+                std::cerr << "Error: --subscribe needs at least one topic (or 'all')\n";
+                return false;
+            }
+        } else if (arg.rfind("--min-interval=", 0) == 0) {
+            cmd.min_interval_ms = std::stoi(parseArgValue(argv[i], "--min-interval="));
+            if (cmd.min_interval_ms < 0 || cmd.min_interval_ms > 60000) {
+                std::cerr << "Error: --min-interval must be between 0 and 60000\n";
+                return false;
+            }
+        } else if (arg == "--batch") {
+            cmd.batch = true;
+        } else if (arg.rfind("--batch=", 0) == 0) {
+            cmd.batch = true;
+            cmd.batch_file = parseArgValue(argv[i], "--batch=");
+        } else if (arg == "--interactive") {
+            cmd.interactive = true;
+        } else if (arg.rfind("--window=", 0) == 0) {
+            cmd.window = std::stoi(parseArgValue(argv[i], "--window="));
+            if (cmd.window < 1 || cmd.window > MAX_WINDOW) {
+                std::cerr << "Error: --window must be between 1 and " << MAX_WINDOW << "\n";
+                return false;
+            }
+        } else if (arg == "--quiet") {
+            cmd.quiet = true;
         } else if (arg == "--help" || arg == "-h") {
             return false;
         } else {
@@ -229,7 +354,15 @@ bool parseArguments(int argc, char* argv[], ConnectionConfig& conn, CommandConfi
         }
     }
 
-    if (cmd.type == CommandConfig::Type::NONE) {
+    if (cmd.batch && cmd.interactive) {
+        std::cerr << "Error: --batch and --interactive are exclusive\n\n";
+        return false;
+    }
+    if ((cmd.batch || cmd.interactive) && cmd.type != CommandConfig::Type::NONE) {
+        std::cerr << "Error: In --batch/--interactive mode commands come from the input\n\n";
+        return false;
+    }
+    if (cmd.type == CommandConfig::Type::NONE && !cmd.batch && !cmd.interactive) {
         std::cerr << "Error: No command specified\n\n";
         return false;
     }
@@ -290,8 +423,9 @@ int connectToServer(const ConnectionConfig& conn) {
 }
 
 std::string sendCommand(int sock_fd, const std::string& json_request) {
-    // Send request
-    ssize_t sent = send(sock_fd, json_request.c_str(), json_request.length(), 0);
+    // Send request (one newline-terminated line per command)
+    std::string line = json_request + "\n";
+    ssize_t sent = send(sock_fd, line.c_str(), line.length(), 0);
     if (sent < 0) {
         std::cerr << "Error: Failed to send command: " << strerror(errno) << "\n";
         return "";
@@ -309,6 +443,52 @@ std::string sendCommand(int sock_fd, const std::string& json_request) {
     return std::string(buffer);
 }
 
+// Send the subscribe request, then print every line the daemon pushes
+// (the acknowledgement, then one JSON event per line) until it hangs up.
+int runSubscription(int sock_fd, const std::string& json_request) {
+    std::string line = json_request + "\n";
+    if (send(sock_fd, line.c_str(), line.length(), 0) < 0) {
+        std::cerr << "Error: Failed to send command: " << strerror(errno) << "\n";
+        return EXIT_SEND_FAILED;
+    }
+
+    std::string pending;
+    bool acknowledged = false;
+    char buffer[4096];
+    for (;;) {
+        ssize_t received = recv(sock_fd, buffer, sizeof(buffer), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        pending.append(buffer, static_cast<size_t>(received));
+
+        size_t start = 0;
+        size_t nl;
+        while ((nl = pending.find('\n', start)) != std::string::npos) {
+            std::string msg = pending.substr(start, nl - start);
+            start = nl + 1;
+            if (!acknowledged) {
+                acknowledged = true;
+                if (extractJsonValue(msg, "status") != "success") {
+                    std::cerr << "Error: " << extractJsonValue(msg, "message") << "\n";
+                    return EXIT_COMMAND_FAILED;
+                }
+            }
+            std::cout << msg << std::endl;
+        }
+        pending.erase(0, start);
+    }
+
+    if (!acknowledged) {
+        std::cerr << "Error: Failed to receive response\n";
+        return EXIT_RECEIVE_FAILED;
+    }
+    return EXIT_SUCCESS_CODE;
+}
+
 // Format a raw JSON-string nits value for human display: 1 decimal place.
 // Daemon emits doubles at full precision (good for --json and machine
 // consumers); the client rounds for readability. Falls back to the raw
@@ -470,6 +650,51 @@ bool printResponse(const std::string& json_response, const CommandConfig& cmd) {
             }
             break;
         }
+        case CommandConfig::Type::GET_LOOP_STATS: {
+            std::cout << "Loop (interval " << extractJsonValue(json_response, "interval_ms")
+                      << " ms, last " << extractJsonValue(json_response, "samples") << " ticks):\n"
+                      << "  Period us min/avg/max/p99: "
+                      << extractJsonValue(json_response, "period_min_us") << " / "
+                      << extractJsonValue(json_response, "period_avg_us") << " / "
+                      << extractJsonValue(json_response, "period_max_us") << " / "
+                      << extractJsonValue(json_response, "period_p99_us") << "\n"
+                      << "  Jitter us avg/max/p99: "
+                      << extractJsonValue(json_response, "jitter_avg_us") << " / "
+                      << extractJsonValue(json_response, "jitter_max_us") << " / "
+                      << extractJsonValue(json_response, "jitter_p99_us") << "\n"
+                      << "  Work us avg/max: "
+                      << extractJsonValue(json_response, "work_avg_us") << " / "
+                      << extractJsonValue(json_response, "work_max_us") << "\n"
+                      << "  Ticks: " << extractJsonValue(json_response, "ticks")
+                      << ", missed: " << extractJsonValue(json_response, "missed_ticks")
+                      << ", overruns: " << extractJsonValue(json_response, "overruns") << "\n"
+                      << "  Scheduling: " << extractJsonValue(json_response, "sched_policy")
+                      << " priority " << extractJsonValue(json_response, "sched_priority")
+                      << ", CPUs " << extractJsonValue(json_response, "cpus")
+                      << ", memory locked: " << extractJsonValue(json_response, "memory_locked") << "\n";
+            break;
+        }
+        case CommandConfig::Type::GET_METRICS: {
+            static const char* const stages[] = {
+                "command_drain", "sensor_read", "zone_map", "controller",
+                "output_write", "csv_log", "notifier", "state_save"
+            };
+            std::cout << "Stage latency (us)     count      p50      p90      p99      max\n";
+            for (const char* stage : stages) {
+                std::string s(stage);
+                std::cout << "  " << std::left << std::setw(16) << s << std::right
+                          << std::setw(11) << extractJsonValue(json_response, s + "_count")
+                          << std::setw(9) << extractJsonValue(json_response, s + "_p50_us")
+                          << std::setw(9) << extractJsonValue(json_response, s + "_p90_us")
+                          << std::setw(9) << extractJsonValue(json_response, s + "_p99_us")
+                          << std::setw(9) << extractJsonValue(json_response, s + "_max_us") << "\n";
+            }
+            std::cout << "Sensor transactions: " << extractJsonValue(json_response, "sensor_transactions")
+                      << " (errors: " << extractJsonValue(json_response, "sensor_errors") << ")\n"
+                      << "Output transactions: " << extractJsonValue(json_response, "output_transactions")
+                      << " (errors: " << extractJsonValue(json_response, "output_errors") << ")\n";
+            break;
+        }
         default:
             std::cout << json_response << "\n";
             break;
@@ -477,6 +702,330 @@ bool printResponse(const std::string& json_response, const CommandConfig& cmd) {
     return true;
 }
 
+// ---------------------------------------------------------------------------
+// Batch and interactive sessions
+//
+// Every line of input becomes one request on a single connection. Requests
+// carry a client-assigned "id" so responses can be matched even when the
+// daemon answers them out of order (queries skip the command queue,
+// superseded writes are answered early). Up to cmd.window requests are in
+// flight at once; the round trip of each is timed for the summary.
+// ---------------------------------------------------------------------------
+
+struct InFlight {
+    CommandConfig cmd;  // Type::NONE for raw JSON lines (printed as-is)
+    std::chrono::steady_clock::time_point sent;
+};
+
+struct SessionStats {
+    int sent = 0;
+    int completed = 0;
+    int errors = 0;
+    int coalesced = 0;
+    int rejected = 0;           // Lines that never became a request
+    std::vector<double> latency_us;
+    std::chrono::steady_clock::time_point first_sent;
+    std::chrono::steady_clock::time_point last_done;
+};
+
+bool sendAll(int sock_fd, const std::string& data) {
+    size_t off = 0;
+    while (off < data.size()) {
+        ssize_t n = send(sock_fd, data.data() + off, data.size() - off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        off += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Turn one input line into a request. Returns false (after printing why)
+// if the line is not a command; `cmd` keeps the parsed form for printing.
+bool buildSessionRequest(const std::string& line, const CommandConfig& defaults,
+                         CommandConfig& cmd, std::string& request) {
+    if (line[0] == '{') {
+        cmd = CommandConfig();
+        cmd.json_output = true;
+        request = line;
+        return true;
+    }
+    if (line[0] == '[') {
+        std::cerr << "Error: Bare batch arrays cannot be matched to a response here; "
+                     "use {\"command\":\"batch\",...}\n";
+        return false;
+    }
+
+    // Client options without the leading "--": "brightness=75 --json"
+    std::vector<std::string> words{"session"};
+    std::istringstream iss(line);
+    std::string word;
+    while (iss >> word) {
+        words.push_back(word.rfind("-", 0) == 0 ? word : "--" + word);
+    }
+    std::vector<char*> argv;
+    for (auto& w : words) {
+        argv.push_back(&w[0]);
+    }
+
+    ConnectionConfig ignored;
+    cmd = CommandConfig();
+    cmd.json_output = defaults.json_output;
+    try {
+        if (!parseArguments(static_cast<int>(argv.size()), argv.data(), ignored, cmd)) {
+            return false;
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Error: Invalid value in '" << line << "'\n";
+        return false;
+    }
+    if (cmd.batch || cmd.interactive) {
+        std::cerr << "Error: Sessions cannot be nested\n";
+        return false;
+    }
+    request = buildRequest(cmd);
+    return !request.empty();
+}
+
+double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void printSessionSummary(SessionStats& stats) {
+    std::sort(stats.latency_us.begin(), stats.latency_us.end());
+    double elapsed_s = stats.completed > 0
+        ? std::chrono::duration<double>(stats.last_done - stats.first_sent).count()
+        : 0.0;
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(3)
+        << "Summary: " << stats.completed << "/" << stats.sent << " commands in " << elapsed_s << " s";
+    if (elapsed_s > 0.0) {
+        oss << std::setprecision(1) << " (" << (stats.completed / elapsed_s) << " commands/s)";
+    }
+    oss << ", " << stats.errors << " errors, " << stats.coalesced << " coalesced";
+    if (stats.rejected > 0) {
+        oss << ", " << stats.rejected << " invalid lines";
+    }
+    oss << "\n";
+    if (!stats.latency_us.empty()) {
+        const auto& l = stats.latency_us;
+        oss << std::setprecision(3)
+            << "Latency ms: min " << l.front() / 1000.0
+            << "  p50 " << percentile(l, 0.50) / 1000.0
+            << "  p90 " << percentile(l, 0.90) / 1000.0
+            << "  p99 " << percentile(l, 0.99) / 1000.0
+            << "  max " << l.back() / 1000.0 << "\n";
+    }
+    std::cerr << oss.str();
+}
+
+int runSession(int sock_fd, int in_fd, const CommandConfig& session) {
+    using Clock = std::chrono::steady_clock;
+
+    const bool prompt = session.interactive && isatty(in_fd);
+    std::map<std::string, InFlight> in_flight;  // Keyed by the id as it appears in the response
+    SessionStats stats;
+    std::string input;
+    std::string received;
+    bool input_eof = false;
+    bool prompted = false;
+    Clock::time_point resume_at = Clock::now();  // "sleep MS" holds sending until then
+    long long next_id = 1;
+    int rc = EXIT_SUCCESS_CODE;
+
+    for (;;) {
+        // Send whatever the window and any pending sleep allow
+        size_t nl;
+        while (static_cast<int>(in_flight.size()) < session.window && Clock::now() >= resume_at &&
+               (nl = input.find('\n')) != std::string::npos) {
+            std::string line = input.substr(0, nl);
+            input.erase(0, nl + 1);
+            prompted = false;
+
+            size_t first = line.find_first_not_of(" \t\r");
+            if (first == std::string::npos || line[first] == '#') {
+                continue;
+            }
+            line = line.substr(first, line.find_last_not_of(" \t\r") - first + 1);
+
+            if (line.rfind("sleep ", 0) == 0) {
+                resume_at = Clock::now() + std::chrono::milliseconds(std::atoi(line.c_str() + 6));
+                continue;
+            }
+            if (line == "quit" || line == "exit") {
+                input_eof = true;
+                input.clear();
+                break;
+            }
+
+            CommandConfig cmd;
+            std::string request;
+            if (!buildSessionRequest(line, session, cmd, request)) {
+                stats.rejected++;
+                continue;
+            }
+
+            std::string key = extractJsonValue(request, "id");
+            if (key.empty()) {
+                key = std::to_string(next_id++);
+                size_t body = request.find_first_not_of(" \t", 1);
+                bool empty_object = body != std::string::npos && request[body] == '}';
+                request.insert(1, "\"id\":" + key + (empty_object ? "" : ","));
+            } else if (in_flight.count(key) != 0) {
+                std::cerr << "Error: id " << key << " is already in flight\n";
+                stats.rejected++;
+                continue;
+            }
+
+            Clock::time_point now = Clock::now();
+            if (!sendAll(sock_fd, request + "\n")) {
+                std::cerr << "Error: Failed to send command: " << strerror(errno) << "\n";
+                return EXIT_SEND_FAILED;
+            }
+            if (stats.sent++ == 0) {
+                stats.first_sent = now;
+            }
+            in_flight[key] = InFlight{cmd, now};
+        }
+
+        if (input_eof && in_flight.empty() && input.find('\n') == std::string::npos) {
+            break;
+        }
+
+        if (prompt && !prompted && in_flight.empty() && input.find('\n') == std::string::npos) {
+            std::cout << "als> " << std::flush;
+            prompted = true;
+        }
+
+        // Wait for responses, more input, or the end of a sleep
+        struct pollfd fds[2];
+        fds[0].fd = sock_fd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = in_fd;
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        bool want_input = !input_eof && input.find('\n') == std::string::npos;
+        int timeout_ms = -1;
+        Clock::time_point now = Clock::now();
+        if (resume_at > now && input.find('\n') != std::string::npos) {
+            timeout_ms = static_cast<int>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(resume_at - now).count()) + 1;
+        }
+        if (poll(fds, want_input ? 2 : 1, timeout_ms) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "Error: poll failed: " << strerror(errno) << "\n";
+            return EXIT_RECEIVE_FAILED;
+        }
+
+        if (want_input && (fds[1].revents & (POLLIN | POLLHUP)) != 0) {
+            char buffer[4096];
+            ssize_t n = read(in_fd, buffer, sizeof(buffer));
+            if (n > 0) {
+                input.append(buffer, static_cast<size_t>(n));
+            } else if (n == 0 || errno != EINTR) {
+                input_eof = true;
+                if (!input.empty() && input.back() != '\n') {
+                    input += '\n';  // Last line without a newline
+                }
+                if (prompt) {
+                    std::cout << "\n";
+                }
+            }
+        }
+
+        if ((fds[0].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+            continue;
+        }
+        char buffer[4096];
+        ssize_t n = recv(sock_fd, buffer, sizeof(buffer), 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (!in_flight.empty()) {
+                std::cerr << "Error: Connection closed with " << in_flight.size()
+                          << " responses outstanding\n";
+                rc = EXIT_RECEIVE_FAILED;
+            }
+            break;
+        }
+        received.append(buffer, static_cast<size_t>(n));
+
+        size_t start = 0;
+        while ((nl = received.find('\n', start)) != std::string::npos) {
+            std::string msg = received.substr(start, nl - start);
+            start = nl + 1;
+
+            std::string id = extractJsonValue(msg, "id");
+            auto it = in_flight.find(id);
+            if (it == in_flight.end() && id.empty() && extractJsonValue(msg, "status") == "error") {
+                // The daemon can't echo the id of a request it failed to
+                // parse. Only raw JSON lines can be malformed, so charge it
+                // to the oldest one still in flight rather than wait forever.
+                for (auto cand = in_flight.begin(); cand != in_flight.end(); ++cand) {
+                    if (cand->second.cmd.type == CommandConfig::Type::NONE &&
+                        (it == in_flight.end() || cand->second.sent < it->second.sent)) {
+                        it = cand;
+                    }
+                }
+            }
+            if (it == in_flight.end()) {
+                // Subscription event (or a response we cannot place)
+                if (!session.quiet) {
+                    std::cout << msg << std::endl;
+                }
+                continue;
+            }
+
+            Clock::time_point done = Clock::now();
+            stats.completed++;
+            stats.last_done = done;
+            stats.latency_us.push_back(
+                std::chrono::duration<double, std::micro>(done - it->second.sent).count());
+            if (extractJsonValue(msg, "coalesced") == "true") {
+                stats.coalesced++;
+            }
+
+            bool ok;
+            if (session.quiet) {
+                ok = extractJsonValue(msg, "status") != "error";
+                if (!ok) {
+                    std::cerr << "Error: " << extractJsonValue(msg, "message") << "\n";
+                }
+            } else {
+                try {
+                    ok = printResponse(msg, it->second.cmd);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Failed to parse response: " << e.what() << "\n";
+                    ok = false;
+                }
+                std::cout << std::flush;
+            }
+            if (!ok) {
+                stats.errors++;
+            }
+            in_flight.erase(it);
+        }
+        received.erase(0, start);
+    }
+
+    printSessionSummary(stats);
+    if (rc == EXIT_SUCCESS_CODE && (stats.errors > 0 || stats.rejected > 0)) {
+        rc = EXIT_COMMAND_FAILED;
+    }
+    return rc;
+}
+
 int main(int argc, char* argv[]) {
     ConnectionConfig conn;
     CommandConfig cmd;
@@ -487,39 +1036,20 @@ int main(int argc, char* argv[]) {
         return EXIT_INVALID_ARGS;
     }
 
-    // Build JSON request
     std::string json_request;
-    switch (cmd.type) {
-        case CommandConfig::Type::GET_STATUS:
-            json_request = buildJsonRequest("get_status");
-            break;
-        case CommandConfig::Type::GET_BRIGHTNESS:
-        case CommandConfig::Type::GET_MODE:
-            json_request = buildJsonRequest("get_config");
-            break;
-        case CommandConfig::Type::SET_BRIGHTNESS:
-            json_request = buildJsonRequest("set_brightness", "brightness", cmd.value);
-            break;
-        case CommandConfig::Type::SET_MODE:
-            json_request = buildJsonRequest("set_mode", "mode", cmd.mode);
-            break;
-        case CommandConfig::Type::ADJUST_BRIGHTNESS:
-            json_request = buildJsonRequest("adjust_brightness", "delta", cmd.value);
-            break;
-        case CommandConfig::Type::GET_ABSOLUTE_BRIGHTNESS:
-            json_request = buildJsonRequest("get_absolute_brightness");
-            break;
-        case CommandConfig::Type::SET_ABSOLUTE_BRIGHTNESS:
-            json_request = buildJsonRequest("set_absolute_brightness", "nits", cmd.float_value);
-            break;
-        case CommandConfig::Type::GET_MAX_BRIGHTNESS:
-        case CommandConfig::Type::GET_MIN_BRIGHTNESS:
-        case CommandConfig::Type::GET_CALIBRATION_INFO:
-            json_request = buildJsonRequest("get_calibration_info");
-            break;
-        default:
+    int in_fd = STDIN_FILENO;
+    if (!cmd.batch && !cmd.interactive) {
+        json_request = buildRequest(cmd);
+        if (json_request.empty()) {
             std::cerr << "Error: Invalid command\n";
             return EXIT_INVALID_ARGS;
+        }
+    } else if (!cmd.batch_file.empty() && cmd.batch_file != "-") {
+        in_fd = open(cmd.batch_file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in_fd < 0) {
+            std::cerr << "Error: Cannot open " << cmd.batch_file << ": " << strerror(errno) << "\n";
+            return EXIT_INVALID_ARGS;
+        }
     }
 
     // Connect to server
@@ -528,6 +1058,21 @@ int main(int argc, char* argv[]) {
         return EXIT_CONNECTION_FAILED;
     }
 
+    if (cmd.batch || cmd.interactive) {
+        int rc = runSession(sock_fd, in_fd, cmd);
+        close(sock_fd);
+        if (in_fd != STDIN_FILENO) {
+            close(in_fd);
+        }
+        return rc;
+    }
+
+    if (cmd.type == CommandConfig::Type::SUBSCRIBE) {
+        int rc = runSubscription(sock_fd, json_request);
+        close(sock_fd);
+        return rc;
+    }
+
     // Send command and receive response
     std::string json_response = sendCommand(sock_fd, json_request);
     close(sock_fd);
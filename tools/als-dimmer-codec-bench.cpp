@@ -0,0 +1,265 @@
+/**
+ * ALS-Dimmer Codec Benchmark
+ * Measures what the control protocol's wire encodings (JSON text, CBOR,
+ * MessagePack - see the `hello` command) cost per message, on the same
+ * code paths the daemon uses: building and encoding a get_status response
+ * and a subscription event, decoding them on the client side, and parsing
+ * a set_brightness request on the daemon side.
+ *
+ * It also times the JsonWriter fast path that JSON connections use for
+ * status responses, brightness acknowledgements and events against the
+ * json DOM it replaces. That both give the same bytes is checked by the
+ * protocol test (tests/protocol_test.cpp), not here.
+ *
+ * Usage: als-dimmer-codec-bench [iterations]
+ */
+
+#include "als-dimmer/alloc_check.hpp"
+#include "als-dimmer/control_interface.hpp"
+#include "als-dimmer/json_protocol.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using als_dimmer::json;
+namespace protocol = als_dimmer::protocol;
+using protocol::Encoding;
+
+namespace {
+
+constexpr int DEFAULT_ITERATIONS = 200000;
+
+// Keeps the optimizer from discarding benchmarked work
+volatile size_t g_sink = 0;
+
+// Heap allocations per call of `fn`, after a warm-up call (counted by
+// src/alloc_check.cpp, linked into this tool)
+double allocationsPerOp(const std::function<void()>& fn) {
+    fn();
+    uint64_t before = als_dimmer::alloc_check::threadAllocations();
+    for (int i = 0; i < 100; ++i) {
+        fn();
+    }
+    return static_cast<double>(als_dimmer::alloc_check::threadAllocations() - before) / 100.0;
+}
+
+double nsPerOp(int iterations, const std::function<void()>& fn) {
+    for (int i = 0; i < iterations / 10; ++i) {
+        fn();  // Warm up caches and the allocator
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        fn();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+           iterations;
+}
+
+json statusMessage() {
+    return protocol::makeStatusResponse("auto", 64, 312.5f, "indoor", "available", true, 412.75,
+                                        true, true, 41.5, 0.97, 120, 2500);
+}
+
+als_dimmer::SystemStatus eventStatus() {
+    als_dimmer::SystemStatus status;
+    status.current_brightness = 64;
+    status.nits = 412.75;
+    return status;
+}
+
+// A brightness event with nits, as the daemon builds it for subscribers
+json eventMessage() {
+    return als_dimmer::ControlInterface::makeEvent(als_dimmer::ControlInterface::TOPIC_BRIGHTNESS,
+                                                   eventStatus(), true);
+}
+
+// Wire bytes of `message` without the frame header or newline
+std::string payload(const json& message, Encoding encoding) {
+    std::string out;
+    protocol::encodeMessage(message, encoding, out);
+    if (encoding == Encoding::JSON) {
+        out.pop_back();
+    } else {
+        out.erase(0, protocol::FRAME_HEADER_BYTES);
+    }
+    return out;
+}
+
+json decode(const std::string& bytes, Encoding encoding) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(bytes.data());
+    switch (encoding) {
+        case Encoding::CBOR:
+            return json::from_cbor(data, data + bytes.size());
+        case Encoding::MSGPACK:
+            return json::from_msgpack(data, data + bytes.size());
+        case Encoding::JSON:
+        default:
+            return json::parse(bytes);
+    }
+}
+
+void printRow(const std::string& what, Encoding encoding, size_t bytes, double ns, double json_ns) {
+    std::cout << "  " << std::left << std::setw(34) << what
+              << std::setw(9) << protocol::encodingToString(encoding)
+              << std::right << std::setw(7) << bytes
+              << std::setw(11) << std::fixed << std::setprecision(0) << ns
+              << std::setw(9) << std::setprecision(2) << (json_ns / ns) << "x\n";
+}
+
+// The DOM path as the daemon used it before the fast path: dump, then id
+std::string domText(const json& message, const std::string& id) {
+    std::string out = message.dump();
+    protocol::addRequestId(out, id);
+    return out;
+}
+
+void printFastRow(const std::string& what, double ns, double allocs, double dom_ns) {
+    std::cout << "  " << std::left << std::setw(43) << what << std::right
+              << std::setw(11) << std::fixed << std::setprecision(0) << ns
+              << std::setw(10) << std::setprecision(1) << allocs
+              << std::setw(9) << std::setprecision(2) << (dom_ns / ns) << "x\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = DEFAULT_ITERATIONS;
+    if (argc > 1) {
+        iterations = std::atoi(argv[1]);
+        if (iterations <= 0) {
+            std::cerr << "Usage: " << argv[0] << " [iterations]\n";
+            return 1;
+        }
+    }
+
+    const Encoding encodings[] = {Encoding::JSON, Encoding::CBOR, Encoding::MSGPACK};
+    const struct {
+        const char* name;
+        json (*build)();
+    } messages[] = {
+        {"get_status response", statusMessage},
+        {"brightness event", eventMessage},
+    };
+
+    std::cout << "Iterations: " << iterations << "\n\n"
+              << "  " << std::left << std::setw(34) << "Operation" << std::setw(9) << "Encoding"
+              << std::right << std::setw(7) << "Bytes" << std::setw(11) << "ns/op"
+              << std::setw(10) << "vs JSON" << "\n";
+
+    for (const auto& msg : messages) {
+        json prebuilt = msg.build();
+        double json_build = 0.0;
+        double json_encode = 0.0;
+        double json_decode = 0.0;
+
+        for (Encoding encoding : encodings) {
+            std::string bytes = payload(prebuilt, encoding);
+            std::string out;
+
+            // What the daemon pays per message: build the DOM, then encode
+            double build = nsPerOp(iterations, [&]() {
+                out.clear();
+                protocol::encodeMessage(msg.build(), encoding, out);
+                g_sink = g_sink + out.size();
+            });
+            // Encoding alone, from an existing DOM
+            double encode = nsPerOp(iterations, [&]() {
+                out.clear();
+                protocol::encodeMessage(prebuilt, encoding, out);
+                g_sink = g_sink + out.size();
+            });
+            // What a client pays to read it back
+            double dec = nsPerOp(iterations, [&]() {
+                g_sink = g_sink + decode(bytes, encoding).size();
+            });
+
+            if (encoding == Encoding::JSON) {
+                json_build = build;
+                json_encode = encode;
+                json_decode = dec;
+            }
+            printRow(std::string(msg.name) + ": build+encode", encoding, bytes.size(), build, json_build);
+            printRow(std::string(msg.name) + ": encode", encoding, bytes.size(), encode, json_encode);
+            printRow(std::string(msg.name) + ": decode", encoding, bytes.size(), dec, json_decode);
+        }
+        std::cout << "\n";
+    }
+
+    // Daemon side: turning a request into a ParsedCommand
+    json request;
+    request["version"] = als_dimmer::PROTOCOL_VERSION;
+    request["id"] = 42;
+    request["command"] = "set_brightness";
+    request["params"]["brightness"] = 64;
+    double json_parse = 0.0;
+    for (Encoding encoding : encodings) {
+        std::string bytes = payload(request, encoding);
+        double parse = nsPerOp(iterations, [&]() {
+            protocol::ParsedCommand cmd = protocol::parseCommand(bytes.data(), bytes.size(), encoding);
+            g_sink = g_sink + static_cast<size_t>(cmd.type);
+        });
+        if (encoding == Encoding::JSON) {
+            json_parse = parse;
+        }
+        printRow("set_brightness request: parse", encoding, bytes.size(), parse, json_parse);
+    }
+
+    // JSON text without a DOM, as JSON connections get it
+    const std::string id = "42";
+    const als_dimmer::SystemStatus event_status = eventStatus();
+    std::string out;
+    const struct {
+        const char* name;
+        std::function<void()> dom;
+        std::function<void()> fast;
+    } fast_paths[] = {
+        {"get_status response",
+         [&]() { g_sink = g_sink + domText(statusMessage(), id).size(); },
+         [&]() {
+             out.clear();
+             protocol::writeStatusResponse(out, id, "auto", 64, 312.5f, "indoor", "available", true,
+                                           412.75, true, true, 41.5, 0.97, 120, 2500);
+             g_sink = g_sink + out.size();
+         }},
+        {"set_brightness ack",
+         [&]() {
+             json data;
+             data["brightness"] = 64;
+             g_sink = g_sink + domText(protocol::makeResponse(protocol::ResponseStatus::SUCCESS,
+                                                              "Brightness set successfully", data),
+                                       id).size();
+         },
+         [&]() {
+             out.clear();
+             protocol::writeBrightnessResponse(out, id, 64);
+             g_sink = g_sink + out.size();
+         }},
+        {"brightness event",
+         [&]() { g_sink = g_sink + eventMessage().dump().size(); },
+         [&]() {
+             out.clear();
+             als_dimmer::ControlInterface::writeEvent(
+                 out, als_dimmer::ControlInterface::TOPIC_BRIGHTNESS, event_status, true);
+             g_sink = g_sink + out.size();
+         }},
+    };
+
+    std::cout << "\n  " << std::left << std::setw(43) << "JSON text"
+              << std::right << std::setw(11) << "ns/op" << std::setw(10) << "allocs"
+              << std::setw(10) << "vs DOM" << "\n";
+    for (const auto& path : fast_paths) {
+        double dom = nsPerOp(iterations, path.dom);
+        double fast = nsPerOp(iterations, path.fast);
+        printFastRow(std::string(path.name) + ": DOM + dump", dom, allocationsPerOp(path.dom), dom);
+        printFastRow(std::string(path.name) + ": JsonWriter", fast, allocationsPerOp(path.fast), dom);
+    }
+
+    return 0;
+}
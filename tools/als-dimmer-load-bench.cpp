@@ -0,0 +1,540 @@
+/**
+ * ALS-Dimmer Control-Plane Load Benchmark
+ * Opens N TCP and M Unix socket connections to a running daemon and drives
+ * a weighted mix of set_brightness, adjust_brightness, get_status and
+ * set_absolute_brightness at a target rate. Reports throughput, latency
+ * percentiles per command and per transport, how many writes were
+ * coalesced, and errors by code.
+ *
+ * Meant for a daemon on the `file` sensor and `file` output
+ * (configs/config_simulation.json), so it runs on any Linux box.
+ *
+ * With --rate, every connection follows a fixed schedule and latency is
+ * measured from the time a command was due, not from when it could be sent:
+ * a stalled daemon shows up as latency instead of quietly lowering the rate.
+ *
+ * Usage: als-dimmer-load-bench [OPTIONS]   (see --help)
+ */
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr const char* DEFAULT_IP = "127.0.0.1";
+constexpr int DEFAULT_PORT = 9000;
+constexpr const char* DEFAULT_SOCKET = "/tmp/als-dimmer.sock";
+constexpr int MAX_CONNECTIONS = 1024;
+constexpr int DRAIN_TIMEOUT_MS = 2000;  // Wait for answers after the run
+
+enum Op { SET_BRIGHTNESS, ADJUST_BRIGHTNESS, GET_STATUS, SET_ABSOLUTE_BRIGHTNESS, OP_COUNT };
+
+const char* const OP_NAMES[OP_COUNT] = {
+    "set_brightness", "adjust_brightness", "get_status", "set_absolute_brightness"
+};
+// Short names accepted by --mix
+const char* const OP_KEYS[OP_COUNT] = {"set", "adjust", "status", "absolute"};
+
+struct Options {
+    std::string ip = DEFAULT_IP;
+    int port = DEFAULT_PORT;
+    std::string socket_path = DEFAULT_SOCKET;
+    int tcp_connections = 4;
+    int unix_connections = 4;
+    double rate = 1000.0;      // Commands/s over all connections; 0 = as fast as possible
+    double duration_s = 10.0;
+    int window = 1;            // Requests in flight per connection
+    int weights[OP_COUNT] = {40, 20, 40, 0};
+    unsigned seed = 1;
+};
+
+struct InFlight {
+    Op op;
+    Clock::time_point start;  // When it was due (--rate) or sent
+};
+
+struct Connection {
+    int fd = -1;
+    bool is_unix = false;
+    std::string rx;
+    std::unordered_map<uint64_t, InFlight> in_flight;
+    Clock::time_point next_due;
+};
+
+struct Bucket {
+    uint64_t sent = 0;
+    uint64_t answered = 0;
+    uint64_t errors = 0;
+    uint64_t coalesced = 0;
+    std::vector<double> latency_us;
+};
+
+struct Results {
+    Bucket by_op[OP_COUNT];
+    Bucket by_transport[2];  // TCP, Unix
+    std::map<std::string, uint64_t> error_codes;
+    uint64_t behind_schedule = 0;  // Due before the end but never sent
+    uint64_t unanswered = 0;
+    int dropped = 0;
+};
+
+void printUsage(const char* program_name) {
+    std::cout << "Usage: " << program_name << " [OPTIONS]\n\n"
+              << "Connection Options:\n"
+              << "  --ip=IP              Daemon IP address (default: " << DEFAULT_IP << ")\n"
+              << "  --port=PORT          Daemon port (default: " << DEFAULT_PORT << ")\n"
+              << "  --socket=PATH        Unix socket path (default: " << DEFAULT_SOCKET << ")\n"
+              << "  --tcp=N              TCP connections (default: 4)\n"
+              << "  --unix=N             Unix socket connections (default: 4)\n\n"
+              << "Load Options:\n"
+              << "  --rate=R             Commands/s over all connections, 0 = unthrottled\n"
+              << "                       (default: 1000)\n"
+              << "  --duration=S         Seconds to send for (default: 10)\n"
+              << "  --window=N           Requests in flight per connection (default: 1)\n"
+              << "  --mix=LIST           Weights, e.g. set=40,adjust=20,status=40,absolute=0\n"
+              << "                       (the default). absolute needs a calibrated daemon.\n"
+              << "  --seed=N             Random seed for the mix and values (default: 1)\n\n"
+              << "The daemon accepts at most 32 connections; keep --tcp + --unix below that.\n\n"
+              << "Example:\n"
+              << "  als-dimmer --config configs/config_simulation.json --foreground --log-level warn &\n"
+              << "  " << program_name << " --tcp=8 --unix=8 --rate=5000 --duration=5\n";
+}
+
+std::string argValue(const std::string& arg) {
+    return arg.substr(arg.find('=') + 1);
+}
+
+bool parseMix(const std::string& list, int weights[OP_COUNT]) {
+    std::fill(weights, weights + OP_COUNT, 0);
+    std::istringstream iss(list);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        std::string key = item.substr(0, eq);
+        int op = -1;
+        for (int i = 0; i < OP_COUNT; ++i) {
+            if (key == OP_KEYS[i] || key == OP_NAMES[i]) {
+                op = i;
+            }
+        }
+        int weight = std::atoi(item.c_str() + eq + 1);
+        if (op < 0 || weight < 0) {
+            return false;
+        }
+        weights[op] = weight;
+    }
+    int total = 0;
+    for (int i = 0; i < OP_COUNT; ++i) {
+        total += weights[i];
+    }
+    return total > 0;
+}
+
+bool parseArguments(int argc, char* argv[], Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        try {
+            if (arg.rfind("--ip=", 0) == 0) {
+                opts.ip = argValue(arg);
+            } else if (arg.rfind("--port=", 0) == 0) {
+                opts.port = std::stoi(argValue(arg));
+            } else if (arg.rfind("--socket=", 0) == 0) {
+                opts.socket_path = argValue(arg);
+            } else if (arg.rfind("--tcp=", 0) == 0) {
+                opts.tcp_connections = std::stoi(argValue(arg));
+            } else if (arg.rfind("--unix=", 0) == 0) {
+                opts.unix_connections = std::stoi(argValue(arg));
+            } else if (arg.rfind("--rate=", 0) == 0) {
+                opts.rate = std::stod(argValue(arg));
+            } else if (arg.rfind("--duration=", 0) == 0) {
+                opts.duration_s = std::stod(argValue(arg));
+            } else if (arg.rfind("--window=", 0) == 0) {
+                opts.window = std::stoi(argValue(arg));
+            } else if (arg.rfind("--mix=", 0) == 0) {
+                if (!parseMix(argValue(arg), opts.weights)) {
+                    std::cerr << "Error: --mix wants name=weight pairs (set, adjust, status, "
+                                 "absolute) with at least one weight above 0\n\n";
+                    return false;
+                }
+            } else if (arg.rfind("--seed=", 0) == 0) {
+                opts.seed = static_cast<unsigned>(std::stoul(argValue(arg)));
+            } else {
+                if (arg != "--help" && arg != "-h") {
+                    std::cerr << "Error: Unknown option: " << arg << "\n\n";
+                }
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cerr << "Error: Invalid value in " << arg << "\n\n";
+            return false;
+        }
+    }
+
+    int total = opts.tcp_connections + opts.unix_connections;
+    if (opts.tcp_connections < 0 || opts.unix_connections < 0 || total < 1 || total > MAX_CONNECTIONS) {
+        std::cerr << "Error: Need between 1 and " << MAX_CONNECTIONS << " connections\n\n";
+        return false;
+    }
+    if (opts.rate < 0.0 || opts.duration_s <= 0.0 || opts.window < 1) {
+        std::cerr << "Error: --rate must be >= 0, --duration > 0 and --window >= 1\n\n";
+        return false;
+    }
+    return true;
+}
+
+int connectTcp(const Options& opts) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(opts.port));
+    if (inet_pton(AF_INET, opts.ip.c_str(), &addr.sin_addr) <= 0 ||
+        connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int connectUnix(const Options& opts) {
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    struct sockaddr_un addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, opts.socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+std::string buildRequest(Op op, uint64_t id, std::mt19937& rng) {
+    std::ostringstream oss;
+    oss << "{\"version\":\"1.0\",\"id\":" << id << ",\"command\":\"" << OP_NAMES[op] << "\"";
+    switch (op) {
+        case SET_BRIGHTNESS:
+            oss << ",\"params\":{\"brightness\":" << std::uniform_int_distribution<int>(0, 100)(rng) << "}";
+            break;
+        case ADJUST_BRIGHTNESS: {
+            int delta = std::uniform_int_distribution<int>(1, 5)(rng);
+            oss << ",\"params\":{\"delta\":" << (rng() & 1 ? delta : -delta) << "}";
+            break;
+        }
+        case SET_ABSOLUTE_BRIGHTNESS:
+            oss << ",\"params\":{\"nits\":" << std::uniform_int_distribution<int>(50, 500)(rng) << "}";
+            break;
+        default:
+            break;
+    }
+    oss << "}\n";
+    return oss.str();
+}
+
+// Value of a top-level string field; the daemon's output has no spaces
+std::string stringField(const std::string& msg, const char* key) {
+    std::string search = std::string("\"") + key + "\":\"";
+    size_t pos = msg.find(search);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos += search.size();
+    return msg.substr(pos, msg.find('"', pos) - pos);
+}
+
+// Account for one answer and retire its request
+void record(Results& results, Connection& conn, const std::string& msg, Clock::time_point now) {
+    size_t pos = msg.find("\"id\":");
+    if (pos == std::string::npos) {
+        return;  // Not an answer to one of ours
+    }
+    uint64_t id = std::strtoull(msg.c_str() + pos + 5, nullptr, 10);
+    auto it = conn.in_flight.find(id);
+    if (it == conn.in_flight.end()) {
+        return;
+    }
+
+    double latency_us = std::chrono::duration<double, std::micro>(now - it->second.start).count();
+    bool error = stringField(msg, "status") == "error";
+    bool coalesced = msg.find("\"coalesced\":true") != std::string::npos;
+    if (error) {
+        std::string code = stringField(msg, "error_code");
+        results.error_codes[code.empty() ? "(none)" : code]++;
+    }
+    for (Bucket* b : {&results.by_op[it->second.op], &results.by_transport[conn.is_unix ? 1 : 0]}) {
+        b->answered++;
+        b->errors += error ? 1 : 0;
+        b->coalesced += coalesced ? 1 : 0;
+        b->latency_us.push_back(latency_us);
+    }
+    conn.in_flight.erase(it);
+}
+
+double percentileMs(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    return sorted[rank > 0 ? rank - 1 : 0] / 1000.0;
+}
+
+void printRow(const std::string& name, Bucket& b) {
+    std::sort(b.latency_us.begin(), b.latency_us.end());
+    std::cout << "  " << std::left << std::setw(25) << name << std::right
+              << std::setw(9) << b.sent << std::setw(10) << b.answered
+              << std::setw(8) << b.errors << std::setw(11) << b.coalesced
+              << std::fixed << std::setprecision(3)
+              << std::setw(9) << percentileMs(b.latency_us, 0.50)
+              << std::setw(9) << percentileMs(b.latency_us, 0.99)
+              << std::setw(9) << percentileMs(b.latency_us, 0.999)
+              << std::setw(9) << (b.latency_us.empty() ? 0.0 : b.latency_us.back() / 1000.0) << "\n";
+}
+
+void report(const Options& opts, Results& results, double elapsed_s) {
+    Bucket total;
+    for (const Bucket& b : results.by_op) {
+        total.sent += b.sent;
+        total.answered += b.answered;
+        total.errors += b.errors;
+        total.coalesced += b.coalesced;
+        total.latency_us.insert(total.latency_us.end(), b.latency_us.begin(), b.latency_us.end());
+    }
+
+    std::cout << "\n  " << std::left << std::setw(25) << "Command" << std::right
+              << std::setw(9) << "sent" << std::setw(10) << "answered" << std::setw(8) << "errors"
+              << std::setw(11) << "coalesced" << std::setw(9) << "p50 ms" << std::setw(9) << "p99 ms"
+              << std::setw(9) << "p999 ms" << std::setw(9) << "max ms" << "\n";
+    for (int i = 0; i < OP_COUNT; ++i) {
+        if (opts.weights[i] > 0) {
+            printRow(OP_NAMES[i], results.by_op[i]);
+        }
+    }
+    if (opts.tcp_connections > 0) {
+        printRow("(TCP)", results.by_transport[0]);
+    }
+    if (opts.unix_connections > 0) {
+        printRow("(Unix)", results.by_transport[1]);
+    }
+    printRow("total", total);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "\nThroughput: " << (total.answered / elapsed_s) << " answered/s";
+    if (opts.rate > 0.0) {
+        std::cout << " (target " << opts.rate << ")";
+    }
+    std::cout << "\n";
+
+    uint64_t writes = 0;
+    for (int op : {SET_BRIGHTNESS, ADJUST_BRIGHTNESS, SET_ABSOLUTE_BRIGHTNESS}) {
+        writes += results.by_op[op].answered;
+    }
+    if (writes > 0) {
+        std::cout << "Coalescing: " << total.coalesced << " of " << writes << " writes ("
+                  << (100.0 * static_cast<double>(total.coalesced) / static_cast<double>(writes))
+                  << "%) were superseded by a newer command instead of running\n";
+    }
+
+    std::cout << "Errors: " << total.errors;
+    const char* sep = " (";
+    for (const auto& e : results.error_codes) {
+        std::cout << sep << e.first << " " << e.second;
+        sep = ", ";
+    }
+    std::cout << (results.error_codes.empty() ? "" : ")") << "\n";
+
+    if (results.unanswered > 0 || results.behind_schedule > 0 || results.dropped > 0) {
+        std::cout << "Lost: " << results.unanswered << " unanswered, " << results.behind_schedule
+                  << " never sent (behind schedule), " << results.dropped
+                  << " connections closed by the daemon\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opts;
+    if (!parseArguments(argc, argv, opts)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::vector<Connection> conns(static_cast<size_t>(opts.tcp_connections + opts.unix_connections));
+    for (size_t i = 0; i < conns.size(); ++i) {
+        Connection& conn = conns[i];
+        conn.is_unix = static_cast<int>(i) >= opts.tcp_connections;
+        conn.fd = conn.is_unix ? connectUnix(opts) : connectTcp(opts);
+        if (conn.fd < 0) {
+            std::cerr << "Error: Connection " << i + 1 << " ("
+                      << (conn.is_unix ? opts.socket_path : opts.ip + ":" + std::to_string(opts.port))
+                      << ") failed: " << strerror(errno) << "\n";
+            return 2;
+        }
+    }
+
+    int weight_total = 0;
+    for (int w : opts.weights) {
+        weight_total += w;
+    }
+    std::cout << "Load: " << conns.size() << " connections (" << opts.tcp_connections << " TCP, "
+              << opts.unix_connections << " Unix), window " << opts.window << ", ";
+    if (opts.rate > 0.0) {
+        std::cout << opts.rate << " commands/s";
+    } else {
+        std::cout << "unthrottled";
+    }
+    std::cout << " for " << opts.duration_s << " s\nMix:";
+    for (int i = 0; i < OP_COUNT; ++i) {
+        std::cout << " " << OP_NAMES[i] << " " << (100 * opts.weights[i] / weight_total) << "%";
+    }
+    std::cout << std::endl;
+
+    std::mt19937 rng(opts.seed);
+    std::discrete_distribution<int> pick(opts.weights, opts.weights + OP_COUNT);
+    Results results;
+    uint64_t next_id = 1;
+
+    // Spread the connections' schedules evenly over one interval
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point end = start + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(opts.duration_s));
+    const Clock::duration interval = opts.rate > 0.0
+        ? std::chrono::duration_cast<Clock::duration>(
+              std::chrono::duration<double>(static_cast<double>(conns.size()) / opts.rate))
+        : Clock::duration::zero();
+    for (size_t i = 0; i < conns.size(); ++i) {
+        conns[i].next_due = start + interval * static_cast<int64_t>(i) / static_cast<int64_t>(conns.size());
+    }
+
+    std::vector<struct pollfd> fds(conns.size());
+    char buffer[16384];
+    for (;;) {
+        Clock::time_point now = Clock::now();
+        bool sending = now < end;
+        bool waiting = false;
+        Clock::time_point wake = now + std::chrono::milliseconds(DRAIN_TIMEOUT_MS);
+
+        for (Connection& conn : conns) {
+            if (conn.fd < 0) {
+                continue;
+            }
+            // Send everything due that the window has room for
+            while (sending && conn.next_due <= now &&
+                   static_cast<int>(conn.in_flight.size()) < opts.window) {
+                Op op = static_cast<Op>(pick(rng));
+                uint64_t id = next_id++;
+                std::string request = buildRequest(op, id, rng);
+                if (send(conn.fd, request.data(), request.size(), MSG_NOSIGNAL) !=
+                    static_cast<ssize_t>(request.size())) {
+                    break;  // The read side notices the closed connection
+                }
+                conn.in_flight[id] = InFlight{op, opts.rate > 0.0 ? conn.next_due : now};
+                results.by_op[op].sent++;
+                results.by_transport[conn.is_unix ? 1 : 0].sent++;
+                conn.next_due = opts.rate > 0.0 ? conn.next_due + interval : now;
+            }
+            if (sending && static_cast<int>(conn.in_flight.size()) < opts.window) {
+                wake = std::min(wake, conn.next_due);
+            }
+            waiting = waiting || !conn.in_flight.empty();
+        }
+
+        if (!sending && !waiting) {
+            break;
+        }
+        if (!sending) {
+            wake = std::min(wake, end + std::chrono::milliseconds(DRAIN_TIMEOUT_MS));
+            if (now >= end + std::chrono::milliseconds(DRAIN_TIMEOUT_MS)) {
+                break;
+            }
+        }
+        wake = std::min(wake, std::max(end, now));
+
+        for (size_t i = 0; i < conns.size(); ++i) {
+            fds[i].fd = conns[i].fd;  // Negative fds are ignored
+            fds[i].events = POLLIN;
+            fds[i].revents = 0;
+        }
+        auto wait_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(wake - now).count();
+        struct timespec timeout;
+        timeout.tv_sec = static_cast<time_t>(std::max<int64_t>(wait_ns, 0) / 1000000000);
+        timeout.tv_nsec = static_cast<long>(std::max<int64_t>(wait_ns, 0) % 1000000000);
+        if (ppoll(fds.data(), fds.size(), &timeout, nullptr) < 0 && errno != EINTR) {
+            std::cerr << "Error: poll failed: " << strerror(errno) << "\n";
+            return 3;
+        }
+
+        now = Clock::now();
+        for (size_t i = 0; i < conns.size(); ++i) {
+            Connection& conn = conns[i];
+            if (conn.fd < 0 || (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) == 0) {
+                continue;
+            }
+            ssize_t n = recv(conn.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+            if (n < 0 && (errno == EINTR || errno == EAGAIN)) {
+                continue;
+            }
+            if (n <= 0) {
+                results.unanswered += conn.in_flight.size();
+                results.dropped++;
+                conn.in_flight.clear();
+                close(conn.fd);
+                conn.fd = -1;
+                continue;
+            }
+            conn.rx.append(buffer, static_cast<size_t>(n));
+            size_t pos = 0;
+            size_t nl;
+            while ((nl = conn.rx.find('\n', pos)) != std::string::npos) {
+                std::string msg = conn.rx.substr(pos, nl - pos);
+                record(results, conn, msg, now);
+                pos = nl + 1;
+            }
+            conn.rx.erase(0, pos);
+        }
+    }
+
+    double elapsed_s = std::chrono::duration<double>(std::min(Clock::now(), end) - start).count();
+    for (Connection& conn : conns) {
+        if (conn.fd >= 0) {
+            results.unanswered += conn.in_flight.size();
+            if (opts.rate > 0.0 && conn.next_due < end) {
+                results.behind_schedule += static_cast<uint64_t>((end - conn.next_due) / interval) + 1;
+            }
+            close(conn.fd);
+        }
+    }
+
+    report(opts, results, elapsed_s);
+    return 0;
+}
@@ -0,0 +1,100 @@
+/**
+ * ALS-Dimmer Status Page Reader
+ * Example reader for the shared-memory status page (control.status_page):
+ * maps it and prints snapshots without touching the control socket.
+ *
+ * Usage: als-dimmer-status-reader [--page=PATH] [--watch=MS]
+ */
+
+#include "als-dimmer/status_page.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+constexpr const char* DEFAULT_PAGE = "/dev/shm/als-dimmer-status";
+
+const char* modeName(uint8_t mode) {
+    switch (mode) {
+        case als_dimmer::STATUS_PAGE_MODE_AUTO:
+            return "auto";
+        case als_dimmer::STATUS_PAGE_MODE_MANUAL:
+            return "manual";
+        case als_dimmer::STATUS_PAGE_MODE_MANUAL_TEMPORARY:
+            return "manual_temporary";
+        default:
+            return "unknown";
+    }
+}
+
+uint64_t monotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+void printSnapshot(const als_dimmer::StatusPageData& s) {
+    double age_ms = static_cast<double>(monotonicNs() - s.updated_ns) / 1e6;
+    std::printf("mode=%s brightness=%d lux=%.1f zone=%s sensor=%s", modeName(s.mode),
+                s.brightness, s.lux, s.zone, s.sensor_available ? "available" : "unavailable");
+    if (s.calibrated) {
+        std::printf(" nits=%.1f", s.nits);
+    }
+    if (s.thermal_has_reading) {
+        std::printf(" temp=%.1fC factor=%.3f", s.backlight_temp_c, s.thermal_factor);
+    }
+    std::printf(" age=%.1fms publish=%llu\n", age_ms,
+                static_cast<unsigned long long>(s.publish_count));
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::string path = DEFAULT_PAGE;
+    int watch_ms = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strncmp(argv[i], "--page=", 7) == 0) {
+            path = argv[i] + 7;
+        } else if (std::strncmp(argv[i], "--watch=", 8) == 0) {
+            watch_ms = std::atoi(argv[i] + 8);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--page=PATH] [--watch=MS]\n"
+                      << "  --page=PATH   Status page file (default: " << DEFAULT_PAGE << ")\n"
+                      << "  --watch=MS    Print a snapshot every MS ms whenever it changed\n";
+            return 1;
+        }
+    }
+
+    als_dimmer::StatusPageReader reader;
+    if (!reader.open(path)) {
+        std::cerr << "Error: no status page at " << path
+                  << " (daemon not running, or control.status_page not set)\n";
+        return 2;
+    }
+
+    als_dimmer::StatusPageData snapshot;
+    uint64_t last_count = 0;
+    do {
+        if (!reader.read(snapshot)) {
+            std::cerr << "Error: daemon (pid " << reader.daemonPid() << ") stopped publishing\n";
+            return 3;
+        }
+        if (snapshot.publish_count != last_count) {
+            last_count = snapshot.publish_count;
+            printSnapshot(snapshot);
+        }
+        if (watch_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(watch_ms));
+        }
+    } while (watch_ms > 0);
+
+    return 0;
+}